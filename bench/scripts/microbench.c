@@ -0,0 +1,494 @@
+/* microbench.c
+ * Микробенчмарки горячих циклов заданий: ядро Мандельброта (задание 1),
+ * фазы compute_forces и update_bodies (задание 2), захват и освобождение
+ * my_rwlock (задание 3). Каждое ядро вызывается напрямую, без ввода-вывода
+ * и остальной программы, результаты дописываются в bench/data/microbench.csv.
+ *
+ * Компиляция:
+ *   gcc -fopenmp -O3 -pthread -o bench/scripts/microbench bench/scripts/microbench.c \
+ *       task2/scripts/nbody.c task3/scripts/my_rwlock.c common/trace.c common/env_info.c -lm
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <omp.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+#include "../../task1/scripts/mandelbrot.h"
+#include "../../task2/scripts/nbody.h"
+#include "../../task3/scripts/my_rwlock.h"
+#include "../../common/env_info.h"
+
+/* Параметры по умолчанию */
+#define DEFAULT_SAMPLES 11          /* Замеров на ядро (берётся медиана) */
+#define DEFAULT_SAMPLE_MS 20.0      /* Минимальная длительность одного замера */
+#define DEFAULT_BODIES 2048         /* Тел в ядрах задания 2 */
+#define MAX_ROUNDS 3                /* Повторов серии при большом разбросе */
+#define STABLE_SPREAD_PCT 5.0       /* Разброс (IQR / медиана), при котором серия считается устойчивой */
+#define MANDEL_POINTS 4096          /* Точек в наборах задания 1 */
+#define LOCK_BATCH 1000             /* Захватов на поток за одно повторение */
+
+typedef struct {
+    int max_threads;
+    int samples;
+    double sample_ms;
+    int nbodies;
+    const char *filter;             /* Подстрока имени ядра (NULL - все) */
+} BenchOptions;
+
+/* Повторение ядра: reps раз, число потоков - в контексте */
+typedef void (*BenchRun)(void *ctx, long long reps);
+
+/* --- Часы --- */
+/* Циклы - счётчик TSC (опорная частота, не зависит от турбо-режима);
+ * без TSC циклами считаются наносекунды */
+static inline unsigned long long read_cycles(void) {
+#if HAVE_TSC
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+#endif
+}
+
+/* Частота счётчика циклов, ГГц: сравнение с omp_get_wtime на 100 мс */
+static double calibrate_cycles_ghz(void) {
+    double t0 = omp_get_wtime();
+    unsigned long long c0 = read_cycles();
+    while (omp_get_wtime() - t0 < 0.1) {
+    }
+    double t1 = omp_get_wtime();
+    unsigned long long c1 = read_cycles();
+    return (double)(c1 - c0) / ((t1 - t0) * 1e9);
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* Квантиль отсортированного массива с линейной интерполяцией */
+static double quantile(const double *sorted, int count, double q) {
+    double pos = q * (count - 1);
+    int lo = (int)pos;
+    int hi = (lo + 1 < count) ? lo + 1 : lo;
+    return sorted[lo] + (pos - lo) * (sorted[hi] - sorted[lo]);
+}
+
+/* --- Замер одного ядра ---
+ * 1. Число повторений растёт, пока замер не займёт sample_ms (меньше - шум таймера).
+ * 2. Один замер-прогрев отбрасывается.
+ * 3. Серия из samples замеров; если разброс больше STABLE_SPREAD_PCT,
+ *    серия повторяется (до MAX_ROUNDS раз) и берётся самая устойчивая.
+ * ns_per_op - время на операцию (пропускная способность всех потоков),
+ * cycles_per_op - циклы одного потока на операцию: время * nthreads / ops */
+typedef struct {
+    double median_ns, min_ns, cycles, spread_pct;
+    long long reps;
+    int samples;
+} BenchResult;
+
+static void measure(BenchRun run, void *ctx, double ops_per_rep, int nthreads,
+                    const BenchOptions *opts, BenchResult *res) {
+    long long reps = 1;
+    for (;;) {
+        double t0 = omp_get_wtime();
+        run(ctx, reps);
+        double elapsed = omp_get_wtime() - t0;
+        if (elapsed * 1e3 >= opts->sample_ms || reps >= (1LL << 40)) break;
+        reps *= (elapsed * 1e3 < opts->sample_ms / 8.0) ? 8 : 2;
+    }
+    run(ctx, reps);
+
+    double *ns = (double*)malloc(opts->samples * sizeof(double));
+    double *cyc = (double*)malloc(opts->samples * sizeof(double));
+    res->spread_pct = INFINITY;
+    for (int round = 0; round < MAX_ROUNDS && res->spread_pct > STABLE_SPREAD_PCT; round++) {
+        for (int s = 0; s < opts->samples; s++) {
+            double t0 = omp_get_wtime();
+            unsigned long long c0 = read_cycles();
+            run(ctx, reps);
+            unsigned long long c1 = read_cycles();
+            double t1 = omp_get_wtime();
+            double ops = ops_per_rep * (double)reps;
+            ns[s] = (t1 - t0) * 1e9 / ops;
+            cyc[s] = (double)(c1 - c0) * nthreads / ops;
+        }
+        double *sorted_cyc = (double*)malloc(opts->samples * sizeof(double));
+        memcpy(sorted_cyc, cyc, opts->samples * sizeof(double));
+        qsort(ns, opts->samples, sizeof(double), compare_double);
+        qsort(sorted_cyc, opts->samples, sizeof(double), compare_double);
+
+        double median = quantile(ns, opts->samples, 0.5);
+        double spread = (median > 0.0)
+            ? 100.0 * (quantile(ns, opts->samples, 0.75) - quantile(ns, opts->samples, 0.25)) / median
+            : 0.0;
+        if (spread < res->spread_pct) {
+            res->spread_pct = spread;
+            res->median_ns = median;
+            res->min_ns = ns[0];
+            res->cycles = quantile(sorted_cyc, opts->samples, 0.5);
+        }
+        free(sorted_cyc);
+    }
+    res->reps = reps;
+    res->samples = opts->samples;
+    free(ns);
+    free(cyc);
+}
+
+/* --- Вывод: строка таблицы и строка CSV --- */
+static FILE *csv_out;
+static const EnvInfo *csv_env;
+
+static void report(const char *bench, const char *variant, int nthreads, long long size,
+                   double ops_per_rep, const BenchResult *r, double ghz) {
+    printf("%-22s %-12s %3d %8lld %12.3f %12.2f %7.1f%%\n",
+           bench, variant, nthreads, size, r->median_ns, r->cycles, r->spread_pct);
+    fflush(stdout);
+
+    time_t now = time(NULL);
+    char timestamp[64];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+    fprintf(csv_out, "%s,\"%s\",%s,%s,%d,%lld,%.0f,%d,%.4f,%.4f,%.3f,%.2f,%.4f,",
+            timestamp, csv_env->cpu_model, bench, variant, nthreads, size, ops_per_rep * (double)r->reps,
+            r->samples, r->median_ns, r->min_ns, r->cycles, r->spread_pct, ghz);
+    env_csv_write(csv_out, csv_env);
+    fputc('\n', csv_out);
+    fflush(csv_out);
+}
+
+static int selected(const BenchOptions *opts, const char *bench) {
+    return !opts->filter || strstr(bench, opts->filter) != NULL;
+}
+
+/* Число потоков в серии: 1, 2, 4, ... и max_threads */
+static int next_threads(int t, int max_threads) {
+    if (t >= max_threads) return 0;
+    return (2 * t < max_threads) ? 2 * t : max_threads;
+}
+
+/* Детерминированный генератор (как в задании 3), воспроизводимые наборы данных */
+static double lcg_uniform(unsigned *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return (double)((*seed / 65536u) % 32768u) / 32768.0;
+}
+
+/* --- Задание 1: ядро Мандельброта --- */
+typedef struct {
+    const double *re, *im;
+    int npoints;
+} MandelCtx;
+
+static volatile long long mandel_sink;
+
+static void run_is_in_mandelbrot(void *p, long long reps) {
+    MandelCtx *c = (MandelCtx*)p;
+    long long inside = 0;
+    for (long long r = 0; r < reps; r++) {
+        for (int k = 0; k < c->npoints; k++) inside += is_in_mandelbrot(c->re[k], c->im[k]);
+    }
+    mandel_sink = inside;
+}
+
+static void bench_mandelbrot(const BenchOptions *opts, double ghz) {
+    int want_iter = selected(opts, "mandelbrot_iteration");
+    int want_point = selected(opts, "is_in_mandelbrot");
+    if (!want_iter && !want_point) return;
+
+    /* Наборы точек: равномерный по области задания 1, его внутренние и внешние точки */
+    double *re = (double*)malloc(3 * MANDEL_POINTS * sizeof(double));
+    double *im = (double*)malloc(3 * MANDEL_POINTS * sizeof(double));
+    int count[3] = {0, 0, 0};
+    long long iters[3] = {0, 0, 0};
+    unsigned seed = 12345u;
+    while (count[0] < MANDEL_POINTS || count[1] < MANDEL_POINTS || count[2] < MANDEL_POINTS) {
+        double x = REAL_MIN + (REAL_MAX - REAL_MIN) * lcg_uniform(&seed);
+        double y = IMAG_MIN + (IMAG_MAX - IMAG_MIN) * lcg_uniform(&seed);
+        int it = mandelbrot_iterations(x, y);
+        int sets[2] = {0, it == MAX_ITERATIONS ? 1 : 2};
+        for (int k = 0; k < 2; k++) {
+            int s = sets[k];
+            if (count[s] < MANDEL_POINTS) {
+                re[s * MANDEL_POINTS + count[s]] = x;
+                im[s * MANDEL_POINTS + count[s]] = y;
+                iters[s] += it;
+                count[s]++;
+            }
+        }
+    }
+
+    const char *names[3] = {"uniform", "interior", "exterior"};
+    BenchResult r;
+    /* Внутренние точки проходят все MAX_ITERATIONS итераций: цена одной итерации */
+    if (want_iter) {
+        MandelCtx c = {re + MANDEL_POINTS, im + MANDEL_POINTS, MANDEL_POINTS / 16};
+        double ops = (double)c.npoints * MAX_ITERATIONS;
+        measure(run_is_in_mandelbrot, &c, ops, 1, opts, &r);
+        report("mandelbrot_iteration", "interior", 1, c.npoints, ops, &r, ghz);
+    }
+    if (want_point) {
+        for (int s = 0; s < 3; s++) {
+            MandelCtx c = {re + s * MANDEL_POINTS, im + s * MANDEL_POINTS, MANDEL_POINTS};
+            measure(run_is_in_mandelbrot, &c, MANDEL_POINTS, 1, opts, &r);
+            report("is_in_mandelbrot", names[s], 1, MANDEL_POINTS, MANDEL_POINTS, &r, ghz);
+        }
+        printf("%-22s mean iterations per point: uniform %.1f, interior %.1f, exterior %.1f\n", "",
+               (double)iters[0] / MANDEL_POINTS, (double)iters[1] / MANDEL_POINTS,
+               (double)iters[2] / MANDEL_POINTS);
+    }
+    free(re);
+    free(im);
+}
+
+/* --- Задание 2: фазы compute_forces и update_bodies --- */
+typedef struct {
+    Body *bodies;
+    int n, nthreads;
+    double *fx, *fy, *fz;
+    double *fx_all, *fy_all, *fz_all;
+} ForceCtx;
+
+/* Одна параллельная область на все повторения: замеряется фаза с барьером после неё,
+ * как в compute_forces (цикл пар - nowait), без fork/join */
+static void run_force_pairs(void *p, long long reps) {
+    ForceCtx *c = (ForceCtx*)p;
+    size_t per_thread = (size_t)c->n;
+    #pragma omp parallel num_threads(c->nthreads)
+    {
+        int tid = omp_get_thread_num();
+        for (long long r = 0; r < reps; r++) {
+            compute_forces_pairs(c->bodies, c->n, c->fx_all + tid * per_thread,
+                                 c->fy_all + tid * per_thread, c->fz_all + tid * per_thread);
+            #pragma omp barrier
+        }
+    }
+}
+
+static void run_force_reduce(void *p, long long reps) {
+    ForceCtx *c = (ForceCtx*)p;
+    #pragma omp parallel num_threads(c->nthreads)
+    {
+        int nt = omp_get_num_threads();
+        for (long long r = 0; r < reps; r++) {
+            compute_forces_reduce(c->n, nt, c->fx, c->fy, c->fz, c->fx_all, c->fy_all, c->fz_all);
+        }
+    }
+}
+
+/* update_bodies открывает свою параллельную область: время включает её запуск */
+static void run_update_bodies(void *p, long long reps) {
+    ForceCtx *c = (ForceCtx*)p;
+    omp_set_num_threads(c->nthreads);
+    for (long long r = 0; r < reps; r++) {
+        update_bodies(c->bodies, c->n, c->fx, c->fy, c->fz, 1e-9);
+    }
+}
+
+static void bench_nbody(const BenchOptions *opts, double ghz) {
+    int want_pairs = selected(opts, "forces_pairs");
+    int want_reduce = selected(opts, "forces_reduce");
+    int want_update = selected(opts, "update_bodies");
+    if (!want_pairs && !want_reduce && !want_update) return;
+
+    int n = opts->nbodies;
+    size_t stride = (size_t)opts->max_threads * n;
+    ForceCtx c;
+    c.n = n;
+    c.bodies = (Body*)malloc(n * sizeof(Body));
+    c.fx = (double*)calloc(3 * (size_t)n, sizeof(double));
+    c.fx_all = (double*)calloc(3 * stride, sizeof(double));
+    if (!c.bodies || !c.fx || !c.fx_all) {
+        fprintf(stderr, "Error: Failed to allocate benchmark bodies (n=%d)\n", n);
+        free(c.bodies); free(c.fx); free(c.fx_all);
+        return;
+    }
+    c.fy = c.fx + n;
+    c.fz = c.fy + n;
+    c.fy_all = c.fx_all + stride;
+    c.fz_all = c.fy_all + stride;
+
+    /* Однородный куб со стороной 1e11 м, массы порядка планетных */
+    unsigned seed = 42u;
+    for (int i = 0; i < n; i++) {
+        c.bodies[i].x = 1e11 * lcg_uniform(&seed);
+        c.bodies[i].y = 1e11 * lcg_uniform(&seed);
+        c.bodies[i].z = 1e11 * lcg_uniform(&seed);
+        c.bodies[i].vx = 1e3 * (lcg_uniform(&seed) - 0.5);
+        c.bodies[i].vy = 1e3 * (lcg_uniform(&seed) - 0.5);
+        c.bodies[i].vz = 1e3 * (lcg_uniform(&seed) - 0.5);
+        c.bodies[i].mass = 1e24 * (1.0 + lcg_uniform(&seed));
+    }
+
+    BenchResult r;
+    for (int t = 1; t > 0; t = next_threads(t, opts->max_threads)) {
+        c.nthreads = t;
+        if (want_pairs) {
+            double ops = 0.5 * (double)n * (n - 1);
+            measure(run_force_pairs, &c, ops, t, opts, &r);
+            report("forces_pairs", "pair", t, n, ops, &r, ghz);
+        }
+        if (want_reduce) {
+            double ops = (double)n * t;
+            measure(run_force_reduce, &c, ops, t, opts, &r);
+            report("forces_reduce", "element", t, n, ops, &r, ghz);
+        }
+        if (want_update) {
+            measure(run_update_bodies, &c, n, t, opts, &r);
+            report("update_bodies", "body", t, n, n, &r, ghz);
+        }
+    }
+    omp_set_num_threads(opts->max_threads);
+
+    free(c.bodies);
+    free(c.fx);
+    free(c.fx_all);
+}
+
+/* --- Задание 3: захват и освобождение my_rwlock --- */
+typedef struct {
+    my_rwlock_t lock;
+    int nthreads;
+    int write;
+    volatile long long shared;      /* Данные под блокировкой: критическая секция не пуста */
+} LockCtx;
+
+static void run_rwlock(void *p, long long reps) {
+    LockCtx *c = (LockCtx*)p;
+    long long iterations = reps * LOCK_BATCH;
+    #pragma omp parallel num_threads(c->nthreads)
+    {
+        long long local = 0;
+        for (long long k = 0; k < iterations; k++) {
+            if (c->write) {
+                my_rwlock_wrlock(&c->lock);
+                c->shared++;
+            } else {
+                my_rwlock_rdlock(&c->lock);
+                local += c->shared;
+            }
+            my_rwlock_unlock(&c->lock);
+        }
+        if (local < 0) c->shared = local;
+    }
+}
+
+static void bench_rwlock(const BenchOptions *opts, double ghz) {
+    const char *names[2] = {"rwlock_read", "rwlock_write"};
+    BenchResult r;
+    for (int w = 0; w < 2; w++) {
+        if (!selected(opts, names[w])) continue;
+        for (int t = 1; t > 0; t = next_threads(t, opts->max_threads)) {
+            LockCtx c;
+            my_rwlock_init(&c.lock);
+            c.nthreads = t;
+            c.write = w;
+            c.shared = 0;
+            double ops = (double)t * LOCK_BATCH;
+            measure(run_rwlock, &c, ops, t, opts, &r);
+            report(names[w], "lock+unlock", t, LOCK_BATCH, ops, &r, ghz);
+            my_rwlock_destroy(&c.lock);
+        }
+    }
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s <max_threads> [options]\n", prog);
+    fprintf(stderr, "  max_threads: thread counts 1, 2, 4, ... up to this value\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --filter <name>      run only kernels whose name contains this string\n");
+    fprintf(stderr, "  --samples <K>        timed samples per kernel (default: %d)\n", DEFAULT_SAMPLES);
+    fprintf(stderr, "  --sample-ms <ms>     minimal duration of one sample (default: %g)\n", DEFAULT_SAMPLE_MS);
+    fprintf(stderr, "  --bodies <N>         bodies in the task2 kernels (default: %d)\n", DEFAULT_BODIES);
+    fprintf(stderr, "Kernels: mandelbrot_iteration, is_in_mandelbrot, forces_pairs, forces_reduce,\n");
+    fprintf(stderr, "         update_bodies, rwlock_read, rwlock_write\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    BenchOptions opts;
+    opts.max_threads = atoi(argv[1]);
+    opts.samples = DEFAULT_SAMPLES;
+    opts.sample_ms = DEFAULT_SAMPLE_MS;
+    opts.nbodies = DEFAULT_BODIES;
+    opts.filter = NULL;
+
+    for (int a = 2; a < argc; a++) {
+        if (a + 1 >= argc) {
+            fprintf(stderr, "Error: option %s requires a value\n", argv[a]);
+            return 1;
+        }
+        if (strcmp(argv[a], "--filter") == 0) {
+            opts.filter = argv[++a];
+        } else if (strcmp(argv[a], "--samples") == 0) {
+            opts.samples = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--sample-ms") == 0) {
+            opts.sample_ms = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--bodies") == 0) {
+            opts.nbodies = atoi(argv[++a]);
+        } else {
+            fprintf(stderr, "Error: unknown option %s\n", argv[a]);
+            return 1;
+        }
+    }
+    if (opts.max_threads <= 0) {
+        fprintf(stderr, "Error: max_threads must be positive, got %s\n", argv[1]);
+        return 1;
+    }
+    if (opts.samples < 3) {
+        fprintf(stderr, "Error: at least 3 samples are required, got %d\n", opts.samples);
+        return 1;
+    }
+    if (opts.sample_ms <= 0.0 || opts.nbodies < 2) {
+        fprintf(stderr, "Error: sample duration must be positive and bodies at least 2\n");
+        return 1;
+    }
+    omp_set_num_threads(opts.max_threads);
+
+    EnvInfo env;
+    env_capture(&env);
+    csv_env = &env;
+    double ghz = calibrate_cycles_ghz();
+
+    const char *csv_dir = "./bench/data";
+    env_ensure_dir(csv_dir);
+    char fname[512];
+    snprintf(fname, sizeof(fname), "%s/microbench.csv", csv_dir);
+    csv_out = env_csv_append(fname, "timestamp,cpu_model,benchmark,variant,nthreads,size,ops_per_sample,samples,"
+                             "median_ns_per_op,min_ns_per_op,cycles_per_op,spread_pct,cycles_ghz," ENV_CSV_HEADER);
+    if (!csv_out) {
+        fprintf(stderr, "Cannot open %s for writing\n", fname);
+        return 1;
+    }
+
+    printf("=== Kernel Microbenchmarks ===\n");
+    printf("CPU: %s\n", env.cpu_model);
+    env_print(&env);
+    printf("Cycle counter: %s, %.3f GHz\n", HAVE_TSC ? "TSC" : "nanoseconds", ghz);
+    printf("Samples: %d x >= %.0f ms (median, spread = IQR / median)\n", opts.samples, opts.sample_ms);
+    printf("==============================\n\n");
+    printf("%-22s %-12s %3s %8s %12s %12s %8s\n",
+           "kernel", "variant", "thr", "size", "ns/op", "cycles/op", "spread");
+
+    bench_mandelbrot(&opts, ghz);
+    bench_nbody(&opts, ghz);
+    bench_rwlock(&opts, ghz);
+
+    fclose(csv_out);
+    printf("\nResults appended to %s\n", fname);
+    return 0;
+}
@@ -0,0 +1,348 @@
+/* regress.c
+ * Сравнение прогона набора бенчмарков с базовым (baseline).
+ * Оба прогона - файлы bench/data/regression/<run_id>.csv, которые пишет
+ * run_regression.sh: по строке на замер времени одного случая набора.
+ * Для каждого случая (suite, case, threads) средние сравниваются t-критерием
+ * Уэлча; регрессия - замедление больше порога при значимом p-value.
+ * Отчёт пишется в CSV, код возврата 2 означает найденные регрессии.
+ *
+ * Компиляция:
+ *   gcc -O3 -o bench/scripts/regress bench/scripts/regress.c -lm
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define DEFAULT_THRESHOLD_PCT 5.0   /* Минимальное замедление, считающееся регрессией */
+#define DEFAULT_ALPHA 0.01          /* Уровень значимости */
+#define BETACF_ITERATIONS 200
+#define BETACF_EPS 1e-14
+
+/* Замеры одного случая набора в одном прогоне */
+typedef struct {
+    char suite[32];
+    char name[128];
+    int threads;
+    double *times;
+    int n, capacity;
+} BenchCase;
+
+typedef struct {
+    char run_id[64];
+    char fingerprint[64];
+    BenchCase *cases;
+    int ncases, capacity;
+} BenchRun;
+
+/* --- Чтение прогона --- */
+static BenchCase *find_case(BenchRun *r, const char *suite, const char *name, int threads) {
+    for (int c = 0; c < r->ncases; c++) {
+        BenchCase *bc = &r->cases[c];
+        if (bc->threads == threads && strcmp(bc->suite, suite) == 0 && strcmp(bc->name, name) == 0) {
+            return bc;
+        }
+    }
+    return NULL;
+}
+
+static int add_sample(BenchRun *r, const char *suite, const char *name, int threads, double time) {
+    BenchCase *bc = find_case(r, suite, name, threads);
+    if (!bc) {
+        if (r->ncases == r->capacity) {
+            int cap = r->capacity ? 2 * r->capacity : 32;
+            BenchCase *grown = (BenchCase*)realloc(r->cases, cap * sizeof(BenchCase));
+            if (!grown) return 0;
+            r->cases = grown;
+            r->capacity = cap;
+        }
+        bc = &r->cases[r->ncases++];
+        memset(bc, 0, sizeof(*bc));
+        snprintf(bc->suite, sizeof(bc->suite), "%s", suite);
+        snprintf(bc->name, sizeof(bc->name), "%s", name);
+        bc->threads = threads;
+    }
+    if (bc->n == bc->capacity) {
+        int cap = bc->capacity ? 2 * bc->capacity : 8;
+        double *grown = (double*)realloc(bc->times, cap * sizeof(double));
+        if (!grown) return 0;
+        bc->times = grown;
+        bc->capacity = cap;
+    }
+    bc->times[bc->n++] = time;
+    return 1;
+}
+
+/* Формат строки: run_id,timestamp,fingerprint,suite,case,threads,sample,time.
+ * Возвращает 0 при ошибке */
+static int load_run(const char *path, BenchRun *r) {
+    memset(r, 0, sizeof(*r));
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Error: Cannot open %s\n", path);
+        return 0;
+    }
+    char line[512];
+    int lineno = 0, samples = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        if (lineno == 1 && strncmp(line, "run_id,", 7) == 0) continue;
+        char run_id[64], timestamp[32], fingerprint[64], suite[32], name[128];
+        int threads, sample;
+        double time;
+        if (sscanf(line, "%63[^,],%31[^,],%63[^,],%31[^,],%127[^,],%d,%d,%lf",
+                   run_id, timestamp, fingerprint, suite, name, &threads, &sample, &time) != 8) {
+            fprintf(stderr, "Error: %s:%d: malformed line\n", path, lineno);
+            fclose(f);
+            return 0;
+        }
+        if (samples == 0) {
+            snprintf(r->run_id, sizeof(r->run_id), "%s", run_id);
+            snprintf(r->fingerprint, sizeof(r->fingerprint), "%s", fingerprint);
+        }
+        if (!add_sample(r, suite, name, threads, time)) {
+            fprintf(stderr, "Error: Out of memory reading %s\n", path);
+            fclose(f);
+            return 0;
+        }
+        samples++;
+    }
+    fclose(f);
+    if (samples == 0) {
+        fprintf(stderr, "Error: %s contains no samples\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+static void free_run(BenchRun *r) {
+    for (int c = 0; c < r->ncases; c++) free(r->cases[c].times);
+    free(r->cases);
+    memset(r, 0, sizeof(*r));
+}
+
+/* --- Статистика --- */
+static void mean_var(const double *x, int n, double *mean, double *var) {
+    double s = 0.0;
+    for (int i = 0; i < n; i++) s += x[i];
+    *mean = s / n;
+    double ss = 0.0;
+    for (int i = 0; i < n; i++) ss += (x[i] - *mean) * (x[i] - *mean);
+    *var = n > 1 ? ss / (n - 1) : 0.0;
+}
+
+/* Цепная дробь неполной бета-функции (метод Ленца) */
+static double betacf(double a, double b, double x) {
+    const double tiny = 1e-300;
+    double qab = a + b, qap = a + 1.0, qam = a - 1.0;
+    double c = 1.0, d = 1.0 - qab * x / qap;
+    if (fabs(d) < tiny) d = tiny;
+    d = 1.0 / d;
+    double h = d;
+    for (int m = 1; m <= BETACF_ITERATIONS; m++) {
+        int m2 = 2 * m;
+        double aa = m * (b - m) * x / ((qam + m2) * (a + m2));
+        d = 1.0 + aa * d;
+        if (fabs(d) < tiny) d = tiny;
+        c = 1.0 + aa / c;
+        if (fabs(c) < tiny) c = tiny;
+        d = 1.0 / d;
+        h *= d * c;
+        aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2));
+        d = 1.0 + aa * d;
+        if (fabs(d) < tiny) d = tiny;
+        c = 1.0 + aa / c;
+        if (fabs(c) < tiny) c = tiny;
+        d = 1.0 / d;
+        double del = d * c;
+        h *= del;
+        if (fabs(del - 1.0) < BETACF_EPS) break;
+    }
+    return h;
+}
+
+/* Регуляризованная неполная бета-функция I_x(a, b) */
+static double incomplete_beta(double a, double b, double x) {
+    if (x <= 0.0) return 0.0;
+    if (x >= 1.0) return 1.0;
+    double lbt = lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log(1.0 - x);
+    if (x < (a + 1.0) / (a + b + 2.0)) {
+        return exp(lbt) * betacf(a, b, x) / a;
+    }
+    return 1.0 - exp(lbt) * betacf(b, a, 1.0 - x) / b;
+}
+
+/* --- t-критерий Уэлча ---
+ * Двусторонний p-value для разности средних при неравных дисперсиях;
+ * степени свободы по Уэлчу-Саттертуэйту. Возвращает 0, если критерий неприменим */
+typedef struct {
+    double base_mean, base_std;
+    double cur_mean, cur_std;
+    double change_pct;          /* (cur - base) / base, %: больше нуля - медленнее */
+    double t, df, p;
+} Comparison;
+
+static int welch_test(const BenchCase *base, const BenchCase *cur, Comparison *cmp) {
+    double bv, cv;
+    mean_var(base->times, base->n, &cmp->base_mean, &bv);
+    mean_var(cur->times, cur->n, &cmp->cur_mean, &cv);
+    cmp->base_std = sqrt(bv);
+    cmp->cur_std = sqrt(cv);
+    cmp->change_pct = cmp->base_mean > 0.0 ? 100.0 * (cmp->cur_mean - cmp->base_mean) / cmp->base_mean : 0.0;
+    cmp->t = NAN;
+    cmp->df = NAN;
+    cmp->p = NAN;
+    if (base->n < 2 || cur->n < 2) return 0;
+
+    double sb = bv / base->n, sc = cv / cur->n;
+    double se2 = sb + sc;
+    if (se2 <= 0.0) {
+        /* Оба набора без разброса: различие либо точное, либо его нет */
+        cmp->t = (cmp->cur_mean == cmp->base_mean) ? 0.0 : copysign(INFINITY, cmp->cur_mean - cmp->base_mean);
+        cmp->df = base->n + cur->n - 2;
+        cmp->p = (cmp->cur_mean == cmp->base_mean) ? 1.0 : 0.0;
+        return 1;
+    }
+    cmp->t = (cmp->cur_mean - cmp->base_mean) / sqrt(se2);
+    cmp->df = se2 * se2 / (sb * sb / (base->n - 1) + sc * sc / (cur->n - 1));
+    cmp->p = incomplete_beta(0.5 * cmp->df, 0.5, cmp->df / (cmp->df + cmp->t * cmp->t));
+    return 1;
+}
+
+/* Статус случая по порогу и уровню значимости */
+static const char *classify(const Comparison *cmp, int tested, double threshold_pct, double alpha) {
+    if (!tested) return "no_test";
+    if (cmp->p < alpha && cmp->change_pct > threshold_pct) return "regression";
+    if (cmp->p < alpha && cmp->change_pct < -threshold_pct) return "improvement";
+    return "unchanged";
+}
+
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s <baseline.csv> <current.csv> [options]\n", prog);
+    fprintf(stderr, "  baseline.csv, current.csv: runs written by bench/scripts/run_regression.sh\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --threshold <pct>   smallest slowdown reported as a regression (default: %.1f)\n",
+            DEFAULT_THRESHOLD_PCT);
+    fprintf(stderr, "  --alpha <p>         significance level of the Welch t-test (default: %.2f)\n", DEFAULT_ALPHA);
+    fprintf(stderr, "  --report <file>     machine-readable CSV report (default: stdout table only)\n");
+    fprintf(stderr, "Exit status: 0 - no regressions, 2 - regressions found, 1 - error\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *paths[2];
+    int npaths = 0;
+    double threshold_pct = DEFAULT_THRESHOLD_PCT;
+    double alpha = DEFAULT_ALPHA;
+    const char *report_path = NULL;
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--threshold") == 0 && a + 1 < argc) {
+            threshold_pct = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--alpha") == 0 && a + 1 < argc) {
+            alpha = atof(argv[++a]);
+            if (alpha <= 0.0 || alpha >= 1.0) {
+                fprintf(stderr, "Error: alpha must be in (0, 1), got %s\n", argv[a]);
+                return 1;
+            }
+        } else if (strcmp(argv[a], "--report") == 0 && a + 1 < argc) {
+            report_path = argv[++a];
+        } else if (strncmp(argv[a], "--", 2) != 0 && npaths < 2) {
+            paths[npaths++] = argv[a];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (npaths != 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    BenchRun base, cur;
+    if (!load_run(paths[0], &base)) return 1;
+    if (!load_run(paths[1], &cur)) {
+        free_run(&base);
+        return 1;
+    }
+
+    printf("=== Benchmark Regression Check ===\n");
+    printf("Baseline:  %s (%s)\n", base.run_id, base.fingerprint);
+    printf("Current:   %s (%s)\n", cur.run_id, cur.fingerprint);
+    printf("Threshold: %.1f%% slowdown at p < %.3g (Welch t-test)\n", threshold_pct, alpha);
+    if (strcmp(base.fingerprint, cur.fingerprint) != 0) {
+        printf("Warning: environment fingerprints differ, timings may not be comparable\n");
+    }
+    printf("\n%-8s %-28s %4s %12s %12s %9s %10s  %s\n",
+           "suite", "case", "thr", "base, s", "current, s", "change", "p-value", "status");
+
+    FILE *report = NULL;
+    if (report_path) {
+        report = fopen(report_path, "w");
+        if (!report) {
+            fprintf(stderr, "Error: Cannot open %s for writing\n", report_path);
+            free_run(&base);
+            free_run(&cur);
+            return 1;
+        }
+        fprintf(report, "baseline_run,current_run,baseline_fingerprint,current_fingerprint,suite,case,threads,"
+                        "baseline_n,baseline_mean,baseline_std,current_n,current_mean,current_std,"
+                        "change_pct,t,df,p_value,threshold_pct,alpha,status\n");
+    }
+
+    int regressions = 0, improvements = 0, untested = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        /* Проход 0 - случаи текущего прогона, проход 1 - случаи, пропавшие из него */
+        BenchRun *r = pass == 0 ? &cur : &base;
+        for (int c = 0; c < r->ncases; c++) {
+            BenchCase *bc = &r->cases[c];
+            BenchCase *b = pass == 0 ? find_case(&base, bc->suite, bc->name, bc->threads) : bc;
+            BenchCase *k = pass == 0 ? bc : find_case(&cur, bc->suite, bc->name, bc->threads);
+            if (pass == 1 && k) continue;
+
+            Comparison cmp;
+            memset(&cmp, 0, sizeof(cmp));
+            cmp.t = cmp.df = cmp.p = cmp.change_pct = NAN;
+            const char *status;
+            if (!b) {
+                status = "new";
+                mean_var(k->times, k->n, &cmp.cur_mean, &cmp.cur_std);
+                cmp.cur_std = sqrt(cmp.cur_std);
+            } else if (!k) {
+                status = "missing";
+                mean_var(b->times, b->n, &cmp.base_mean, &cmp.base_std);
+                cmp.base_std = sqrt(cmp.base_std);
+            } else {
+                int tested = welch_test(b, k, &cmp);
+                status = classify(&cmp, tested, threshold_pct, alpha);
+            }
+            regressions += strcmp(status, "regression") == 0;
+            improvements += strcmp(status, "improvement") == 0;
+            untested += strcmp(status, "no_test") == 0;
+
+            printf("%-8s %-28s %4d %12.6f %12.6f %8.2f%% %10.3g  %s\n",
+                   bc->suite, bc->name, bc->threads, cmp.base_mean, cmp.cur_mean,
+                   cmp.change_pct, cmp.p, status);
+            if (report) {
+                fprintf(report, "%s,%s,%s,%s,%s,%s,%d,%d,%.6f,%.6f,%d,%.6f,%.6f,%.3f,%.4f,%.2f,%.6g,%.2f,%.4g,%s\n",
+                        base.run_id, cur.run_id, base.fingerprint, cur.fingerprint,
+                        bc->suite, bc->name, bc->threads,
+                        b ? b->n : 0, cmp.base_mean, cmp.base_std,
+                        k ? k->n : 0, cmp.cur_mean, cmp.cur_std,
+                        cmp.change_pct, cmp.t, cmp.df, cmp.p, threshold_pct, alpha, status);
+            }
+        }
+    }
+
+    printf("\nRegressions: %d, improvements: %d, untested (fewer than 2 samples): %d\n",
+           regressions, improvements, untested);
+    printf("==================================\n");
+    if (report) {
+        fclose(report);
+        printf("Report written to %s\n", report_path);
+    }
+
+    free_run(&base);
+    free_run(&cur);
+    return regressions > 0 ? 2 : 0;
+}
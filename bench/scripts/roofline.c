@@ -0,0 +1,360 @@
+/* roofline.c
+ * Характеристика машины для модели roofline: пик FMA и пропускная способность
+ * памяти для чисел потоков 1, 2, 4, ... max_threads.
+ *   - пик FMA: независимые цепочки acc = acc * m + a в регистрах - скалярные
+ *     (без векторизации и без FMA, SSE2), AVX2+FMA (4 double) и AVX-512 (8 double);
+ *     векторные ядра запускаются, только если процессор их поддерживает
+ *   - полоса: триада a[i] = b[i] + s * c[i] (как в STREAM, 24 байта на элемент,
+ *     запись с выделением строки кэша не считается) с рабочим набором на поток
+ *     в половину L1d, в половину L2, с долей половины L3 и в памяти (не меньше 4 * L3)
+ * Берётся лучший из замеров. Результат перезаписывает bench/data/roofline.csv:
+ * задания читают его и помещают свои ядра на roofline (common/roofline.c).
+ *
+ * Компиляция:
+ *   gcc -fopenmp -O3 -o bench/scripts/roofline bench/scripts/roofline.c common/env_info.c common/roofline.c -lm
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <omp.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#else
+#define HAVE_X86_SIMD 0
+#endif
+
+#include "../../common/env_info.h"
+#include "../../common/roofline.h"
+
+/* Параметры по умолчанию */
+#define DEFAULT_SAMPLES 5           /* Замеров на точку (берётся лучший) */
+#define DEFAULT_SAMPLE_MS 50.0      /* Минимальная длительность одного замера */
+#define FMA_CHAINS 12               /* Независимых цепочек: задержка FMA (4-5 тактов) * 2 конвейера */
+#define FMA_BLOCK 1024              /* Начальное число итераций при подборе длительности замера */
+#define DRAM_MIN_BYTES (256LL << 20)    /* Наименьший общий рабочий набор для памяти */
+
+typedef struct {
+    int max_threads;
+    int samples;
+    double sample_ms;
+} RooflineOptions;
+
+/* Следующее число потоков: степени двойки и максимум */
+static int next_threads(int t, int max_threads) {
+    if (t >= max_threads) return 0;
+    return (t * 2 < max_threads) ? t * 2 : max_threads;
+}
+
+/* --- Размеры кэшей из sysfs --- */
+/* Размер "48K", "2048K", "32M" в байтах */
+static long long parse_size(const char *text) {
+    char *end;
+    long long value = strtoll(text, &end, 10);
+    if (*end == 'K') value <<= 10;
+    else if (*end == 'M') value <<= 20;
+    return value;
+}
+
+/* Данные или общий кэш уровня level первого процессора; 0, если неизвестен */
+static long long cache_size(int level) {
+    for (int index = 0; index < 16; index++) {
+        char path[128], text[32];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", index);
+        FILE *f = fopen(path, "r");
+        if (!f) break;
+        int found_level = 0;
+        if (fscanf(f, "%d", &found_level) != 1) found_level = 0;
+        fclose(f);
+        if (found_level != level) continue;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", index);
+        f = fopen(path, "r");
+        if (!f) continue;
+        int ok = fscanf(f, "%31s", text) == 1 && strcmp(text, "Instruction") != 0;
+        fclose(f);
+        if (!ok) continue;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+        f = fopen(path, "r");
+        if (!f) continue;
+        ok = fscanf(f, "%31s", text) == 1;
+        fclose(f);
+        if (ok) return parse_size(text);
+    }
+    return 0;
+}
+
+/* --- Ядра пика FMA ---
+ * Каждое возвращает сумму цепочек, чтобы компилятор не удалил вычисления;
+ * acc сходится к a / (1 - m), денормализованных чисел не возникает */
+__attribute__((optimize("no-tree-vectorize")))
+static double fma_scalar(long long iters) {
+    double acc[FMA_CHAINS];
+    for (int c = 0; c < FMA_CHAINS; c++) acc[c] = c * 1e-3;
+    const double m = 0.999999, a = 1e-7;
+    for (long long it = 0; it < iters; it++) {
+        for (int c = 0; c < FMA_CHAINS; c++) acc[c] = acc[c] * m + a;
+    }
+    double sum = 0.0;
+    for (int c = 0; c < FMA_CHAINS; c++) sum += acc[c];
+    return sum;
+}
+
+#if HAVE_X86_SIMD
+__attribute__((target("avx2,fma")))
+static double fma_avx2(long long iters) {
+    __m256d acc[FMA_CHAINS];
+    for (int c = 0; c < FMA_CHAINS; c++) acc[c] = _mm256_set1_pd(c * 1e-3);
+    const __m256d m = _mm256_set1_pd(0.999999), a = _mm256_set1_pd(1e-7);
+    for (long long it = 0; it < iters; it++) {
+        for (int c = 0; c < FMA_CHAINS; c++) acc[c] = _mm256_fmadd_pd(acc[c], m, a);
+    }
+    double lanes[4], sum = 0.0;
+    for (int c = 0; c < FMA_CHAINS; c++) {
+        _mm256_storeu_pd(lanes, acc[c]);
+        sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    return sum;
+}
+
+__attribute__((target("avx512f")))
+static double fma_avx512(long long iters) {
+    __m512d acc[FMA_CHAINS];
+    for (int c = 0; c < FMA_CHAINS; c++) acc[c] = _mm512_set1_pd(c * 1e-3);
+    const __m512d m = _mm512_set1_pd(0.999999), a = _mm512_set1_pd(1e-7);
+    for (long long it = 0; it < iters; it++) {
+        for (int c = 0; c < FMA_CHAINS; c++) acc[c] = _mm512_fmadd_pd(acc[c], m, a);
+    }
+    double sum = 0.0;
+    for (int c = 0; c < FMA_CHAINS; c++) sum += _mm512_reduce_add_pd(acc[c]);
+    return sum;
+}
+#endif
+
+typedef double (*FmaKernel)(long long iters);
+
+/* Пик FMA для t потоков, ГФЛОП/с: 2 операции на цепочку и дорожку за итерацию */
+static double measure_fma(FmaKernel kernel, int lanes, int t, const RooflineOptions *opts) {
+    /* Число итераций на замер - по одному потоку, чтобы замер длился не меньше sample_ms */
+    long long iters = FMA_BLOCK;
+    for (;;) {
+        double start = omp_get_wtime();
+        volatile double sink = kernel(iters);
+        (void)sink;
+        if (omp_get_wtime() - start >= opts->sample_ms * 1e-3) break;
+        iters *= 2;
+    }
+
+    double best = 0.0;
+    for (int s = 0; s < opts->samples; s++) {
+        double start = 0.0, sink = 0.0;
+        #pragma omp parallel num_threads(t) reduction(+:sink)
+        {
+            #pragma omp barrier
+            #pragma omp master
+            start = omp_get_wtime();
+            sink += kernel(iters);
+        }
+        double elapsed = omp_get_wtime() - start;
+        double gflops = 2.0 * FMA_CHAINS * lanes * (double)iters * t / elapsed * 1e-9;
+        if (gflops > best && sink != 0.0) best = gflops;
+    }
+    return best;
+}
+
+/* Полоса триады для t потоков с рабочим набором per_thread байтов на поток, ГБ/с.
+ * Массивы выделяет и заполняет каждый поток сам - страницы попадают в память его узла */
+static double measure_triad(long long per_thread, int t, const RooflineOptions *opts) {
+    long long n = per_thread / (3 * sizeof(double));
+    if (n < 64) n = 64;
+    double best = 0.0, start = 0.0;
+    long long reps = 1;
+    int failed = 0;
+
+    #pragma omp parallel num_threads(t) reduction(+:failed)
+    {
+        double *a = (double*)malloc(n * sizeof(double));
+        double *b = (double*)malloc(n * sizeof(double));
+        double *c = (double*)malloc(n * sizeof(double));
+        int ok = a && b && c;
+        if (ok) {
+            for (long long i = 0; i < n; i++) {
+                a[i] = 0.0;
+                b[i] = 1.0;
+                c[i] = 2.0;
+            }
+        } else {
+            failed = 1;
+        }
+
+        /* Повторов триады на замер - по проходам потока 0 (прогревают и его массивы) */
+        #pragma omp master
+        if (ok) {
+            for (;;) {
+                double probe = omp_get_wtime();
+                for (long long r = 0; r < reps; r++) {
+                    #pragma omp simd
+                    for (long long i = 0; i < n; i++) a[i] = b[i] + 3.0 * c[i];
+                    __asm__ __volatile__("" : : "r"(a) : "memory");
+                }
+                if (omp_get_wtime() - probe >= opts->sample_ms * 1e-3) break;
+                reps *= 2;
+            }
+        }
+        #pragma omp barrier
+
+        for (int s = 0; s < opts->samples; s++) {
+            #pragma omp barrier
+            #pragma omp master
+            start = omp_get_wtime();
+            if (ok) {
+                for (long long r = 0; r < reps; r++) {
+                    #pragma omp simd
+                    for (long long i = 0; i < n; i++) a[i] = b[i] + 3.0 * c[i];
+                    /* Барьер компилятора: повторы не сворачиваются в один */
+                    __asm__ __volatile__("" : : "r"(a) : "memory");
+                }
+            }
+            #pragma omp barrier
+            #pragma omp master
+            {
+                double elapsed = omp_get_wtime() - start;
+                double gbs = 3.0 * sizeof(double) * (double)n * reps * t / elapsed * 1e-9;
+                if (gbs > best) best = gbs;
+            }
+        }
+        free(a);
+        free(b);
+        free(c);
+    }
+    return failed ? 0.0 : best;
+}
+
+static FILE *csv_out;
+static char csv_stamp[64];
+static const EnvInfo *csv_env;
+
+static void report(int t, const char *metric, long long working_set, double value, const char *unit) {
+    if (working_set > 0) {
+        printf("%3d  %-12s %10.1f KB  %10.2f %s\n", t, metric, working_set / 1024.0, value, unit);
+    } else {
+        printf("%3d  %-12s %13s  %10.2f %s\n", t, metric, "-", value, unit);
+    }
+    fprintf(csv_out, "%s,%s,%d,%s,%lld,%.3f\n", csv_stamp, csv_env->hash, t, metric, working_set, value);
+    fflush(csv_out);
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s <max_threads> [options]\n", prog);
+    fprintf(stderr, "  max_threads: thread counts 1, 2, 4, ... up to this value\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --samples <K>        timed samples per point, the best is kept (default: %d)\n", DEFAULT_SAMPLES);
+    fprintf(stderr, "  --sample-ms <ms>     minimal duration of one sample (default: %g)\n", DEFAULT_SAMPLE_MS);
+    fprintf(stderr, "Writes %s (overwritten on each run)\n", ROOFLINE_CSV_PATH);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    RooflineOptions opts;
+    opts.max_threads = atoi(argv[1]);
+    opts.samples = DEFAULT_SAMPLES;
+    opts.sample_ms = DEFAULT_SAMPLE_MS;
+
+    for (int a = 2; a < argc; a++) {
+        if (a + 1 >= argc) {
+            fprintf(stderr, "Error: option %s requires a value\n", argv[a]);
+            return 1;
+        }
+        if (strcmp(argv[a], "--samples") == 0) {
+            opts.samples = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--sample-ms") == 0) {
+            opts.sample_ms = atof(argv[++a]);
+        } else {
+            fprintf(stderr, "Error: unknown option %s\n", argv[a]);
+            return 1;
+        }
+    }
+    if (opts.max_threads <= 0) {
+        fprintf(stderr, "Error: max_threads must be positive, got %s\n", argv[1]);
+        return 1;
+    }
+    if (opts.samples < 1 || opts.sample_ms <= 0.0) {
+        fprintf(stderr, "Error: samples and sample duration must be positive\n");
+        return 1;
+    }
+
+    EnvInfo env;
+    env_capture(&env);
+    csv_env = &env;
+
+    /* Кэши: неизвестные размеры - типичные значения */
+    long long l1 = cache_size(1), l2 = cache_size(2), l3 = cache_size(3);
+    int known = l1 > 0 && l2 > 0;
+    if (l1 <= 0) l1 = 32LL << 10;
+    if (l2 <= 0) l2 = 1LL << 20;
+
+    env_ensure_dir("./bench/data");
+    csv_out = fopen(ROOFLINE_CSV_PATH, "w");
+    if (!csv_out) {
+        fprintf(stderr, "Cannot open %s for writing\n", ROOFLINE_CSV_PATH);
+        return 1;
+    }
+    fprintf(csv_out, "%s\n", ROOFLINE_CSV_HEADER);
+    time_t now = time(NULL);
+    strftime(csv_stamp, sizeof(csv_stamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+
+    int have_avx2 = 0, have_avx512 = 0;
+#if HAVE_X86_SIMD
+    __builtin_cpu_init();
+    have_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    have_avx512 = __builtin_cpu_supports("avx512f");
+#endif
+
+    printf("=== Machine Roofline Characterization ===\n");
+    printf("CPU: %s\n", env.cpu_model);
+    env_print(&env);
+    printf("Caches: L1d %lld KB, L2 %lld KB", l1 >> 10, l2 >> 10);
+    if (l3 > 0) printf(", L3 %lld KB (shared)", l3 >> 10);
+    else printf(", no L3");
+    printf("%s\n", known ? "" : " (sizes unknown, defaults used)");
+    printf("FMA kernels: scalar%s%s\n", have_avx2 ? ", avx2" : "", have_avx512 ? ", avx512" : "");
+    printf("Samples: %d x >= %.0f ms (best)\n", opts.samples, opts.sample_ms);
+    printf("=========================================\n\n");
+    printf("thr  %-12s %13s  %10s\n", "metric", "set/thread", "value");
+
+    for (int t = 1; t > 0; t = next_threads(t, opts.max_threads)) {
+        report(t, "fma_scalar", 0, measure_fma(fma_scalar, 1, t, &opts), "GFLOP/s");
+#if HAVE_X86_SIMD
+        if (have_avx2) report(t, "fma_avx2", 0, measure_fma(fma_avx2, 4, t, &opts), "GFLOP/s");
+        if (have_avx512) report(t, "fma_avx512", 0, measure_fma(fma_avx512, 8, t, &opts), "GFLOP/s");
+#endif
+
+        /* Рабочие наборы на поток: L1 и L2 - частные, L3 делится между потоками */
+        long long sets[ROOFLINE_LEVELS];
+        sets[0] = l1 / 2;
+        sets[1] = l2 / 2;
+        sets[2] = l3 > 0 ? l3 / 2 / t : 0;
+        long long dram_total = (l3 > 0 && 4 * l3 > DRAM_MIN_BYTES) ? 4 * l3 : DRAM_MIN_BYTES;
+        sets[3] = dram_total / t;
+        for (int l = 0; l < ROOFLINE_LEVELS; l++) {
+            /* Доля L3 не больше частного L2 - уровень не отделить от L2 */
+            if (sets[l] <= 0 || (l == 2 && sets[l] <= l2)) continue;
+            char metric[16];
+            snprintf(metric, sizeof(metric), "bw_%s", roofline_level_names[l]);
+            report(t, metric, sets[l], measure_triad(sets[l], t, &opts), "GB/s");
+        }
+    }
+
+    fclose(csv_out);
+    printf("\nCharacterization written to %s\n", ROOFLINE_CSV_PATH);
+    return 0;
+}
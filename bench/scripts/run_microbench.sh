@@ -0,0 +1,28 @@
+#!/bin/bash
+
+# Скрипт микробенчмарков горячих циклов всех заданий
+
+echo "Компиляция микробенчмарков..."
+gcc -fopenmp -O3 -pthread -o bench/scripts/microbench bench/scripts/microbench.c task2/scripts/nbody.c task3/scripts/my_rwlock.c common/trace.c common/env_info.c -lm
+
+if [ $? -ne 0 ]; then
+    echo "Ошибка компиляции! Убедитесь, что gcc и OpenMP доступны."
+    exit 1
+fi
+
+echo "Компиляция успешна!"
+echo "======================================"
+echo "Запуск микробенчмарков..."
+echo "======================================"
+
+# Параметры тестирования
+MAX_THREADS=$(nproc)
+BODIES=2048
+
+./bench/scripts/microbench $MAX_THREADS --bodies $BODIES
+
+echo ""
+echo "======================================"
+echo "Замеры завершены!"
+echo "Результаты: bench/data/microbench.csv"
+echo "======================================"
@@ -0,0 +1,151 @@
+#!/bin/bash
+
+# Регрессионный прогон набора бенчмарков всех заданий и сравнение с базовым прогоном
+#
+# Использование: ./bench/scripts/run_regression.sh [run_id] [baseline_run_id]
+#   run_id           имя прогона (по умолчанию: дата и время)
+#   baseline_run_id  прогон для сравнения (по умолчанию: содержимое bench/data/regression/baseline)
+
+RUN_ID=${1:-$(date +%Y%m%d_%H%M%S)}
+OUT_DIR="bench/data/regression"
+BASELINE=${2:-$(cat "$OUT_DIR/baseline" 2>/dev/null)}
+
+echo "Компиляция заданий и regress..."
+gcc -fopenmp -O3 -o task1/scripts/task1 task1/scripts/task1.c task1/scripts/pyramid.c task1/scripts/contour.c task1/scripts/escape_stream.c common/trace.c common/env_info.c common/rapl.c common/scaling.c common/peak.c common/roofline.c common/mem_profile.c -lm && \
+gcc -fopenmp -O3 -o task2/scripts/task2 task2/scripts/task2.c task2/scripts/nbody.c task2/scripts/wisdom_holman.c task2/scripts/test_particles.c task2/scripts/sfc_reorder.c task2/scripts/particle_mesh.c task2/scripts/cell_list.c task2/scripts/ewald.c task2/scripts/render.c task2/scripts/fof.c task2/scripts/traj_store.c task2/scripts/regularization.c common/perf_counters.c common/trace.c common/env_info.c common/rapl.c common/scaling.c common/peak.c common/roofline.c common/mem_profile.c -lm && \
+gcc -pthread -O3 -o task3/scripts/task3_my_rwlock task3/scripts/task3_my_rwlock.c task3/scripts/my_rwlock.c common/rapl.c common/mem_profile.c common/env_info.c -lm && \
+gcc -pthread -O3 -o task3/scripts/task3_pthread_rwlock task3/scripts/task3_pthread_rwlock.c common/rapl.c common/mem_profile.c common/env_info.c -lm && \
+gcc -O3 -o bench/scripts/regress bench/scripts/regress.c -lm
+
+if [ $? -ne 0 ]; then
+    echo "Ошибка компиляции!"
+    exit 1
+fi
+
+echo "Компиляция успешна!"
+echo "======================================"
+echo "Регрессионный прогон $RUN_ID..."
+echo "======================================"
+
+# Параметры набора
+SAMPLES=5                                   # замеров на случай
+MAX_THREADS=$(nproc)
+THREAD_LIST=""
+for T in 1 2 4 8; do
+    [ $T -le $MAX_THREADS ] && THREAD_LIST="$THREAD_LIST $T"
+done
+TASK1_SIZES="1000000 4000000"               # точек сетки
+TASK2_INPUTS="three_body cluster_4000"      # входы task2/data/input/<name>.txt
+TASK3_MIXES="read:0.9:0.05 balanced:0.5:0.25 write:0.1:0.45"   # имя:доля поиска:доля вставок
+TASK3_KEYS=1000
+TASK3_OPS=200000
+
+# Отпечаток окружения - env_hash, который задания 1 и 2 печатают в строке "Environment:"
+# и пишут в *_performance.csv (common/env_info.c). Он известен после первого замера,
+# поэтому строки прогона получают его в конце. Коммит в отпечаток не входит - его влияние и измеряется
+CPU=$(grep -m1 "model name" /proc/cpuinfo | cut -d: -f2 | sed 's/^ *//')
+GCC=$(gcc --version | head -1)
+KERNEL=$(uname -sr)
+LIBC=$(ldd --version 2>/dev/null | head -1)
+COMMIT=$(git rev-parse --short HEAD 2>/dev/null)
+TIMESTAMP=$(date +%Y-%m-%dT%H:%M:%S)
+
+mkdir -p "$OUT_DIR"
+RUN_FILE="$OUT_DIR/$RUN_ID.csv"
+if [ -f "$RUN_FILE" ]; then
+    echo "Прогон $RUN_ID уже существует: $RUN_FILE"
+    exit 1
+fi
+LOG_FILE="$OUT_DIR/$RUN_ID.log"
+echo "run_id,timestamp,fingerprint,suite,case,threads,sample,time" > "$RUN_FILE"
+: > "$LOG_FILE"
+
+# Запись замеров: suite case threads, времена на стандартном входе; вывод программ - в журнал
+record() {
+    tee -a "$LOG_FILE" | grep -o "$4 = [0-9.]*" | awk '{ print $NF }' \
+        | awk -v id="$RUN_ID" -v ts="$TIMESTAMP" -v s="$1" -v c="$2" -v t="$3" \
+            '{ printf "%s,%s,,%s,%s,%s,%d,%s\n", id, ts, s, c, t, NR, $1 }' >> "$RUN_FILE"
+}
+
+# Вход task2: шар из 4000 тел (как в run_pm_scaling.sh, без периодического куба)
+CLUSTER="task2/data/input/cluster_4000.txt"
+if [ ! -f "$CLUSTER" ]; then
+    awk -v n=4000 'BEGIN {
+        srand(42); print n; R = 1e11; i = 0
+        while (i < n) {
+            x = 2 * rand() - 1; y = 2 * rand() - 1; z = 2 * rand() - 1
+            if (x*x + y*y + z*z <= 1) {
+                printf "%.6e %.6e %.6e 0 0 0 %.6e\n", R*x, R*y, R*z, 1e30 / n
+                i++
+            }
+        }
+    }' > "$CLUSTER"
+fi
+
+for THREADS in $THREAD_LIST; do
+    for N in $TASK1_SIZES; do
+        echo "task1: $N точек, $THREADS потоков"
+        ./task1/scripts/task1 $THREADS $N $SAMPLES regression | record task1 "grid_$N" $THREADS "Time"
+    done
+
+    for INPUT in $TASK2_INPUTS; do
+        # Около 10^8 взаимодействий на замер для любого входа
+        if [ "$INPUT" = "three_body" ]; then TEND=1.0; else TEND=0.06; fi
+        echo "task2: $INPUT, $THREADS потоков"
+        ./task2/scripts/task2 $THREADS $TEND task2/data/input/$INPUT.txt $SAMPLES regression --no-trajectory \
+            | record task2 "$INPUT" $THREADS "Time"
+    done
+
+    for MIX in $TASK3_MIXES; do
+        IFS=: read NAME SEARCH INSERT <<< "$MIX"
+        for BACKEND in my_rwlock pthread_rwlock; do
+            echo "task3: $NAME, $BACKEND, $THREADS потоков"
+            for S in $(seq $SAMPLES); do
+                printf "%s\n%s\n%s\n%s\n" $TASK3_KEYS $TASK3_OPS $SEARCH $INSERT \
+                    | ./task3/scripts/task3_$BACKEND $THREADS
+            done | record task3 "${NAME}_$BACKEND" $THREADS "Elapsed time"
+        done
+    done
+done
+
+FINGERPRINT=$(grep -m1 -o "^Environment: [0-9a-f]*" "$LOG_FILE" | awk '{ print $2 }')
+if [ -z "$FINGERPRINT" ]; then
+    echo "Предупреждение: env_hash не найден в выводе заданий, отпечаток прогона - unknown"
+    FINGERPRINT=unknown
+fi
+awk -F, -v OFS=, -v fp="$FINGERPRINT" 'NR > 1 { $3 = fp } { print }' "$RUN_FILE" > "$RUN_FILE.tmp" \
+    && mv "$RUN_FILE.tmp" "$RUN_FILE"
+{
+    echo "run_id=$RUN_ID"
+    echo "timestamp=$TIMESTAMP"
+    echo "fingerprint=$FINGERPRINT"
+    echo "commit=$COMMIT"
+    echo "cpu=$CPU"
+    echo "nproc=$MAX_THREADS"
+    echo "compiler=$GCC"
+    echo "kernel=$KERNEL"
+    echo "libc=$LIBC"
+} > "$OUT_DIR/$RUN_ID.env"
+
+echo ""
+echo "Замеры записаны в $RUN_FILE (окружение: $OUT_DIR/$RUN_ID.env, вывод программ: $LOG_FILE)"
+
+if [ -z "$BASELINE" ]; then
+    echo "Базовый прогон не задан: сделать этот прогон базовым - echo $RUN_ID > $OUT_DIR/baseline"
+    exit 0
+fi
+if [ ! -f "$OUT_DIR/$BASELINE.csv" ]; then
+    echo "Базовый прогон $BASELINE не найден в $OUT_DIR"
+    exit 1
+fi
+
+echo ""
+./bench/scripts/regress "$OUT_DIR/$BASELINE.csv" "$RUN_FILE" --report "$OUT_DIR/${RUN_ID}_vs_$BASELINE.csv"
+STATUS=$?
+
+echo ""
+echo "======================================"
+echo "Регрессионный прогон завершён!"
+echo "Отчёт: $OUT_DIR/${RUN_ID}_vs_$BASELINE.csv"
+echo "======================================"
+exit $STATUS
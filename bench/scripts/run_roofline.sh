@@ -0,0 +1,27 @@
+#!/bin/bash
+
+# Скрипт характеристики машины для модели roofline (пик FMA и полоса L1/L2/L3/DRAM)
+
+echo "Компиляция roofline..."
+gcc -fopenmp -O3 -o bench/scripts/roofline bench/scripts/roofline.c common/env_info.c common/roofline.c -lm
+
+if [ $? -ne 0 ]; then
+    echo "Ошибка компиляции! Убедитесь, что gcc и OpenMP доступны."
+    exit 1
+fi
+
+echo "Компиляция успешна!"
+echo "======================================"
+echo "Характеристика машины..."
+echo "======================================"
+
+# Числа потоков 1, 2, 4, ... до числа процессоров
+MAX_THREADS=$(nproc)
+
+./bench/scripts/roofline $MAX_THREADS
+
+echo ""
+echo "======================================"
+echo "Характеристика завершена!"
+echo "Результаты: bench/data/roofline.csv (читают task1 и task2)"
+echo "======================================"
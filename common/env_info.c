@@ -0,0 +1,242 @@
+/* env_info.c
+ * Отпечаток окружения запуска (Linux; на других системах поля неизвестны)
+ */
+
+#define _GNU_SOURCE
+#include "env_info.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+extern char **environ;
+
+/* Первая строка файла без перевода строки; 0, если файла нет */
+static int read_line(const char *path, char *buf, size_t size) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    int ok = fgets(buf, (int)size, f) != NULL;
+    fclose(f);
+    if (!ok) return 0;
+    buf[strcspn(buf, "\n")] = '\0';
+    return 1;
+}
+
+static int read_int(const char *path, int fallback) {
+    char buf[64];
+    return read_line(path, buf, sizeof(buf)) ? atoi(buf) : fallback;
+}
+
+/* Дописывает строку к буферу с разделителем sep, не выходя за size */
+static void append(char *buf, size_t size, const char *sep, const char *text) {
+    size_t len = strlen(buf);
+    snprintf(buf + len, size - len, "%s%s", len > 0 ? sep : "", text);
+}
+
+/* Флаги сборки: явные из -DBUILD_FLAGS или восстановленные по макросам компилятора */
+static void build_flags(char *buf, size_t size) {
+#ifdef BUILD_FLAGS
+    snprintf(buf, size, "%s", BUILD_FLAGS);
+#else
+    buf[0] = '\0';
+#ifdef __OPTIMIZE__
+    append(buf, size, " ", "-O");
+#endif
+#ifdef _OPENMP
+    char omp[32];
+    snprintf(omp, sizeof(omp), "-fopenmp(%d)", _OPENMP);
+    append(buf, size, " ", omp);
+#endif
+#ifdef __AVX512F__
+    append(buf, size, " ", "avx512f");
+#endif
+#ifdef __AVX2__
+    append(buf, size, " ", "avx2");
+#endif
+#ifdef __FMA__
+    append(buf, size, " ", "fma");
+#endif
+#ifdef __FAST_MATH__
+    append(buf, size, " ", "-ffast-math");
+#endif
+#ifdef ENABLE_TRACE
+    append(buf, size, " ", "-DENABLE_TRACE");
+#endif
+    if (buf[0] == '\0') snprintf(buf, size, "none");
+#endif
+}
+
+/* Маска привязки диапазонами и первый процессор маски */
+static int affinity_ranges(EnvInfo *env) {
+    env->affinity[0] = '\0';
+    env->affinity_cpus = 0;
+#ifdef __linux__
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        snprintf(env->affinity, sizeof(env->affinity), "unknown");
+        return 0;
+    }
+    int first = -1;
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (!CPU_ISSET(c, &set)) continue;
+        int end = c;
+        while (end + 1 < CPU_SETSIZE && CPU_ISSET(end + 1, &set)) end++;
+        char range[32];
+        if (end > c) snprintf(range, sizeof(range), "%d-%d", c, end);
+        else snprintf(range, sizeof(range), "%d", c);
+        append(env->affinity, sizeof(env->affinity), ",", range);
+        env->affinity_cpus += end - c + 1;
+        if (first < 0) first = c;
+        c = end;
+    }
+    return first < 0 ? 0 : first;
+#else
+    snprintf(env->affinity, sizeof(env->affinity), "unknown");
+    return 0;
+#endif
+}
+
+void env_capture(EnvInfo *env) {
+    memset(env, 0, sizeof(*env));
+    snprintf(env->cpu_model, sizeof(env->cpu_model), "unknown");
+#ifdef __linux__
+    env->online_cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    FILE *cpuinfo = fopen("/proc/cpuinfo", "r");
+    if (cpuinfo) {
+        char line[256];
+        while (fgets(line, sizeof(line), cpuinfo)) {
+            char *colon = strchr(line, ':');
+            if (strncmp(line, "model name", 10) == 0 && colon) {
+                line[strcspn(line, "\n")] = '\0';
+                snprintf(env->cpu_model, sizeof(env->cpu_model), "%s", colon + 2);
+                break;
+            }
+        }
+        fclose(cpuinfo);
+    }
+#endif
+    env->smt = read_int("/sys/devices/system/cpu/smt/active", -1);
+    int cpu = affinity_ranges(env);
+
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor", cpu);
+    if (!read_line(path, env->governor, sizeof(env->governor))) snprintf(env->governor, sizeof(env->governor), "unknown");
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_min_freq", cpu);
+    int khz = read_int(path, -1);
+    env->freq_min_mhz = khz > 0 ? khz / 1000 : -1;
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_max_freq", cpu);
+    khz = read_int(path, -1);
+    env->freq_max_mhz = khz > 0 ? khz / 1000 : -1;
+
+    /* "always [madvise] never" - выбранный режим в скобках */
+    char thp[128];
+    snprintf(env->thp, sizeof(env->thp), "unknown");
+    if (read_line("/sys/kernel/mm/transparent_hugepage/enabled", thp, sizeof(thp))) {
+        char *open = strchr(thp, '['), *close = open ? strchr(open, ']') : NULL;
+        if (close) snprintf(env->thp, sizeof(env->thp), "%.*s", (int)(close - open - 1), open + 1);
+    }
+
+#ifdef __VERSION__
+    snprintf(env->compiler, sizeof(env->compiler), "%s", __VERSION__);
+#else
+    snprintf(env->compiler, sizeof(env->compiler), "unknown");
+#endif
+    build_flags(env->build_flags, sizeof(env->build_flags));
+
+    for (char **e = environ; e && *e; e++) {
+        if (strncmp(*e, "OMP_", 4) == 0 || strncmp(*e, "GOMP_", 5) == 0 || strncmp(*e, "KMP_", 4) == 0) {
+            append(env->omp_env, sizeof(env->omp_env), ";", *e);
+        }
+    }
+
+    /* FNV-1a по всем полям в текстовом виде */
+    char text[1792];
+    snprintf(text, sizeof(text), "%s|%d|%d|%s|%s|%d|%d|%s|%s|%s|%s",
+             env->cpu_model, env->online_cpus, env->smt, env->affinity, env->governor, env->freq_min_mhz,
+             env->freq_max_mhz, env->thp, env->compiler, env->build_flags, env->omp_env);
+    unsigned long long h = 1469598103934665603ull;
+    for (const char *p = text; *p; p++) {
+        h ^= (unsigned char)*p;
+        h *= 1099511628211ull;
+    }
+    snprintf(env->hash, sizeof(env->hash), "%016llx", h);
+}
+
+void env_print(const EnvInfo *env) {
+    printf("Environment: %s (SMT %s, affinity %s = %d of %d CPUs, governor %s, THP %s)\n",
+           env->hash, env->smt == 1 ? "on" : env->smt == 0 ? "off" : "unknown",
+           env->affinity, env->affinity_cpus, env->online_cpus, env->governor, env->thp);
+    printf("Build: %s, %s\n", env->compiler, env->build_flags);
+    if (env->omp_env[0]) printf("OpenMP environment: %s\n", env->omp_env);
+}
+
+/* Строковое поле CSV в кавычках, кавычки внутри удваиваются */
+static void csv_quoted(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"') fputc('"', f);
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+void env_csv_write(FILE *f, const EnvInfo *env) {
+    fprintf(f, "%s,%d,%d,", env->hash, env->online_cpus, env->smt);
+    csv_quoted(f, env->affinity);
+    fprintf(f, ",%s,%d,%d,%s,", env->governor, env->freq_min_mhz, env->freq_max_mhz, env->thp);
+    csv_quoted(f, env->compiler);
+    fputc(',', f);
+    csv_quoted(f, env->build_flags);
+    fputc(',', f);
+    csv_quoted(f, env->omp_env);
+}
+
+void env_ensure_dir(const char *path) {
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s", path);
+    for (char *p = tmp + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            mkdir(tmp, 0755);
+            *p = '/';
+        }
+    }
+    mkdir(tmp, 0755);
+}
+
+FILE *env_csv_append(const char *path, const char *header) {
+    /* Пустой или отсутствующий файл начинается с заголовка */
+    char first[2048] = "";
+    int exists = read_line(path, first, sizeof(first));
+
+    if (exists && strcmp(first, header) != 0) {
+        /* Другая схема: старый файл сохраняется рядом, новый начинается с заголовка */
+        char rotated[1024];
+        char stamp[32];
+        time_t now = time(NULL);
+        strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localtime(&now));
+        size_t len = strlen(path);
+        if (len > 4 && strcmp(path + len - 4, ".csv") == 0) {
+            snprintf(rotated, sizeof(rotated), "%.*s.%s.csv", (int)(len - 4), path, stamp);
+        } else {
+            snprintf(rotated, sizeof(rotated), "%s.%s", path, stamp);
+        }
+        if (rename(path, rotated) != 0) {
+            fprintf(stderr, "Cannot rotate %s with an outdated header\n", path);
+            return NULL;
+        }
+        printf("Header of %s changed, previous rows moved to %s\n", path, rotated);
+        exists = 0;
+    }
+
+    FILE *f = fopen(path, "a");
+    if (!f) return NULL;
+    if (!exists) fprintf(f, "%s\n", header);
+    return f;
+}
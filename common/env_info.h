@@ -0,0 +1,50 @@
+/* env_info.h
+ * Отпечаток окружения запуска для файлов *_performance.csv.
+ * Одна модель процессора не объясняет замеры: на результат влияют SMT,
+ * маска привязки процесса, регулятор и пределы частоты, прозрачные
+ * большие страницы, компилятор с флагами и переменные OMP_*. Всё это
+ * снимается один раз при старте, хеш и подробности дописываются к строке CSV.
+ */
+
+#ifndef ENV_INFO_H
+#define ENV_INFO_H
+
+#include <stdio.h>
+
+/* Столбцы окружения, добавляемые в конец строки CSV */
+#define ENV_CSV_HEADER "env_hash,online_cpus,smt,affinity,governor,freq_min_mhz,freq_max_mhz,thp,compiler,build_flags,omp_env"
+
+typedef struct {
+    char hash[17];              /* FNV-1a 64 всех полей ниже, 16 hex-цифр */
+    char cpu_model[128];        /* В CSV уже есть как cpu_info, в хеш входит */
+    int online_cpus;
+    int smt;                    /* 1 - включён, 0 - выключен, -1 - неизвестно */
+    int affinity_cpus;          /* Процессоров в маске привязки */
+    char affinity[256];         /* Маска диапазонами: "0-3,8-11" */
+    char governor[32];          /* Регулятор частоты первого процессора маски */
+    int freq_min_mhz;           /* Пределы частоты регулятора, -1 - неизвестно */
+    int freq_max_mhz;
+    char thp[32];               /* Режим transparent_hugepage */
+    char compiler[64];
+    char build_flags[192];      /* BUILD_FLAGS при сборке или флаги, видимые по макросам */
+    char omp_env[512];          /* OMP_*, GOMP_*, KMP_* через ';' */
+} EnvInfo;
+
+/* Снимает окружение текущего процесса */
+void env_capture(EnvInfo *env);
+
+/* Краткая строка для заголовка вывода программы */
+void env_print(const EnvInfo *env);
+
+/* Значения столбцов ENV_CSV_HEADER (без ведущей запятой и перевода строки) */
+void env_csv_write(FILE *f, const EnvInfo *env);
+
+/* Создаёт каталог path вместе с недостающими родительскими */
+void env_ensure_dir(const char *path);
+
+/* Открывает CSV на дозапись с заголовком header. Если у существующего файла
+ * другой заголовок, он переименовывается в <имя>.<время>.csv и начинается новый.
+ * Возвращает NULL при ошибке */
+FILE *env_csv_append(const char *path, const char *header);
+
+#endif /* ENV_INFO_H */
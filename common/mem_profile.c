@@ -0,0 +1,131 @@
+/* mem_profile.c
+ * Память по фазам: /proc/self/status, getrusage, mallinfo2
+ */
+
+#include "mem_profile.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+static const char *const phase_names[MEM_PHASES] = {"load", "compute", "output"};
+
+static double mem_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Поле "VmRSS:" или "VmHWM:" из /proc/self/status, КБ; -1, если нет */
+static long long status_kb(const char *field) {
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) return -1;
+    char line[256];
+    long long value = -1;
+    size_t len = strlen(field);
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, field, len) == 0) {
+            value = atoll(line + len);
+            break;
+        }
+    }
+    fclose(f);
+    return value;
+}
+
+/* Занятые байты кучи, включая блоки через mmap; -1 без glibc */
+static long long heap_in_use(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+    return (long long)(mi.uordblks + mi.hblkhd);
+#elif defined(__GLIBC__)
+    struct mallinfo mi = mallinfo();
+    return (long long)(unsigned)mi.uordblks + (long long)(unsigned)mi.hblkhd;
+#else
+    return -1;
+#endif
+}
+
+/* Сброс пика RSS (Linux 4.0+); 0, если недоступен */
+static int reset_hwm(void) {
+    FILE *f = fopen("/proc/self/clear_refs", "w");
+    if (!f) return 0;
+    int ok = fputs("5", f) >= 0;
+    return (fclose(f) == 0) && ok;
+}
+
+void mem_profile_init(MemProfile *mp) {
+    memset(mp, 0, sizeof(*mp));
+    mp->heap_known = heap_in_use() >= 0;
+    mp->hwm_reset = 1;
+    mp->peak_rss_kb = status_kb("VmHWM:");
+}
+
+void mem_phase_begin(MemProfile *mp, MemPhaseId phase) {
+    MemPhase *p = &mp->phases[phase];
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    if (mp->hwm_reset && !reset_hwm()) mp->hwm_reset = 0;
+    p->start_time = mem_now();
+    p->start_heap = heap_in_use();
+    p->start_minor = ru.ru_minflt;
+    p->start_major = ru.ru_majflt;
+}
+
+void mem_phase_end(MemProfile *mp, MemPhaseId phase) {
+    MemPhase *p = &mp->phases[phase];
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    p->measured = 1;
+    p->seconds = mem_now() - p->start_time;
+    p->minor_faults = ru.ru_minflt - p->start_minor;
+    p->major_faults = ru.ru_majflt - p->start_major;
+    p->rss_kb = status_kb("VmRSS:");
+    p->peak_rss_kb = status_kb("VmHWM:");
+    p->heap_net_kb = mp->heap_known ? (heap_in_use() - p->start_heap) / 1024 : 0;
+    /* ru_maxrss - только без /proc: Linux переносит его через exec от родителя */
+    if (p->peak_rss_kb < 0) p->peak_rss_kb = ru.ru_maxrss;
+    if (p->peak_rss_kb > mp->peak_rss_kb) mp->peak_rss_kb = p->peak_rss_kb;
+}
+
+void mem_profile_print(const MemProfile *mp) {
+    printf("\n=== Memory ===\n");
+    printf("Peak RSS:     %.1f MB (process)\n", mp->peak_rss_kb / 1024.0);
+    printf("Phase      Time (s)   Peak RSS (MB)   RSS at end (MB)   Heap net (MB)     Minor faults   Major faults\n");
+    for (int k = 0; k < MEM_PHASES; k++) {
+        const MemPhase *p = &mp->phases[k];
+        if (!p->measured) continue;
+        printf("%-8s %10.3f   %13.1f   %15.1f   ", phase_names[k], p->seconds,
+               p->peak_rss_kb / 1024.0, p->rss_kb / 1024.0);
+        if (mp->heap_known) printf("%15.1f", p->heap_net_kb / 1024.0);
+        else printf("%15s", "unknown");
+        printf("   %12lld   %12lld\n", p->minor_faults, p->major_faults);
+    }
+    if (!mp->hwm_reset) {
+        printf("Note: /proc/self/clear_refs is not writable, phase peaks are process peaks so far\n");
+    }
+    printf("==============\n\n");
+}
+
+void mem_csv_write(FILE *f, const MemProfile *mp) {
+    if (!mp) {
+        fprintf(f, ",,,,,,,,,,,,");
+        return;
+    }
+    fprintf(f, "%lld", mp->peak_rss_kb);
+    for (int k = 0; k < MEM_PHASES; k++) {
+        const MemPhase *p = &mp->phases[k];
+        if (!p->measured) {
+            fprintf(f, ",,,,");
+            continue;
+        }
+        fprintf(f, ",%lld,", p->peak_rss_kb);
+        if (mp->heap_known) fprintf(f, "%lld", p->heap_net_kb);
+        fprintf(f, ",%lld,%lld", p->minor_faults, p->major_faults);
+    }
+}
@@ -0,0 +1,60 @@
+/* mem_profile.h
+ * Память по фазам программы: загрузка, вычисление, вывод.
+ * Для каждой фазы снимаются пик RSS внутри фазы (VmHWM из /proc/self/status,
+ * сбрасывается записью "5" в /proc/self/clear_refs; без сброса - пик процесса
+ * с начала работы), RSS в конце, чистое изменение занятой кучи (mallinfo2) и
+ * страничные отказы (getrusage). Чистое изменение - разность занятых байтов
+ * в конце и в начале фазы, а не пик и не сумма выделений: буферы,
+ * освобождённые внутри фазы, видны только в пике RSS.
+ */
+
+#ifndef MEM_PROFILE_H
+#define MEM_PROFILE_H
+
+#include <stdio.h>
+
+typedef enum {
+    MEM_LOAD = 0,           /* Чтение входа, выделение буферов */
+    MEM_COMPUTE = 1,        /* Замеряемые запуски */
+    MEM_OUTPUT = 2,         /* Запись результатов */
+    MEM_PHASES = 3
+} MemPhaseId;
+
+/* Столбцы памяти в *_performance.csv (пустые для неизмеренной фазы) */
+#define MEM_PHASE_CSV(p) p "_peak_rss_kb," p "_heap_net_kb," p "_minor_faults," p "_major_faults"
+#define MEM_CSV_HEADER "peak_rss_kb," MEM_PHASE_CSV("load") "," MEM_PHASE_CSV("compute") "," MEM_PHASE_CSV("output")
+
+typedef struct {
+    int measured;
+    double seconds;
+    long long peak_rss_kb;          /* Пик RSS в фазе (или процесса, если сброс недоступен) */
+    long long rss_kb;               /* RSS в конце фазы */
+    long long heap_net_kb;          /* Занятая куча в конце фазы минус в начале */
+    long long minor_faults;
+    long long major_faults;
+    /* Состояние в начале фазы */
+    double start_time;
+    long long start_heap;
+    long long start_minor, start_major;
+} MemPhase;
+
+typedef struct {
+    MemPhase phases[MEM_PHASES];
+    int hwm_reset;                  /* Пик RSS сбрасывается в начале фазы */
+    int heap_known;                 /* mallinfo доступна (glibc) */
+    long long peak_rss_kb;          /* Пик RSS процесса: до первой фазы и по фазам */
+} MemProfile;
+
+void mem_profile_init(MemProfile *mp);
+
+/* Границы фазы; фазы не вкладываются одна в другую */
+void mem_phase_begin(MemProfile *mp, MemPhaseId phase);
+void mem_phase_end(MemProfile *mp, MemPhaseId phase);
+
+/* Раздел "=== Memory ===" по измеренным фазам */
+void mem_profile_print(const MemProfile *mp);
+
+/* Значения столбцов MEM_CSV_HEADER (без запятых по краям); mp = NULL - пустые */
+void mem_csv_write(FILE *f, const MemProfile *mp);
+
+#endif /* MEM_PROFILE_H */
@@ -0,0 +1,89 @@
+/* peak.c
+ * Оценка пиковой производительности по операциям double
+ */
+
+#include "peak.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Частота из /proc/cpuinfo, если регулятор частоты недоступен (виртуальные машины) */
+static int cpuinfo_mhz(void) {
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    if (!f) return -1;
+    char line[256];
+    int mhz = -1;
+    while (fgets(line, sizeof(line), f)) {
+        char *colon = strchr(line, ':');
+        if (strncmp(line, "cpu MHz", 7) == 0 && colon) {
+            mhz = (int)atof(colon + 1);
+            break;
+        }
+    }
+    fclose(f);
+    return mhz;
+}
+
+/* Операций double за такт на ядро по доступному набору инструкций */
+static int isa_flops_per_cycle(char *isa, size_t size) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        snprintf(isa, size, "avx512f");
+        return 32;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        snprintf(isa, size, "avx2+fma");
+        return 16;
+    }
+    if (__builtin_cpu_supports("avx")) {
+        snprintf(isa, size, "avx");
+        return 8;
+    }
+    snprintf(isa, size, "sse2");
+    return 4;
+#elif defined(__aarch64__)
+    snprintf(isa, size, "neon");
+    return 8;
+#else
+    snprintf(isa, size, "scalar");
+    return 2;
+#endif
+}
+
+void peak_estimate(MachinePeak *peak, const EnvInfo *env) {
+    memset(peak, 0, sizeof(*peak));
+    peak->flops_per_cycle = isa_flops_per_cycle(peak->isa, sizeof(peak->isa));
+
+    /* Потоки SMT делят конвейеры FMA ядра */
+    int cpus = env->affinity_cpus > 0 ? env->affinity_cpus : env->online_cpus;
+    peak->cores = (env->smt == 1 && cpus > 1) ? cpus / 2 : cpus;
+    peak->mhz = env->freq_max_mhz > 0 ? env->freq_max_mhz : cpuinfo_mhz();
+
+    const char *forced = getenv("PEAK_GFLOPS");
+    if (forced && atof(forced) > 0.0) {
+        peak->gflops = atof(forced);
+        snprintf(peak->source, sizeof(peak->source), "PEAK_GFLOPS");
+        return;
+    }
+    snprintf(peak->source, sizeof(peak->source), "estimate");
+    if (peak->cores > 0 && peak->mhz > 0) {
+        peak->gflops = (double)peak->cores * peak->mhz * 1e-3 * peak->flops_per_cycle;
+    }
+}
+
+void peak_print(const MachinePeak *peak) {
+    if (peak->gflops <= 0.0) {
+        printf("Peak estimate: unknown (set PEAK_GFLOPS)\n");
+    } else if (strcmp(peak->source, "PEAK_GFLOPS") == 0) {
+        printf("Peak: %.1f GFLOP/s (PEAK_GFLOPS)\n", peak->gflops);
+    } else {
+        printf("Peak estimate: %.1f GFLOP/s (%d cores x %d MHz x %d DP flops/cycle, %s)\n",
+               peak->gflops, peak->cores, peak->mhz, peak->flops_per_cycle, peak->isa);
+    }
+}
+
+double peak_fraction(const MachinePeak *peak, double gflops) {
+    return peak->gflops > 0.0 ? gflops / peak->gflops : -1.0;
+}
@@ -0,0 +1,33 @@
+/* peak.h
+ * Оценка пиковой производительности машины по операциям double для доли
+ * пика в метриках пропускной способности. Пик = физические ядра маски привязки
+ * * максимальная частота * операций за такт на ядро по набору инструкций
+ * (два конвейера FMA: AVX-512 - 32, AVX2+FMA - 16, AVX - 8, SSE2 - 4).
+ * Оценка грубая (турбо-частоты, число конвейеров FMA и частота под AVX-512
+ * не учитываются); точное значение задаётся переменной окружения PEAK_GFLOPS.
+ */
+
+#ifndef PEAK_H
+#define PEAK_H
+
+#include "env_info.h"
+
+typedef struct {
+    double gflops;              /* 0 - оценить не удалось */
+    int cores;                  /* Физические ядра маски привязки */
+    int mhz;
+    int flops_per_cycle;        /* Операций double за такт на ядро */
+    char isa[32];
+    char source[32];            /* "estimate" или "PEAK_GFLOPS" */
+} MachinePeak;
+
+/* Оценка по окружению env (маска привязки, SMT, частота) и набору инструкций процессора */
+void peak_estimate(MachinePeak *peak, const EnvInfo *env);
+
+/* Строка "Peak estimate: ..." для заголовка вывода программы */
+void peak_print(const MachinePeak *peak);
+
+/* Доля пика для gflops; -1, если пик неизвестен */
+double peak_fraction(const MachinePeak *peak, double gflops);
+
+#endif /* PEAK_H */
@@ -0,0 +1,125 @@
+/* perf_counters.c
+ * Аппаратные счётчики промахов кэша через perf_event_open (Linux)
+ */
+
+#include "perf_counters.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/* Открытие одного счётчика для вызывающего потока */
+static int open_event(PerfEvent event) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    switch (event) {
+        case PERF_EVENT_CACHE_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case PERF_EVENT_CACHE_REFERENCES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_REFERENCES;
+            break;
+        default:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D
+                        | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+    }
+
+    /* pid = 0, cpu = -1: только текущий поток на любом процессоре */
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+void perf_counters_open(PerfCounters *pc) {
+    memset(pc, 0, sizeof(*pc));
+    pc->nthreads = omp_get_max_threads();
+    pc->fds = (int*)malloc((size_t)pc->nthreads * PERF_EVENT_COUNT * sizeof(int));
+    if (!pc->fds) return;
+    for (int k = 0; k < pc->nthreads * PERF_EVENT_COUNT; k++) pc->fds[k] = -1;
+
+#ifdef __linux__
+    int any = 0;
+    /* Потоки OpenMP переиспользуются между параллельными областями,
+     * поэтому счётчик, открытый потоком здесь, увидит его дальнейшую работу */
+    #pragma omp parallel reduction(|:any)
+    {
+        int tid = omp_get_thread_num();
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            int fd = open_event((PerfEvent)e);
+            pc->fds[tid * PERF_EVENT_COUNT + e] = fd;
+            any |= (fd >= 0);
+        }
+    }
+    pc->available = any;
+#endif
+}
+
+void perf_counters_start(PerfCounters *pc) {
+#ifdef __linux__
+    if (!pc->available) return;
+    for (int k = 0; k < pc->nthreads * PERF_EVENT_COUNT; k++) {
+        if (pc->fds[k] >= 0) {
+            ioctl(pc->fds[k], PERF_EVENT_IOC_RESET, 0);
+            ioctl(pc->fds[k], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    (void)pc;
+#endif
+}
+
+void perf_counters_stop(PerfCounters *pc) {
+#ifdef __linux__
+    if (!pc->available) return;
+    for (int k = 0; k < pc->nthreads * PERF_EVENT_COUNT; k++) {
+        if (pc->fds[k] >= 0) ioctl(pc->fds[k], PERF_EVENT_IOC_DISABLE, 0);
+    }
+#else
+    (void)pc;
+#endif
+}
+
+long long perf_counters_read(const PerfCounters *pc, PerfEvent event) {
+#ifdef __linux__
+    if (!pc->available) return -1;
+    long long total = 0;
+    int found = 0;
+    for (int t = 0; t < pc->nthreads; t++) {
+        int fd = pc->fds[t * PERF_EVENT_COUNT + event];
+        long long value;
+        if (fd >= 0 && read(fd, &value, sizeof(value)) == (ssize_t)sizeof(value)) {
+            total += value;
+            found = 1;
+        }
+    }
+    return found ? total : -1;
+#else
+    (void)pc; (void)event;
+    return -1;
+#endif
+}
+
+void perf_counters_close(PerfCounters *pc) {
+#ifdef __linux__
+    for (int k = 0; pc->fds && k < pc->nthreads * PERF_EVENT_COUNT; k++) {
+        if (pc->fds[k] >= 0) close(pc->fds[k]);
+    }
+#endif
+    free(pc->fds);
+    memset(pc, 0, sizeof(*pc));
+}
@@ -0,0 +1,35 @@
+/* perf_counters.h
+ * Аппаратные счётчики промахов кэша через perf_event_open (Linux).
+ * Счётчики открываются в каждом потоке OpenMP отдельно и суммируются.
+ * Если счётчики недоступны (нет прав, виртуальная машина, не Linux),
+ * available = 0 и все функции становятся пустыми.
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+/* Измеряемые события */
+typedef enum {
+    PERF_EVENT_CACHE_MISSES = 0,    /* Промахи последнего уровня кэша */
+    PERF_EVENT_CACHE_REFERENCES,    /* Обращения к последнему уровню кэша */
+    PERF_EVENT_L1D_READ_MISSES,     /* Промахи чтения L1D */
+    PERF_EVENT_COUNT
+} PerfEvent;
+
+typedef struct {
+    int nthreads;
+    int *fds;               /* nthreads * PERF_EVENT_COUNT, -1 - не открыт */
+    int available;          /* Открылся хотя бы один счётчик */
+} PerfCounters;
+
+/* Открывает счётчики во всех потоках текущей команды OpenMP */
+void perf_counters_open(PerfCounters *pc);
+void perf_counters_start(PerfCounters *pc);
+void perf_counters_stop(PerfCounters *pc);
+
+/* Сумма значения события по всем потокам; -1, если событие недоступно */
+long long perf_counters_read(const PerfCounters *pc, PerfEvent event);
+
+void perf_counters_close(PerfCounters *pc);
+
+#endif /* PERF_COUNTERS_H */
@@ -0,0 +1,134 @@
+/* rapl.c
+ * Счётчики энергии RAPL через Linux powercap
+ */
+
+#include "rapl.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+
+static double rapl_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Целое из файла sysfs; 0 при ошибке (errno сохраняется) */
+static int read_ull(const char *path, unsigned long long *value) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    int ok = fscanf(f, "%llu", value) == 1;
+    fclose(f);
+    return ok;
+}
+
+void rapl_open(RaplCounters *r) {
+    memset(r, 0, sizeof(*r));
+    DIR *dir = opendir(RAPL_SYSFS_ROOT);
+    if (!dir) {
+        snprintf(r->reason, sizeof(r->reason), "no powercap interface at %s", RAPL_SYSFS_ROOT);
+        return;
+    }
+
+    int denied = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && r->ndomains < RAPL_MAX_DOMAINS) {
+        /* intel-rapl:N - пакет, intel-rapl:N:M - его поддомены; intel-rapl-mmio дублирует пакет */
+        if (strncmp(entry->d_name, "intel-rapl:", 11) != 0) continue;
+
+        char path[320], name[64];
+        snprintf(path, sizeof(path), "%s/%s/name", RAPL_SYSFS_ROOT, entry->d_name);
+        FILE *f = fopen(path, "r");
+        if (!f) continue;
+        int ok = fscanf(f, "%63s", name) == 1;
+        fclose(f);
+        if (!ok) continue;
+
+        RaplDomain *d = &r->domains[r->ndomains];
+        if (strncmp(name, "package", 7) == 0) {
+            d->kind = RAPL_PACKAGE;
+        } else if (strcmp(name, "dram") == 0) {
+            d->kind = RAPL_DRAM;
+        } else {
+            continue;       /* core, uncore, psys */
+        }
+
+        snprintf(d->path, sizeof(d->path), "%s/%s/energy_uj", RAPL_SYSFS_ROOT, entry->d_name);
+        snprintf(path, sizeof(path), "%s/%s/max_energy_range_uj", RAPL_SYSFS_ROOT, entry->d_name);
+        unsigned long long probe;
+        if (!read_ull(d->path, &probe)) {
+            if (errno == EACCES || errno == EPERM) denied = 1;
+            continue;
+        }
+        if (!read_ull(path, &d->max_range_uj)) d->max_range_uj = 0;
+        if (d->kind == RAPL_PACKAGE) r->available = 1;
+        r->ndomains++;
+    }
+    closedir(dir);
+
+    if (!r->available) {
+        r->ndomains = 0;
+        snprintf(r->reason, sizeof(r->reason), "%s",
+                 denied ? "permission denied reading energy_uj (root or a readable powercap required)"
+                        : "no readable RAPL package domain");
+    }
+}
+
+void rapl_start(RaplCounters *r) {
+    if (!r->available) return;
+    for (int k = 0; k < r->ndomains; k++) {
+        if (!read_ull(r->domains[k].path, &r->domains[k].start_uj)) r->domains[k].start_uj = 0;
+    }
+    r->start_time = rapl_now();
+}
+
+void rapl_stop(RaplCounters *r) {
+    if (!r->available) return;
+    r->seconds += rapl_now() - r->start_time;
+    for (int k = 0; k < r->ndomains; k++) {
+        RaplDomain *d = &r->domains[k];
+        unsigned long long end;
+        if (!read_ull(d->path, &end)) continue;
+        /* Счётчик перешёл через max_energy_range_uj и начался с нуля */
+        unsigned long long delta = end >= d->start_uj ? end - d->start_uj
+                                                      : end + d->max_range_uj - d->start_uj;
+        d->joules += delta * 1e-6;
+    }
+}
+
+double rapl_joules(const RaplCounters *r, RaplKind kind) {
+    double sum = 0.0;
+    int found = 0;
+    for (int k = 0; k < r->ndomains; k++) {
+        if (r->domains[k].kind != kind) continue;
+        sum += r->domains[k].joules;
+        found = 1;
+    }
+    return found ? sum : -1.0;
+}
+
+void rapl_print(const RaplCounters *r, double work, const char *unit) {
+    printf("\n=== Energy (RAPL) ===\n");
+    if (!r->available) {
+        printf("Not measured: %s\n", r->reason);
+        printf("=====================\n\n");
+        return;
+    }
+    double package = rapl_joules(r, RAPL_PACKAGE);
+    double dram = rapl_joules(r, RAPL_DRAM);
+    double total = package + (dram > 0.0 ? dram : 0.0);
+    printf("Measured time:    %.6f seconds\n", r->seconds);
+    printf("Package energy:   %.3f J (%.2f W)\n", package, r->seconds > 0.0 ? package / r->seconds : 0.0);
+    if (dram >= 0.0) {
+        printf("DRAM energy:      %.3f J (%.2f W)\n", dram, r->seconds > 0.0 ? dram / r->seconds : 0.0);
+    } else {
+        printf("DRAM energy:      not available\n");
+    }
+    if (work > 0.0) {
+        printf("Energy per %s: %.3e J (%.3e %ss per J)\n", unit, total / work, total > 0.0 ? work / total : 0.0, unit);
+    }
+    printf("=====================\n\n");
+}
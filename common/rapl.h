@@ -0,0 +1,56 @@
+/* rapl.h
+ * Энергия процессора и памяти по счётчикам RAPL через Linux powercap
+ * (/sys/class/powercap/intel-rapl:*). Счётчики пакетов (package-N) и их
+ * поддомены памяти (dram) читаются до и после замеряемой области; переполнение
+ * счётчика учитывается по max_energy_range_uj. Если счётчиков нет или нет прав
+ * на чтение (energy_uj с ядра 5.10 доступен только root), available = 0
+ * и все функции становятся пустыми.
+ */
+
+#ifndef RAPL_H
+#define RAPL_H
+
+#ifndef RAPL_SYSFS_ROOT
+#define RAPL_SYSFS_ROOT "/sys/class/powercap"
+#endif
+
+#define RAPL_MAX_DOMAINS 16
+
+typedef enum {
+    RAPL_PACKAGE = 0,       /* Весь пакет процессора: ядра, кэши, контроллер памяти */
+    RAPL_DRAM = 1           /* Модули памяти пакета */
+} RaplKind;
+
+typedef struct {
+    char path[320];                 /* Файл energy_uj */
+    RaplKind kind;
+    unsigned long long max_range_uj;
+    unsigned long long start_uj;
+    double joules;                  /* Накоплено за все интервалы */
+} RaplDomain;
+
+typedef struct {
+    RaplDomain domains[RAPL_MAX_DOMAINS];
+    int ndomains;
+    int available;                  /* Читается хотя бы один домен пакета */
+    double seconds;                 /* Суммарная длительность интервалов */
+    double start_time;
+    char reason[160];               /* Почему недоступно */
+} RaplCounters;
+
+/* Находит читаемые домены; при недоступности заполняет reason */
+void rapl_open(RaplCounters *r);
+
+/* Интервал замера; энергия и время нескольких интервалов суммируются.
+ * Интервал не должен быть длиннее одного оборота счётчика (минуты при полной нагрузке) */
+void rapl_start(RaplCounters *r);
+void rapl_stop(RaplCounters *r);
+
+/* Сумма по доменам вида kind, Дж; -1, если таких доменов нет */
+double rapl_joules(const RaplCounters *r, RaplKind kind);
+
+/* Раздел "=== Energy (RAPL) ===": джоули, средняя мощность и энергия на единицу работы
+ * (work единиц с именем unit за все интервалы) */
+void rapl_print(const RaplCounters *r, double work, const char *unit);
+
+#endif /* RAPL_H */
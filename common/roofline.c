@@ -0,0 +1,142 @@
+/* roofline.c
+ * Чтение характеристики машины и место ядра на roofline
+ */
+
+#include "roofline.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char *const roofline_level_names[ROOFLINE_LEVELS] = {"L1", "L2", "L3", "DRAM"};
+
+/* Строка CSV характеристики (метка времени без кавычек и запятых) */
+typedef struct {
+    char env_hash[17];
+    int threads;
+    char metric[24];
+    double working_set;
+    double value;
+} RooflineRow;
+
+static int parse_row(const char *line, RooflineRow *row) {
+    char stamp[64];
+    return sscanf(line, "%63[^,],%16[^,],%d,%23[^,],%lf,%lf",
+                  stamp, row->env_hash, &row->threads, row->metric, &row->working_set, &row->value) == 6;
+}
+
+void roofline_load(Roofline *r, const char *path, int threads) {
+    memset(r, 0, sizeof(*r));
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        snprintf(r->reason, sizeof(r->reason), "no machine characterization at %s (run bench/scripts/run_roofline.sh)", path);
+        return;
+    }
+
+    /* Первый проход: число потоков - равное threads, иначе ближайшее меньшее, иначе наименьшее */
+    char line[512];
+    RooflineRow row;
+    int below = 0, above = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (!parse_row(line, &row)) continue;
+        if (row.threads <= threads && row.threads > below) below = row.threads;
+        if (row.threads > threads && (above == 0 || row.threads < above)) above = row.threads;
+    }
+    r->threads = below > 0 ? below : above;
+    if (r->threads == 0) {
+        fclose(f);
+        snprintf(r->reason, sizeof(r->reason), "no rows in %s", path);
+        return;
+    }
+
+    rewind(f);
+    while (fgets(line, sizeof(line), f)) {
+        if (!parse_row(line, &row) || row.threads != r->threads) continue;
+        snprintf(r->env_hash, sizeof(r->env_hash), "%s", row.env_hash);
+        if (strncmp(row.metric, "fma_", 4) == 0) {
+            if (row.value > r->peak_gflops) {
+                r->peak_gflops = row.value;
+                snprintf(r->peak_metric, sizeof(r->peak_metric), "%s", row.metric);
+            }
+            continue;
+        }
+        for (int l = 0; l < ROOFLINE_LEVELS; l++) {
+            if (strncmp(row.metric, "bw_", 3) == 0 && strcmp(row.metric + 3, roofline_level_names[l]) == 0) {
+                r->bandwidth[l] = row.value;
+                r->working_set[l] = row.working_set;
+            }
+        }
+    }
+    fclose(f);
+
+    if (r->peak_gflops <= 0.0 || r->bandwidth[ROOFLINE_LEVELS - 1] <= 0.0) {
+        snprintf(r->reason, sizeof(r->reason), "incomplete characterization in %s", path);
+        return;
+    }
+    r->available = 1;
+}
+
+void roofline_report(const Roofline *r, const char *kernel, int nthreads, double flops, double bytes,
+                     double seconds, double working_set, const char *env_hash, const char *csv_path) {
+    printf("\n=== Roofline ===\n");
+    if (!r->available) {
+        printf("Not placed: %s\n", r->reason);
+        printf("================\n\n");
+        return;
+    }
+
+    /* Наименьший измеренный уровень, в рабочий набор триады которого помещается ядро */
+    int level = ROOFLINE_LEVELS - 1;
+    for (int l = 0; l < ROOFLINE_LEVELS - 1; l++) {
+        if (r->bandwidth[l] > 0.0 && working_set <= r->working_set[l]) {
+            level = l;
+            break;
+        }
+    }
+    double bw = r->bandwidth[level];
+    double intensity = bytes > 0.0 ? flops / bytes : 0.0;
+    double ridge = r->peak_gflops / bw;
+    double memory_roof = intensity * bw;
+    double attainable = (bytes > 0.0 && memory_roof < r->peak_gflops) ? memory_roof : r->peak_gflops;
+    double achieved = seconds > 0.0 ? flops / seconds * 1e-9 : 0.0;
+    int memory_bound = bytes > 0.0 && intensity < ridge;
+
+    printf("Machine (%d threads): peak %.1f GFLOP/s (%s), bandwidth", r->threads, r->peak_gflops, r->peak_metric);
+    for (int l = 0; l < ROOFLINE_LEVELS; l++) {
+        if (r->bandwidth[l] > 0.0) printf(" %s %.1f", roofline_level_names[l], r->bandwidth[l]);
+    }
+    printf(" GB/s\n");
+    if (r->threads != nthreads) {
+        printf("Note: characterized for %d threads, kernel ran with %d\n", r->threads, nthreads);
+    }
+    if (strcmp(r->env_hash, env_hash) != 0) {
+        printf("Note: characterized in environment %s, kernel ran in %s\n", r->env_hash, env_hash);
+    }
+    printf("Kernel: %s, %.3e flops, %.3e bytes, intensity %.3f flop/byte\n", kernel, flops, bytes, intensity);
+    printf("Working set: %.1f KB per thread -> %s (ridge point %.3f flop/byte)\n",
+           working_set / 1024.0, roofline_level_names[level], ridge);
+    printf("Attainable: %.2f GFLOP/s (%s-bound)\n", attainable, memory_bound ? "memory" : "compute");
+    printf("Achieved:   %.2f GFLOP/s (%.2f%% of attainable)\n", achieved,
+           attainable > 0.0 ? 100.0 * achieved / attainable : 0.0);
+    printf("================\n\n");
+
+    if (!csv_path) return;
+    FILE *test = fopen(csv_path, "r");
+    int file_exists = (test != NULL);
+    if (test) fclose(test);
+    FILE *f = fopen(csv_path, "a");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s for writing\n", csv_path);
+        return;
+    }
+    if (!file_exists) {
+        fprintf(f, "kernel,nthreads,flops,bytes,intensity,working_set,level,peak_gflops,bandwidth_gbs,"
+                   "attainable_gflops,achieved_gflops,fraction_of_attainable,bound,roofline_threads,env_hash\n");
+    }
+    fprintf(f, "%s,%d,%.0f,%.0f,%.6f,%.0f,%s,%.3f,%.3f,%.3f,%.3f,%.6f,%s,%d,%s\n",
+            kernel, nthreads, flops, bytes, intensity, working_set, roofline_level_names[level],
+            r->peak_gflops, bw, attainable, achieved, attainable > 0.0 ? achieved / attainable : 0.0,
+            memory_bound ? "memory" : "compute", r->threads, env_hash);
+    fclose(f);
+    printf("Roofline placement written to %s\n", csv_path);
+}
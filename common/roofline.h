@@ -0,0 +1,40 @@
+/* roofline.h
+ * Модель roofline машины и место ядер заданий на ней.
+ * Характеристику снимает bench/scripts/roofline для каждого числа потоков:
+ * пик FMA (скалярный, AVX2, AVX-512) и пропускную способность триады
+ * (как в STREAM) с рабочим набором в L1, L2, L3 и в памяти. Задания читают
+ * файл характеристики и по операциям, байтам и рабочему набору своего ядра
+ * считают достижимую производительность min(пик, AI * полоса уровня).
+ */
+
+#ifndef ROOFLINE_H
+#define ROOFLINE_H
+
+#define ROOFLINE_CSV_PATH "./bench/data/roofline.csv"
+#define ROOFLINE_CSV_HEADER "timestamp,env_hash,threads,metric,working_set_bytes,value"
+
+#define ROOFLINE_LEVELS 4           /* L1, L2, L3, DRAM */
+
+extern const char *const roofline_level_names[ROOFLINE_LEVELS];
+
+typedef struct {
+    int available;
+    int threads;                    /* Число потоков строк характеристики */
+    double peak_gflops;             /* Лучший из пиков FMA */
+    char peak_metric[24];
+    double bandwidth[ROOFLINE_LEVELS];      /* ГБ/с, 0 - уровень не измерен */
+    double working_set[ROOFLINE_LEVELS];    /* Рабочий набор триады на поток, байты */
+    char env_hash[17];
+    char reason[160];               /* Почему недоступно */
+} Roofline;
+
+/* Строки path для числа потоков threads или ближайшего меньшего (иначе наименьшего) */
+void roofline_load(Roofline *r, const char *path, int threads);
+
+/* Ядро на roofline: flops операций и bytes байтов за seconds, рабочий набор
+ * на поток working_set байтов выбирает уровень памяти. Печатает раздел "=== Roofline ==="
+ * и дописывает строку в csv_path (NULL - без записи); env_hash - окружение замера ядра */
+void roofline_report(const Roofline *r, const char *kernel, int nthreads, double flops, double bytes,
+                     double seconds, double working_set, const char *env_hash, const char *csv_path);
+
+#endif /* ROOFLINE_H */
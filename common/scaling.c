@@ -0,0 +1,74 @@
+/* scaling.c
+ * Ускорение, эффективность и последовательная доля Карпа-Флатта
+ */
+
+#include "scaling.h"
+
+#include <stdlib.h>
+
+int scaling_parse_threads(const char *list, int *threads, int max) {
+    int count = 0;
+    threads[count++] = 1;
+
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long value = strtol(p, &end, 10);
+        if (end == p || value <= 0 || value > 4096 || (*end != ',' && *end != '\0')) return 0;
+
+        /* Вставка с сохранением порядка, повторы пропускаются */
+        int pos = 0;
+        while (pos < count && threads[pos] < value) pos++;
+        if (pos == count || threads[pos] != value) {
+            if (count == max) return 0;
+            for (int k = count; k > pos; k--) threads[k] = threads[k - 1];
+            threads[pos] = (int)value;
+            count++;
+        }
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return count;
+}
+
+void scaling_compute(ScalingPoint *points, int npoints) {
+    double base = points[0].avg_time;
+    for (int k = 0; k < npoints; k++) {
+        ScalingPoint *pt = &points[k];
+        double p = pt->threads;
+        pt->speedup = pt->avg_time > 0.0 ? base / pt->avg_time : 0.0;
+        pt->efficiency = pt->speedup / p;
+        pt->serial_fraction = (pt->threads > 1 && pt->speedup > 0.0)
+                              ? (1.0 / pt->speedup - 1.0 / p) / (1.0 - 1.0 / p) : 0.0;
+    }
+}
+
+void scaling_print(const ScalingPoint *points, int npoints, int cpus) {
+    int oversubscribed = 0;
+    printf("\n=== Thread Scaling ===\n");
+    printf("Threads    Avg time (s)    Min time (s)    Speedup    Efficiency    Serial fraction\n");
+    for (int k = 0; k < npoints; k++) {
+        const ScalingPoint *pt = &points[k];
+        int over = cpus > 0 && pt->threads > cpus;
+        oversubscribed |= over;
+        printf("%7d%c   %12.6f    %12.6f    %7.3f    %9.2f%%    ",
+               pt->threads, over ? '*' : ' ', pt->avg_time, pt->min_time, pt->speedup, 100.0 * pt->efficiency);
+        if (pt->threads > 1) {
+            printf("%15.4f\n", pt->serial_fraction);
+        } else {
+            printf("%15s\n", "-");
+        }
+    }
+    if (oversubscribed) {
+        printf("* more threads than the %d CPUs in the affinity mask\n", cpus);
+    }
+    printf("======================\n\n");
+}
+
+void scaling_csv_write(FILE *f, const ScalingPoint *point) {
+    if (!point) {
+        fprintf(f, ",,");
+        return;
+    }
+    fprintf(f, "%.6f,%.6f,", point->speedup, point->efficiency);
+    if (point->threads > 1) fprintf(f, "%.6f", point->serial_fraction);
+}
@@ -0,0 +1,43 @@
+/* scaling.h
+ * Масштабирование по числу потоков внутри одного процесса (--sweep).
+ * Замеряемая область повторяется для списка чисел потоков без повторного
+ * чтения входа и выделения памяти; по средним временам считаются ускорение
+ * S(p) = T(1) / T(p), эффективность E(p) = S(p) / p и экспериментальная
+ * последовательная доля Карпа-Флатта e(p) = (1/S - 1/p) / (1 - 1/p).
+ * Рост e(p) с p указывает на накладные расходы распараллеливания,
+ * постоянное e(p) - на последовательную часть программы.
+ */
+
+#ifndef SCALING_H
+#define SCALING_H
+
+#include <stdio.h>
+
+#define SCALING_MAX_POINTS 64
+
+/* Столбцы масштабирования в *_performance.csv (пустые вне --sweep) */
+#define SCALING_CSV_HEADER "speedup,efficiency,serial_fraction"
+
+typedef struct {
+    int threads;
+    double min_time;
+    double avg_time;
+    double speedup;
+    double efficiency;
+    double serial_fraction;     /* Не определена для одного потока */
+} ScalingPoint;
+
+/* Список "1,2,4,8" в возрастающем порядке без повторов; 1 добавляется,
+ * если его нет (база ускорения). Возвращает число элементов, 0 при ошибке */
+int scaling_parse_threads(const char *list, int *threads, int max);
+
+/* Ускорение, эффективность и доля Карпа-Флатта; points[0] - один поток */
+void scaling_compute(ScalingPoint *points, int npoints);
+
+/* Раздел "=== Thread Scaling ===": строки с числом потоков больше cpus помечены */
+void scaling_print(const ScalingPoint *points, int npoints, int cpus);
+
+/* Значения столбцов SCALING_CSV_HEADER (без запятых по краям); point = NULL - пустые */
+void scaling_csv_write(FILE *f, const ScalingPoint *point);
+
+#endif /* SCALING_H */
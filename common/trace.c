@@ -0,0 +1,157 @@
+/* trace.c
+ * Кольцевые буферы событий фаз по потокам и запись в Chrome trace-event JSON
+ */
+
+#include "trace.h"
+
+#ifdef ENABLE_TRACE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define TRACE_MAX_DEPTH 64          /* Вложенность фаз при проверке пар начало/конец */
+
+typedef struct {
+    const char *name;
+    long long ts_ns;
+    char phase;                     /* 'B' - начало, 'E' - конец */
+} TraceEvent;
+
+typedef struct {
+    TraceEvent *events;             /* TRACE_RING_EVENTS событий */
+    long long count;                /* Всего записано (в кольце - последние) */
+    int tid;
+} TraceBuffer;
+
+static TraceBuffer *trace_buffers[TRACE_MAX_THREADS];
+static int trace_nbuffers = 0;
+static _Thread_local TraceBuffer *trace_local = NULL;
+static _Thread_local int trace_local_lost = 0;
+static char trace_path[512];
+static long long trace_t0 = 0;
+
+static long long trace_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+/* Кольцо вызывающего потока; создаётся при первом событии потока */
+static TraceBuffer *trace_thread_buffer(void) {
+    if (trace_local || trace_local_lost) return trace_local;
+    int id = __atomic_fetch_add(&trace_nbuffers, 1, __ATOMIC_RELAXED);
+    TraceBuffer *b = NULL;
+    if (id < TRACE_MAX_THREADS) {
+        b = (TraceBuffer*)calloc(1, sizeof(TraceBuffer));
+        if (b) b->events = (TraceEvent*)malloc(TRACE_RING_EVENTS * sizeof(TraceEvent));
+        if (b && !b->events) {
+            free(b);
+            b = NULL;
+        }
+    }
+    if (!b) {
+        trace_local_lost = 1;
+        return NULL;
+    }
+    b->tid = id;
+    __atomic_store_n(&trace_buffers[id], b, __ATOMIC_RELEASE);
+    trace_local = b;
+    return b;
+}
+
+static inline void trace_record(const char *name, char phase) {
+    TraceBuffer *b = trace_thread_buffer();
+    if (!b) return;
+    TraceEvent *e = &b->events[b->count & (TRACE_RING_EVENTS - 1)];
+    e->name = name;
+    e->ts_ns = trace_now_ns();
+    e->phase = phase;
+    b->count++;
+}
+
+void trace_begin(const char *name) {
+    trace_record(name, 'B');
+}
+
+void trace_end(const char *name) {
+    trace_record(name, 'E');
+}
+
+static void trace_write_event(FILE *f, int *first, const char *name, char phase, long long ts_ns, int tid) {
+    fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"phase\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+            *first ? "" : ",", name, phase, (ts_ns - trace_t0) / 1000.0, tid);
+    *first = 0;
+}
+
+/* --- Запись всех колец при выходе ---
+ * Из затёртой части кольца могут остаться концы фаз без начала - они пропускаются;
+ * фазы без конца закрываются последним временем потока */
+static void trace_dump(void) {
+    FILE *f = fopen(trace_path, "w");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s for writing\n", trace_path);
+        return;
+    }
+    int nthreads = __atomic_load_n(&trace_nbuffers, __ATOMIC_ACQUIRE);
+    if (nthreads > TRACE_MAX_THREADS) nthreads = TRACE_MAX_THREADS;
+
+    long long written = 0, overwritten = 0;
+    int first = 1;
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (int t = 0; t < nthreads; t++) {
+        const TraceBuffer *b = __atomic_load_n(&trace_buffers[t], __ATOMIC_ACQUIRE);
+        if (!b) continue;
+        fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                   "\"args\":{\"name\":\"thread %d%s\"}}",
+                first ? "" : ",", b->tid, b->tid, b->tid == 0 ? " (main)" : "");
+        first = 0;
+
+        long long kept = b->count < TRACE_RING_EVENTS ? b->count : TRACE_RING_EVENTS;
+        overwritten += b->count - kept;
+        const char *open[TRACE_MAX_DEPTH];
+        int depth = 0;
+        long long last_ts = trace_t0;
+        for (long long k = b->count - kept; k < b->count; k++) {
+            const TraceEvent *e = &b->events[k & (TRACE_RING_EVENTS - 1)];
+            last_ts = e->ts_ns;
+            if (e->phase == 'B') {
+                if (depth < TRACE_MAX_DEPTH) open[depth] = e->name;
+                depth++;
+            } else {
+                if (depth == 0) continue;
+                depth--;
+            }
+            trace_write_event(f, &first, e->name, e->phase, e->ts_ns, b->tid);
+            written++;
+        }
+        while (depth > 0) {
+            depth--;
+            trace_write_event(f, &first, depth < TRACE_MAX_DEPTH ? open[depth] : "unknown", 'E',
+                              last_ts, b->tid);
+            written++;
+        }
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    printf("Trace written to %s (%lld events, %d threads", trace_path, written, nthreads);
+    if (overwritten > 0) printf(", %lld oldest events overwritten", overwritten);
+    printf(")\n");
+}
+
+void trace_init(const char *default_path) {
+    const char *env = getenv("TRACE_FILE");
+    snprintf(trace_path, sizeof(trace_path), "%s", env && *env ? env : default_path);
+    trace_t0 = trace_now_ns();
+    /* Главный поток получает номер 0 */
+    trace_thread_buffer();
+    atexit(trace_dump);
+}
+
+#else
+
+/* Без -DENABLE_TRACE модуль пуст */
+typedef int trace_disabled;
+
+#endif /* ENABLE_TRACE */
@@ -0,0 +1,38 @@
+/* trace.h
+ * Временная шкала фаз по потокам в формате Chrome trace-event
+ * (chrome://tracing, ui.perfetto.dev).
+ * Включается при компиляции с -DENABLE_TRACE, иначе макросы TRACE_* пусты
+ * и код программы не меняется. Каждый поток пишет события начала и конца
+ * фазы в свой кольцевой буфер без блокировок; при выходе из программы
+ * буферы всех потоков сбрасываются в один JSON-файл.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#define TRACE_RING_EVENTS 65536     /* Событий в кольце потока (степень двойки), старые затираются */
+#define TRACE_MAX_THREADS 256       /* Потоков с собственным кольцом, события остальных теряются */
+
+#ifdef ENABLE_TRACE
+
+/* Путь файла - переменная окружения TRACE_FILE или default_path;
+ * регистрирует запись файла при выходе (atexit). Вызывается первым в main */
+void trace_init(const char *default_path);
+
+/* Начало и конец фазы в вызывающем потоке; name - строковая константа */
+void trace_begin(const char *name);
+void trace_end(const char *name);
+
+#define TRACE_INIT(path) trace_init(path)
+#define TRACE_BEGIN(name) trace_begin(name)
+#define TRACE_END(name) trace_end(name)
+
+#else
+
+#define TRACE_INIT(path) ((void)0)
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END(name) ((void)0)
+
+#endif /* ENABLE_TRACE */
+
+#endif /* TRACE_H */
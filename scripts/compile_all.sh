@@ -14,8 +14,8 @@ fi
 
 # Task 1: Mandelbrot (OpenMP)
 echo ""
-echo "[1/5] Компиляция Task1 (Mandelbrot OpenMP)..."
-gcc -fopenmp -O3 -o task1/scripts/task1 task1/scripts/task1.c -lm
+echo "[1/11] Компиляция Task1 (Mandelbrot OpenMP)..."
+gcc -fopenmp -O3 -o task1/scripts/task1 task1/scripts/task1.c task1/scripts/pyramid.c task1/scripts/contour.c task1/scripts/escape_stream.c common/trace.c common/env_info.c common/rapl.c common/scaling.c common/peak.c common/roofline.c common/mem_profile.c -lm
 if [ $? -eq 0 ]; then
     echo "✓ Task1 скомпилирована успешно"
 else
@@ -24,17 +24,48 @@ fi
 
 # Task 2: N-body (OpenMP)
 echo ""
-echo "[2/5] Компиляция Task2 (N-body OpenMP)..."
-gcc -fopenmp -O3 -o task2/scripts/task2 task2/scripts/task2.c -lm
+echo "[2/11] Компиляция Task2 (N-body OpenMP)..."
+gcc -fopenmp -O3 -o task2/scripts/task2 task2/scripts/task2.c task2/scripts/nbody.c task2/scripts/wisdom_holman.c task2/scripts/test_particles.c task2/scripts/sfc_reorder.c task2/scripts/particle_mesh.c task2/scripts/cell_list.c task2/scripts/ewald.c task2/scripts/render.c task2/scripts/fof.c task2/scripts/traj_store.c task2/scripts/regularization.c common/perf_counters.c common/trace.c common/env_info.c common/rapl.c common/scaling.c common/peak.c common/roofline.c common/mem_profile.c -lm
 if [ $? -eq 0 ]; then
     echo "✓ Task2 OpenMP скомпилирована успешно"
 else
     echo "✗ Ошибка компиляции Task2 OpenMP"
 fi
 
+# Task 2: выборки из столбцового хранилища траекторий
+echo ""
+echo "[3/11] Компиляция traj_query (trajectory store queries)..."
+gcc -O3 -o task2/scripts/traj_query task2/scripts/traj_query.c
+if [ $? -eq 0 ]; then
+    echo "✓ traj_query скомпилирована успешно"
+else
+    echo "✗ Ошибка компиляции traj_query"
+fi
+
+# Task 2: встраиваемая библиотека движка
+echo ""
+echo "[4/11] Компиляция libnbody (embeddable N-body library)..."
+gcc -fopenmp -O3 -fPIC -shared -o task2/scripts/libnbody.so task2/scripts/libnbody.c task2/scripts/nbody.c task2/scripts/wisdom_holman.c task2/scripts/test_particles.c task2/scripts/particle_mesh.c task2/scripts/cell_list.c task2/scripts/ewald.c common/trace.c -lm
+if [ $? -eq 0 ]; then
+    echo "✓ libnbody скомпилирована успешно"
+else
+    echo "✗ Ошибка компиляции libnbody"
+fi
+
+# Task 2: сервис симуляций на Unix-сокете и его клиент
+echo ""
+echo "[5/11] Компиляция nbody_service и nbody_client (simulation service)..."
+gcc -fopenmp -O3 -pthread -o task2/scripts/nbody_service task2/scripts/nbody_service.c task2/scripts/libnbody.c task2/scripts/nbody.c task2/scripts/wisdom_holman.c task2/scripts/test_particles.c task2/scripts/particle_mesh.c task2/scripts/cell_list.c task2/scripts/ewald.c common/trace.c -lm && \
+    gcc -O3 -o task2/scripts/nbody_client task2/scripts/nbody_client.c
+if [ $? -eq 0 ]; then
+    echo "✓ nbody_service и nbody_client скомпилированы успешно"
+else
+    echo "✗ Ошибка компиляции nbody_service / nbody_client"
+fi
+
 # Task 2: N-body (CUDA) - опционально
 echo ""
-echo "[3/5] Компиляция Task2 (N-body CUDA)..."
+echo "[6/11] Компиляция Task2 (N-body CUDA)..."
 if command -v nvcc &> /dev/null; then
     nvcc -O3 -o task2/scripts/task2_cuda task2/scripts/task2_cuda.cu -lm
     if [ $? -eq 0 ]; then
@@ -48,9 +79,9 @@ fi
 
 # Task 3: RWLock (пользовательская)
 echo ""
-echo "[4/5] Компиляция Task3 (Custom RWLock)..."
+echo "[7/11] Компиляция Task3 (Custom RWLock)..."
 gcc -pthread -O3 -o task3/scripts/task3_my_rwlock \
-    task3/scripts/task3_my_rwlock.c task3/scripts/my_rwlock.c -lm
+    task3/scripts/task3_my_rwlock.c task3/scripts/my_rwlock.c common/rapl.c common/mem_profile.c common/env_info.c -lm
 if [ $? -eq 0 ]; then
     echo "✓ Task3 Custom RWLock скомпилирована успешно"
 else
@@ -59,15 +90,45 @@ fi
 
 # Task 3: RWLock (библиотечная)
 echo ""
-echo "[5/5] Компиляция Task3 (Pthread RWLock)..."
+echo "[8/11] Компиляция Task3 (Pthread RWLock)..."
 gcc -pthread -O3 -o task3/scripts/task3_pthread_rwlock \
-    task3/scripts/task3_pthread_rwlock.c -lm
+    task3/scripts/task3_pthread_rwlock.c common/rapl.c common/mem_profile.c common/env_info.c -lm
 if [ $? -eq 0 ]; then
     echo "✓ Task3 Pthread RWLock скомпилирована успешно"
 else
     echo "✗ Ошибка компиляции Task3 Pthread"
 fi
 
+# Микробенчмарки ядер всех заданий
+echo ""
+echo "[9/11] Компиляция microbench (kernel microbenchmarks)..."
+gcc -fopenmp -O3 -pthread -o bench/scripts/microbench bench/scripts/microbench.c task2/scripts/nbody.c task3/scripts/my_rwlock.c common/trace.c common/env_info.c -lm
+if [ $? -eq 0 ]; then
+    echo "✓ microbench скомпилирована успешно"
+else
+    echo "✗ Ошибка компиляции microbench"
+fi
+
+# Сравнение регрессионных прогонов с базовым
+echo ""
+echo "[10/11] Компиляция regress (benchmark regression check)..."
+gcc -O3 -o bench/scripts/regress bench/scripts/regress.c -lm
+if [ $? -eq 0 ]; then
+    echo "✓ regress скомпилирована успешно"
+else
+    echo "✗ Ошибка компиляции regress"
+fi
+
+# Характеристика машины для roofline
+echo ""
+echo "[11/11] Компиляция roofline (machine roofline characterization)..."
+gcc -fopenmp -O3 -o bench/scripts/roofline bench/scripts/roofline.c common/env_info.c common/roofline.c -lm
+if [ $? -eq 0 ]; then
+    echo "✓ roofline скомпилирована успешно"
+else
+    echo "✗ Ошибка компиляции roofline"
+fi
+
 echo ""
 echo "======================================"
 echo "Компиляция завершена!"
@@ -76,12 +137,21 @@ echo ""
 echo "Доступные команды для запуска:"
 echo "  Task 1: ./task1/scripts/task1 <threads> <npoints>"
 echo "  Task 2: ./task2/scripts/task2 <threads> <tend> <input_file>"
+echo "  Task 2 queries: ./task2/scripts/traj_query <trajectory.nbt> [--bodies list] [--from t] [--to t]"
+echo "  Task 2 service: ./task2/scripts/nbody_service <socket> <thread_budget>"
+echo "  Task 2 client: ./task2/scripts/nbody_client <socket> submit <threads> <tend> <input_file> | stats | shutdown"
 echo "  Task 2 CUDA: ./task2/scripts/task2_cuda <tend> <input_file>"
 echo "  Task 3 Custom: ./task3/scripts/task3_my_rwlock <threads>"
 echo "  Task 3 Pthread: ./task3/scripts/task3_pthread_rwlock <threads>"
+echo "  Microbenchmarks: ./bench/scripts/microbench <max_threads> [--filter kernel]"
+echo "  Regression check: ./bench/scripts/regress <baseline.csv> <current.csv> [--report file]"
+echo "  Roofline: ./bench/scripts/roofline <max_threads> [--samples K]"
 echo ""
 echo "Или используйте скрипты бенчмарков:"
 echo "  ./task1/scripts/run_benchmarks.sh"
 echo "  ./task2/scripts/run_benchmarks.sh"
 echo "  ./task2/scripts/run_benchmarks_cuda.sh"
 echo "  ./task3/scripts/run_comparison.sh"
+echo "  ./bench/scripts/run_microbench.sh"
+echo "  ./bench/scripts/run_regression.sh [run_id] [baseline_run_id]"
+echo "  ./bench/scripts/run_roofline.sh"
@@ -0,0 +1,416 @@
+/* contour.c
+ * Извлечение границы множества Мандельброта в виде ломаных (marching squares)
+ */
+
+#include "contour.h"
+#include "mandelbrot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <omp.h>
+
+/* --- Таблица marching squares --- */
+/* Углы ячейки (i,j): p0=(i,j), p1=(i+1,j), p2=(i+1,j+1), p3=(i,j+1); бит k кода - угол pk.
+ * Рёбра: 0 - нижнее (p0-p1), 1 - правое (p1-p2), 2 - верхнее (p2-p3), 3 - левое (p3-p0).
+ * В седловых случаях 5 и 10 внутренние углы считаются разделёнными. */
+static const int CASE_NSEG[16] = { 0, 1, 1, 1, 1, 2, 1, 1, 1, 1, 2, 1, 1, 1, 1, 0 };
+static const int CASE_SEG[16][2][2] = {
+    {{0,0},{0,0}}, {{3,0},{0,0}}, {{0,1},{0,0}}, {{3,1},{0,0}},
+    {{1,2},{0,0}}, {{3,0},{1,2}}, {{0,2},{0,0}}, {{3,2},{0,0}},
+    {{2,3},{0,0}}, {{0,2},{0,0}}, {{0,1},{2,3}}, {{1,2},{0,0}},
+    {{1,3},{0,0}}, {{0,1},{0,0}}, {{0,3},{0,0}}, {{0,0},{0,0}}
+};
+
+/* Смещение к соседней ячейке через ребро */
+static const int EDGE_DI[4] = { 0, 1, 0, -1 };
+static const int EDGE_DJ[4] = { -1, 0, 1, 0 };
+
+/* --- Динамический массив 64-битных значений --- */
+typedef struct {
+    long long *data;
+    long long size;
+    long long capacity;
+} I64Vec;
+
+static int vec_push(I64Vec *v, long long value) {
+    if (v->size >= v->capacity) {
+        long long cap = v->capacity ? v->capacity * 2 : 1024;
+        long long *buf = (long long*)realloc(v->data, cap * sizeof(long long));
+        if (!buf) return 0;
+        v->data = buf;
+        v->capacity = cap;
+    }
+    v->data[v->size++] = value;
+    return 1;
+}
+
+/* --- Сетка значений и классификация ячеек --- */
+typedef struct {
+    const uint16_t *iters;  /* Число итераций в узлах (dim x dim, строка = imag) */
+    long long dim;
+    int level;
+} Grid;
+
+static inline int cell_case(const Grid *g, long long i, long long j) {
+    const uint16_t *r0 = g->iters + j * g->dim;
+    const uint16_t *r1 = r0 + g->dim;
+    return (r0[i] >= g->level)
+         | ((r0[i + 1] >= g->level) << 1)
+         | ((r1[i + 1] >= g->level) << 2)
+         | ((r1[i] >= g->level) << 3);
+}
+
+/* Глобальный идентификатор ребра: горизонтальное (i,j)-(i+1,j) -> 2*(j*dim+i),
+ * вертикальное (i,j)-(i,j+1) -> 2*(j*dim+i)+1. Общее ребро соседних ячеек
+ * имеет один и тот же идентификатор, что и позволяет сшивать фрагменты. */
+static inline long long edge_id(long long dim, long long i, long long j, int e) {
+    switch (e) {
+        case 0:  return 2 * (j * dim + i);
+        case 1:  return 2 * (j * dim + i + 1) + 1;
+        case 2:  return 2 * ((j + 1) * dim + i);
+        default: return 2 * (j * dim + i) + 1;
+    }
+}
+
+/* Номер сегмента ячейки, содержащего ребро e (-1, если нет) и второе его ребро */
+static inline int find_segment(int c, int e, int *other) {
+    for (int s = 0; s < CASE_NSEG[c]; s++) {
+        if (CASE_SEG[c][s][0] == e) { *other = CASE_SEG[c][s][1]; return s; }
+        if (CASE_SEG[c][s][1] == e) { *other = CASE_SEG[c][s][0]; return s; }
+    }
+    return -1;
+}
+
+/* --- Фрагменты одного тайла --- */
+typedef struct {
+    I64Vec points;  /* Идентификаторы рёбер вершин всех фрагментов тайла */
+    I64Vec frags;   /* Тройки (смещение, длина, замкнут) */
+    int failed;
+} TileResult;
+
+/* Границы тайла в ячейках */
+typedef struct {
+    long long i0, i1, j0, j1;
+} TileBox;
+
+static inline int in_tile(const TileBox *b, long long i, long long j) {
+    return i >= b->i0 && i < b->i1 && j >= b->j0 && j < b->j1;
+}
+
+/* Обход всех ломаных внутри тайла; ломаная обрывается на границе тайла */
+static void trace_tile(const Grid *g, const TileBox *box, TileResult *res) {
+    long long tw = box->i1 - box->i0;
+    long long th = box->j1 - box->j0;
+    unsigned char *visited = (unsigned char*)calloc((size_t)(tw * th), 1);
+    if (!visited) { res->failed = 1; return; }
+
+#define VISITED(ci, cj) visited[((cj) - box->j0) * tw + ((ci) - box->i0)]
+
+    for (long long j = box->j0; j < box->j1; j++) {
+        for (long long i = box->i0; i < box->i1; i++) {
+            int c = cell_case(g, i, j);
+            for (int s = 0; s < CASE_NSEG[c]; s++) {
+                if (VISITED(i, j) & (1 << s)) continue;
+
+                /* Идём назад до границы тайла/сетки или до замыкания */
+                long long ci = i, cj = j;
+                int cs = s, cc = c;
+                int entry = CASE_SEG[c][s][0];
+                int closed = 0;
+                for (;;) {
+                    long long ni = ci + EDGE_DI[entry], nj = cj + EDGE_DJ[entry];
+                    if (!in_tile(box, ni, nj)) break;
+                    int nc = cell_case(g, ni, nj), other = 0;
+                    int ns = find_segment(nc, (entry + 2) % 4, &other);
+                    if (ni == i && nj == j && ns == s) { closed = 1; break; }
+                    ci = ni; cj = nj; cs = ns; cc = nc;
+                    entry = other;
+                }
+                if (closed) {
+                    ci = i; cj = j; cs = s; cc = c;
+                    entry = CASE_SEG[c][s][0];
+                }
+
+                /* Идём вперёд, записывая рёбра и отмечая сегменты */
+                long long offset = res->points.size;
+                int exit_edge = (CASE_SEG[cc][cs][0] == entry) ? CASE_SEG[cc][cs][1]
+                                                               : CASE_SEG[cc][cs][0];
+                int ok = vec_push(&res->points, edge_id(g->dim, ci, cj, entry));
+                for (;;) {
+                    VISITED(ci, cj) |= (unsigned char)(1 << cs);
+                    ok &= vec_push(&res->points, edge_id(g->dim, ci, cj, exit_edge));
+                    long long ni = ci + EDGE_DI[exit_edge], nj = cj + EDGE_DJ[exit_edge];
+                    if (!in_tile(box, ni, nj)) break;
+                    int nc = cell_case(g, ni, nj), other = 0;
+                    int ns = find_segment(nc, (exit_edge + 2) % 4, &other);
+                    if (VISITED(ni, nj) & (1 << ns)) break;
+                    ci = ni; cj = nj; cs = ns;
+                    exit_edge = other;
+                }
+
+                ok &= vec_push(&res->frags, offset);
+                ok &= vec_push(&res->frags, res->points.size - offset);
+                ok &= vec_push(&res->frags, closed);
+                if (!ok) { res->failed = 1; free(visited); return; }
+            }
+        }
+    }
+
+#undef VISITED
+    free(visited);
+}
+
+/* --- Хеш-таблица концов фрагментов: ребро -> до двух (фрагмент, конец) --- */
+typedef struct {
+    long long key;      /* -1 - пустая ячейка */
+    long long ref[2];   /* 2*фрагмент + конец, -1 - нет */
+} EndSlot;
+
+typedef struct {
+    EndSlot *slots;
+    long long mask;
+} EndTable;
+
+static inline long long hash_edge(long long key) {
+    unsigned long long h = (unsigned long long)key * 0x9E3779B97F4A7C15ULL;
+    return (long long)(h >> 17);
+}
+
+static EndSlot *end_lookup(EndTable *t, long long key, int insert) {
+    long long pos = hash_edge(key) & t->mask;
+    for (;;) {
+        EndSlot *slot = &t->slots[pos];
+        if (slot->key == key) return slot;
+        if (slot->key == -1) {
+            if (!insert) return NULL;
+            slot->key = key;
+            return slot;
+        }
+        pos = (pos + 1) & t->mask;
+    }
+}
+
+/* Парный конец, примыкающий к тому же ребру (-1, если его нет) */
+static long long end_partner(EndTable *t, long long key, long long self) {
+    EndSlot *slot = end_lookup(t, key, 0);
+    if (!slot) return -1;
+    if (slot->ref[0] == self) return slot->ref[1];
+    return slot->ref[0];
+}
+
+/* --- Сшивка фрагментов в ломаные --- */
+/* frags: тройки (смещение, длина, замкнут) в points; результат - out_points и
+ * out_lines (пары: смещение, длина) */
+static int stitch_fragments(const I64Vec *points, const I64Vec *frags,
+                            I64Vec *out_points, I64Vec *out_lines, long long *closed_count) {
+    long long nfrags = frags->size / 3;
+    const long long *F = frags->data;
+    const long long *P = points->data;
+
+    /* Конец end фрагмента f */
+#define FRAG_END(f, end) ((end) == 0 ? P[F[3*(f)]] : P[F[3*(f)] + F[3*(f)+1] - 1])
+
+    long long cap = 16;
+    while (cap < 4 * nfrags) cap *= 2;
+    EndTable table;
+    table.mask = cap - 1;
+    table.slots = (EndSlot*)malloc(cap * sizeof(EndSlot));
+    unsigned char *used = (unsigned char*)calloc((size_t)(nfrags > 0 ? nfrags : 1), 1);
+    if (!table.slots || !used) {
+        free(table.slots); free(used);
+        return 0;
+    }
+    for (long long k = 0; k < cap; k++) {
+        table.slots[k].key = -1;
+        table.slots[k].ref[0] = table.slots[k].ref[1] = -1;
+    }
+
+    for (long long f = 0; f < nfrags; f++) {
+        if (F[3*f + 2]) continue;
+        for (int end = 0; end < 2; end++) {
+            EndSlot *slot = end_lookup(&table, FRAG_END(f, end), 1);
+            slot->ref[slot->ref[0] == -1 ? 0 : 1] = 2 * f + end;
+        }
+    }
+
+    int ok = 1;
+    *closed_count = 0;
+    for (long long f = 0; f < nfrags && ok; f++) {
+        if (used[f]) continue;
+
+        long long cur = f;
+        int beg = 0, closed = (int)F[3*f + 2];
+
+        /* Ищем начало цепочки, двигаясь назад по сшитым концам */
+        if (!closed) {
+            for (long long steps = 0; steps <= nfrags; steps++) {
+                long long p = end_partner(&table, FRAG_END(cur, beg), 2 * cur + beg);
+                if (p < 0) break;
+                if (p / 2 == f) { cur = f; beg = 0; closed = 1; break; }
+                cur = p / 2;
+                beg = 1 - (int)(p % 2);
+            }
+        }
+
+        /* Проходим цепочку вперёд, склеивая фрагменты */
+        long long line_offset = out_points->size;
+        int first = 1;
+        for (;;) {
+            used[cur] = 1;
+            long long off = F[3*cur], len = F[3*cur + 1];
+            for (long long k = first ? 0 : 1; k < len; k++) {
+                ok &= vec_push(out_points, beg == 0 ? P[off + k] : P[off + len - 1 - k]);
+            }
+            first = 0;
+            if (F[3*cur + 2]) break;
+
+            long long p = end_partner(&table, FRAG_END(cur, 1 - beg), 2 * cur + (1 - beg));
+            if (p < 0 || used[p / 2]) break;
+            cur = p / 2;
+            beg = (int)(p % 2);
+        }
+
+        ok &= vec_push(out_lines, line_offset);
+        ok &= vec_push(out_lines, out_points->size - line_offset);
+        if (closed) (*closed_count)++;
+    }
+
+#undef FRAG_END
+    free(table.slots);
+    free(used);
+    return ok;
+}
+
+/* Координаты середины ребра в комплексной плоскости */
+static inline void edge_point(long long dim, long long id, double *re, double *im) {
+    double real_step = (REAL_MAX - REAL_MIN) / (double)dim;
+    double imag_step = (IMAG_MAX - IMAG_MIN) / (double)dim;
+    long long node = id / 2;
+    long long i = node % dim, j = node / dim;
+    if (id % 2 == 0) {
+        *re = REAL_MIN + (i + 0.5) * real_step;
+        *im = IMAG_MIN + j * imag_step;
+    } else {
+        *re = REAL_MIN + i * real_step;
+        *im = IMAG_MIN + (j + 0.5) * imag_step;
+    }
+}
+
+int extract_contours(long long grid_dim, const ContourConfig *cfg,
+                     const char *out_file, ContourStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (grid_dim < 2 || cfg->tile_cells <= 0) {
+        fprintf(stderr, "Error: Invalid contour configuration\n");
+        return 0;
+    }
+
+    long long dim = grid_dim;
+    uint16_t *iters = (uint16_t*)malloc((size_t)dim * dim * sizeof(uint16_t));
+    if (!iters) {
+        fprintf(stderr, "Error: Failed to allocate iteration grid (%lld x %lld)\n", dim, dim);
+        return 0;
+    }
+
+    /* 1. Сетка итераций в тех же узлах, что и при выводе списка точек */
+    double t0 = omp_get_wtime();
+    double real_step = (REAL_MAX - REAL_MIN) / (double)dim;
+    double imag_step = (IMAG_MAX - IMAG_MIN) / (double)dim;
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (long long j = 0; j < dim; j++) {
+        double c_imag = IMAG_MIN + j * imag_step;
+        for (long long i = 0; i < dim; i++) {
+            iters[j * dim + i] = (uint16_t)mandelbrot_iterations(REAL_MIN + i * real_step, c_imag);
+        }
+    }
+    stats->classify_time = omp_get_wtime() - t0;
+
+    /* 2. Фрагменты ломаных по тайлам ячеек */
+    double t1 = omp_get_wtime();
+    Grid g = { iters, dim, cfg->level };
+    long long cells = dim - 1;
+    long long tiles_per_side = (cells + cfg->tile_cells - 1) / cfg->tile_cells;
+    long long ntiles = tiles_per_side * tiles_per_side;
+    TileResult *tiles = (TileResult*)calloc((size_t)ntiles, sizeof(TileResult));
+    if (!tiles) {
+        fprintf(stderr, "Error: Failed to allocate tile results\n");
+        free(iters);
+        return 0;
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long long t = 0; t < ntiles; t++) {
+        TileBox box;
+        box.i0 = (t % tiles_per_side) * cfg->tile_cells;
+        box.j0 = (t / tiles_per_side) * cfg->tile_cells;
+        box.i1 = box.i0 + cfg->tile_cells < cells ? box.i0 + cfg->tile_cells : cells;
+        box.j1 = box.j0 + cfg->tile_cells < cells ? box.j0 + cfg->tile_cells : cells;
+        trace_tile(&g, &box, &tiles[t]);
+    }
+
+    /* Объединяем фрагменты тайлов в порядке тайлов (вывод не зависит от числа потоков) */
+    I64Vec points = {0}, frags = {0};
+    int ok = 1;
+    for (long long t = 0; t < ntiles; t++) {
+        ok &= !tiles[t].failed;
+        long long base = points.size;
+        for (long long k = 0; ok && k < tiles[t].points.size; k++)
+            ok &= vec_push(&points, tiles[t].points.data[k]);
+        for (long long k = 0; ok && k < tiles[t].frags.size; k += 3) {
+            ok &= vec_push(&frags, base + tiles[t].frags.data[k]);
+            ok &= vec_push(&frags, tiles[t].frags.data[k + 1]);
+            ok &= vec_push(&frags, tiles[t].frags.data[k + 2]);
+        }
+        free(tiles[t].points.data);
+        free(tiles[t].frags.data);
+    }
+    free(tiles);
+    stats->trace_time = omp_get_wtime() - t1;
+    stats->fragments = frags.size / 3;
+
+    /* 3. Сшивка фрагментов через швы тайлов */
+    double t2 = omp_get_wtime();
+    I64Vec line_points = {0}, lines = {0};
+    if (ok) {
+        ok = stitch_fragments(&points, &frags, &line_points, &lines, &stats->closed_polylines);
+    }
+    free(points.data);
+    free(frags.data);
+    stats->stitch_time = omp_get_wtime() - t2;
+    stats->polylines = lines.size / 2;
+    stats->points = line_points.size;
+
+    if (!ok) {
+        fprintf(stderr, "Error: Out of memory while building contours\n");
+        free(line_points.data); free(lines.data); free(iters);
+        return 0;
+    }
+
+    /* 4. Запись ломаных: одна строка на вершину, замкнутые повторяют первую вершину */
+    double t3 = omp_get_wtime();
+    FILE *f = fopen(out_file, "w");
+    if (!f) {
+        fprintf(stderr, "Error: Cannot open %s for writing: %s\n", out_file, strerror(errno));
+        free(line_points.data); free(lines.data); free(iters);
+        return 0;
+    }
+    long long bytes = fprintf(f, "polyline,point,real,imaginary\n");
+    for (long long l = 0; l < stats->polylines; l++) {
+        long long off = lines.data[2*l], len = lines.data[2*l + 1];
+        for (long long k = 0; k < len; k++) {
+            double re, im;
+            edge_point(dim, line_points.data[off + k], &re, &im);
+            bytes += fprintf(f, "%lld,%lld,%.15f,%.15f\n", l, k, re, im);
+        }
+    }
+    fclose(f);
+    stats->write_time = omp_get_wtime() - t3;
+    stats->bytes_written = bytes;
+
+    free(line_points.data);
+    free(lines.data);
+    free(iters);
+    return 1;
+}
@@ -0,0 +1,35 @@
+/* contour.h
+ * Извлечение границы множества Мандельброта в виде ломаных (marching squares).
+ * Сетка делится на тайлы, ломаные внутри тайлов строятся параллельно,
+ * затем фрагменты сшиваются по общим рёбрам на границах тайлов.
+ */
+
+#ifndef CONTOUR_H
+#define CONTOUR_H
+
+/* Параметры извлечения */
+typedef struct {
+    int tile_cells;     /* Размер тайла в ячейках сетки */
+    int level;          /* Точка "внутри", если число итераций >= level
+                           (MAX_ITERATIONS - граница самого множества) */
+} ContourConfig;
+
+/* Статистика извлечения */
+typedef struct {
+    long long fragments;        /* Фрагменты до сшивки */
+    long long polylines;        /* Итоговые ломаные */
+    long long closed_polylines; /* Из них замкнутые */
+    long long points;           /* Вершины всех ломаных */
+    long long bytes_written;
+    double classify_time;       /* Вычисление сетки итераций */
+    double trace_time;          /* Построение фрагментов по тайлам */
+    double stitch_time;         /* Сшивка фрагментов */
+    double write_time;
+} ContourStats;
+
+/* Строит контур на сетке grid_dim x grid_dim (те же узлы, что и в result.csv)
+ * и записывает ломаные в out_file. Возвращает 1 при успехе, 0 при ошибке. */
+int extract_contours(long long grid_dim, const ContourConfig *cfg,
+                     const char *out_file, ContourStats *stats);
+
+#endif /* CONTOUR_H */
@@ -0,0 +1,202 @@
+/* escape_stream.c
+ * Пакетное и потоковое векторные ядра классификации точек множества Мандельброта
+ */
+
+#include "escape_stream.h"
+#include "mandelbrot.h"
+
+#include <string.h>
+#include <omp.h>
+
+const char *escape_kernel_name(EscapeKernel kernel) {
+    switch (kernel) {
+        case KERNEL_PACKET: return "packet";
+        case KERNEL_STREAM: return "stream";
+        default: return "scalar";
+    }
+}
+
+/* Состояние дорожек пакета (SoA, выравнивание под векторный регистр) */
+typedef struct {
+    double zr[ESCAPE_LANES] __attribute__((aligned(64)));
+    double zi[ESCAPE_LANES] __attribute__((aligned(64)));
+    double cr[ESCAPE_LANES] __attribute__((aligned(64)));
+    double ci[ESCAPE_LANES] __attribute__((aligned(64)));
+    int iter[ESCAPE_LANES] __attribute__((aligned(64)));
+    int live[ESCAPE_LANES];         /* В дорожке есть ячейка */
+    long long cell[ESCAPE_LANES];
+} Lanes;
+
+/* --- ESCAPE_BATCH итераций всех дорожек ---
+ * Вышедшая точка замирает: z не меняется и остаётся за радиусом, счётчик не растёт,
+ * поэтому iter совпадает с mandelbrot_iterations при любой длине пакета.
+ * Возвращает число итераций, выполненных активными дорожками */
+static inline int lanes_iterate(Lanes *L) {
+    int active_total = 0;
+    for (int k = 0; k < ESCAPE_BATCH; k++) {
+        #pragma omp simd reduction(+:active_total)
+        for (int l = 0; l < ESCAPE_LANES; l++) {
+            double zr = L->zr[l], zi = L->zi[l];
+            double zr_sq = zr * zr;
+            double zi_sq = zi * zi;
+            int active = L->live[l] & (zr_sq + zi_sq <= ESCAPE_RADIUS * ESCAPE_RADIUS)
+                                    & (L->iter[l] < MAX_ITERATIONS);
+            double new_zi = 2.0 * zr * zi + L->ci[l];
+            double new_zr = zr_sq - zi_sq + L->cr[l];
+            L->zr[l] = active ? new_zr : zr;
+            L->zi[l] = active ? new_zi : zi;
+            L->iter[l] += active;
+            active_total += active;
+        }
+    }
+    return active_total;
+}
+
+/* Маска закончивших точек: вышли за радиус или исчерпали MAX_ITERATIONS */
+static inline unsigned lanes_done_mask(const Lanes *L) {
+    int done[ESCAPE_LANES];
+    #pragma omp simd
+    for (int l = 0; l < ESCAPE_LANES; l++) {
+        double r_sq = L->zr[l] * L->zr[l] + L->zi[l] * L->zi[l];
+        done[l] = L->live[l] & ((L->iter[l] >= MAX_ITERATIONS) | (r_sq > ESCAPE_RADIUS * ESCAPE_RADIUS));
+    }
+    unsigned mask = 0;
+    for (int l = 0; l < ESCAPE_LANES; l++) mask |= (unsigned)done[l] << l;
+    return mask;
+}
+
+/* Источник точек: узлы сетки или произвольный массив пар (real, imag) */
+typedef struct {
+    const double *points;       /* NULL - сетка */
+    long long total;
+    long long grid_dim;
+    double real_step, imag_step;
+} PointSource;
+
+/* Очередь ячеек потока: [next, end), пополняется блоками из общего счётчика.
+ * Координаты (i, j) следующей ячейки сетки ведутся приращением - без деления на каждую ячейку */
+typedef struct {
+    long long next, end;
+    long long i, j;
+} CellQueue;
+
+static inline int queue_pop(CellQueue *q, long long *shared_next, const PointSource *src,
+                            long long *cell, double *cr, double *ci) {
+    if (q->next >= q->end) {
+        long long begin = __atomic_fetch_add(shared_next, ESCAPE_QUEUE_CHUNK, __ATOMIC_RELAXED);
+        if (begin >= src->total) return 0;
+        q->next = begin;
+        q->end = (begin + ESCAPE_QUEUE_CHUNK < src->total) ? begin + ESCAPE_QUEUE_CHUNK : src->total;
+        if (!src->points) {
+            q->i = begin / src->grid_dim;
+            q->j = begin % src->grid_dim;
+        }
+    }
+    *cell = q->next++;
+    if (src->points) {
+        *cr = src->points[2 * *cell];
+        *ci = src->points[2 * *cell + 1];
+        return 1;
+    }
+    *cr = REAL_MIN + q->i * src->real_step;
+    *ci = IMAG_MIN + q->j * src->imag_step;
+    if (++q->j == src->grid_dim) {
+        q->j = 0;
+        q->i++;
+    }
+    return 1;
+}
+
+/* --- Общий цикл дорожек ---
+ * Результат ячейки пишется по её номеру: принадлежность в inside и/или число итераций в iters
+ * (любой из массивов может быть NULL). Возвращает число точек в множестве */
+static long long lanes_classify(const PointSource *src, EscapeKernel kernel,
+                                unsigned char *inside, unsigned short *iters, LaneStats *stats) {
+    long long shared_next = 0;
+    long long found = 0, lane_slots = 0, active_slots = 0, refills = 0;
+    double start = omp_get_wtime();
+
+    #pragma omp parallel reduction(+:found, lane_slots, active_slots, refills)
+    {
+        Lanes L;
+        memset(&L, 0, sizeof(L));
+        CellQueue q = {0, 0, 0, 0};
+        int nlive = 0;
+        int queue_open = 1;
+
+        for (;;) {
+            /* Загрузка: в потоковом режиме - каждая свободная дорожка,
+             * в пакетном - только когда закончили все */
+            if (queue_open && (kernel == KERNEL_STREAM || nlive == 0)) {
+                for (int l = 0; l < ESCAPE_LANES; l++) {
+                    if (L.live[l]) continue;
+                    if (!queue_pop(&q, &shared_next, src, &L.cell[l], &L.cr[l], &L.ci[l])) {
+                        queue_open = 0;
+                        break;
+                    }
+                    L.zr[l] = 0.0;
+                    L.zi[l] = 0.0;
+                    L.iter[l] = 0;
+                    L.live[l] = 1;
+                    nlive++;
+                    refills++;
+                }
+            }
+            if (nlive == 0) break;
+
+            active_slots += lanes_iterate(&L);
+            lane_slots += ESCAPE_LANES * ESCAPE_BATCH;
+
+            /* Запись результата по номеру ячейки и освобождение дорожки */
+            unsigned done = lanes_done_mask(&L);
+            while (done) {
+                int l = __builtin_ctz(done);
+                done &= done - 1;
+                int member = (L.iter[l] == MAX_ITERATIONS);
+                if (inside) inside[L.cell[l]] = (unsigned char)member;
+                if (iters) iters[L.cell[l]] = (unsigned short)L.iter[l];
+                found += member;
+                L.live[l] = 0;
+                nlive--;
+            }
+        }
+    }
+
+    stats->lane_slots = lane_slots;
+    stats->active_slots = active_slots;
+    stats->refills = refills;
+    stats->time = omp_get_wtime() - start;
+    return found;
+}
+
+long long classify_grid_simd(long long grid_dim, double real_step, double imag_step,
+                             EscapeKernel kernel, unsigned char *inside, LaneStats *stats) {
+    PointSource src = {NULL, grid_dim * grid_dim, grid_dim, real_step, imag_step};
+    return lanes_classify(&src, kernel, inside, NULL, stats);
+}
+
+long long classify_points(const double *points, long long npoints, EscapeKernel kernel,
+                          PointsOutput output, void *out, LaneStats *stats) {
+    unsigned char *inside = (output == POINTS_MEMBER) ? (unsigned char*)out : NULL;
+    unsigned short *iters = (output == POINTS_ITER) ? (unsigned short*)out : NULL;
+
+    if (kernel != KERNEL_SCALAR) {
+        PointSource src = {points, npoints, 0, 0.0, 0.0};
+        return lanes_classify(&src, kernel, inside, iters, stats);
+    }
+
+    /* Скалярное ядро: те же блоки ячеек, динамическое распределение между потоками */
+    long long found = 0;
+    double start = omp_get_wtime();
+    #pragma omp parallel for schedule(dynamic, ESCAPE_QUEUE_CHUNK) reduction(+:found)
+    for (long long k = 0; k < npoints; k++) {
+        int n = mandelbrot_iterations(points[2 * k], points[2 * k + 1]);
+        int member = (n == MAX_ITERATIONS);
+        if (inside) inside[k] = (unsigned char)member;
+        if (iters) iters[k] = (unsigned short)n;
+        found += member;
+    }
+    memset(stats, 0, sizeof(*stats));
+    stats->time = omp_get_wtime() - start;
+    return found;
+}
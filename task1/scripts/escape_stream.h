@@ -0,0 +1,56 @@
+/* escape_stream.h
+ * Векторное ядро числа итераций с дозаправкой дорожек (lane refill).
+ * Точки обрабатываются пакетами по ESCAPE_LANES дорожек. В простом пакетном
+ * режиме пакет идёт, пока не закончит самая медленная точка, и дорожки
+ * вышедших точек простаивают. В потоковом режиме у каждого потока своя
+ * очередь ячеек сетки, и освободившаяся дорожка сразу получает следующую.
+ * Те же ядра классифицируют произвольный массив точек (classify_points).
+ */
+
+#ifndef ESCAPE_STREAM_H
+#define ESCAPE_STREAM_H
+
+#include "mandelbrot.h"
+
+#define ESCAPE_LANES 8          /* Дорожек в пакете (8 double - один регистр AVX-512) */
+#define ESCAPE_BATCH 8          /* Итераций между проверками дорожек */
+#define ESCAPE_QUEUE_CHUNK 4096 /* Ячеек, забираемых в очередь потока за раз */
+
+/* Ядро классификации точек */
+typedef enum {
+    KERNEL_SCALAR = 0,      /* is_in_mandelbrot для каждой точки */
+    KERNEL_PACKET = 1,      /* Пакет целиком до самой медленной точки */
+    KERNEL_STREAM = 2       /* Дозаправка дорожек из очереди ячеек */
+} EscapeKernel;
+
+/* Загрузка дорожек: полезные итерации против всех пройденных слотов */
+typedef struct {
+    long long lane_slots;       /* ESCAPE_LANES * выполненные векторные итерации */
+    long long active_slots;     /* Итерации, выполненные активными дорожками */
+    long long refills;          /* Загрузок ячейки в дорожку */
+    double time;
+} LaneStats;
+
+/* Результат классификации массива точек */
+typedef enum {
+    POINTS_MEMBER = 0,      /* uint8: 1 - точка в множестве */
+    POINTS_ITER = 1         /* uint16: число итераций до выхода (MAX_ITERATIONS - в множестве) */
+} PointsOutput;
+
+_Static_assert(MAX_ITERATIONS <= 65535, "iteration counts are stored as uint16");
+
+const char *escape_kernel_name(EscapeKernel kernel);
+
+/* Принадлежность всех ячеек сетки grid_dim x grid_dim: inside[i * grid_dim + j] = 1,
+ * если точка (REAL_MIN + i * real_step, IMAG_MIN + j * imag_step) в множестве.
+ * Возвращает число точек в множестве */
+long long classify_grid_simd(long long grid_dim, double real_step, double imag_step,
+                             EscapeKernel kernel, unsigned char *inside, LaneStats *stats);
+
+/* Классификация массива точек points[2k] + i * points[2k + 1], k < npoints.
+ * out[k] в порядке входа: uint8 принадлежность или uint16 число итераций (см. PointsOutput).
+ * Для KERNEL_SCALAR статистика дорожек нулевая. Возвращает число точек в множестве */
+long long classify_points(const double *points, long long npoints, EscapeKernel kernel,
+                          PointsOutput output, void *out, LaneStats *stats);
+
+#endif /* ESCAPE_STREAM_H */
@@ -0,0 +1,51 @@
+/* mandelbrot.h
+ * Общие параметры области и ядро проверки точки для задания 1.
+ * Функции объявлены static inline, чтобы компилятор мог встраивать их
+ * во внутренние циклы каждого модуля.
+ */
+
+#ifndef MANDELBROT_H
+#define MANDELBROT_H
+
+/* Конфигурационные константы */
+#define MAX_ITERATIONS 1000
+#define ESCAPE_RADIUS 2.0
+#define REAL_MIN -2.5
+#define REAL_MAX 1.0
+#define IMAG_MIN -1.0
+#define IMAG_MAX 1.0
+
+/* Операций double в итерации z = z^2 + c с проверкой радиуса:
+ * zr^2, zi^2, их сумма, 2 * zr * zi + ci (3), zr^2 - zi^2 + cr (2) */
+#define MANDELBROT_FLOPS_PER_ITER 8
+
+/* --- Число итераций до выхода за радиус отсечения --- */
+/* Возвращает номер итерации, на которой |z| > ESCAPE_RADIUS,
+ * или MAX_ITERATIONS, если точка не покинула круг (принадлежит множеству) */
+static inline int mandelbrot_iterations(double c_real, double c_imag) {
+    double z_real = 0.0;
+    double z_imag = 0.0;
+
+    for (int n = 0; n < MAX_ITERATIONS; n++) {
+        double z_real_sq = z_real * z_real;
+        double z_imag_sq = z_imag * z_imag;
+
+        if (z_real_sq + z_imag_sq > ESCAPE_RADIUS * ESCAPE_RADIUS) {
+            return n;
+        }
+
+        double new_z_imag = 2.0 * z_real * z_imag + c_imag;
+        z_real = z_real_sq - z_imag_sq + c_real;
+        z_imag = new_z_imag;
+    }
+
+    return MAX_ITERATIONS;
+}
+
+/* --- Тест принадлежности множеству Mandelbrot --- */
+/* Возвращает 1, если c = (real, imag) принадлежит множеству Mandelbrot, иначе 0 */
+static inline int is_in_mandelbrot(double c_real, double c_imag) {
+    return mandelbrot_iterations(c_real, c_imag) == MAX_ITERATIONS;
+}
+
+#endif /* MANDELBROT_H */
@@ -0,0 +1,321 @@
+/* pyramid.c
+ * Построение многоуровневой пирамиды тайлов множества Мандельброта
+ */
+
+#include "pyramid.h"
+#include "mandelbrot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <omp.h>
+#include <sys/stat.h>
+
+/* Маркер ещё не вычисленного пикселя (больше любого числа итераций) */
+#define PIXEL_PENDING 0xFFFF
+
+/* Прямоугольники меньше этого размера вычисляются целиком, без проверки границы */
+#define MIN_SPLIT_RECT 8
+
+/* --- Контекст вычисления одного тайла --- */
+typedef struct {
+    uint16_t *buf;          /* Буфер всего детального уровня */
+    long long dim;          /* Размер уровня */
+    double real_step;
+    double imag_step;
+    long long computed;     /* Локальные счётчики потока */
+    long long skipped;
+} RenderCtx;
+
+/* Значение пикселя; вычисляется при первом обращении.
+ * Отсчёт ведётся по центрам пикселей, строка 0 соответствует IMAG_MAX */
+static inline uint16_t eval_pixel(RenderCtx *ctx, long long x, long long y) {
+    uint16_t *p = &ctx->buf[y * ctx->dim + x];
+    if (*p == PIXEL_PENDING) {
+        double c_real = REAL_MIN + (x + 0.5) * ctx->real_step;
+        double c_imag = IMAG_MAX - (y + 0.5) * ctx->imag_step;
+        *p = (uint16_t)mandelbrot_iterations(c_real, c_imag);
+        ctx->computed++;
+    }
+    return *p;
+}
+
+/* --- Вычисление прямоугольника с пропуском внутренних областей --- */
+/* Множество Мандельброта связно и не имеет "дыр", поэтому если вся граница
+ * прямоугольника лежит внутри множества, внутри множества лежит и он сам.
+ * Иначе прямоугольник делится на 4 части и проверка повторяется.
+ * Это приближение: проверка "внутри" - достижение MAX_ITERATIONS, и пиксель
+ * границы у края множества может упереться в предел, а внутренний - выйти
+ * раньше. Такие пиксели получают MAX_ITERATIONS вместо своего числа итераций. */
+static void render_rect(RenderCtx *ctx, long long x0, long long y0, long long w, long long h) {
+    if (w <= MIN_SPLIT_RECT || h <= MIN_SPLIT_RECT) {
+        for (long long y = y0; y < y0 + h; y++)
+            for (long long x = x0; x < x0 + w; x++)
+                eval_pixel(ctx, x, y);
+        return;
+    }
+
+    int all_inside = 1;
+    for (long long x = x0; x < x0 + w; x++) {
+        all_inside &= (eval_pixel(ctx, x, y0) == MAX_ITERATIONS);
+        all_inside &= (eval_pixel(ctx, x, y0 + h - 1) == MAX_ITERATIONS);
+    }
+    for (long long y = y0 + 1; y < y0 + h - 1; y++) {
+        all_inside &= (eval_pixel(ctx, x0, y) == MAX_ITERATIONS);
+        all_inside &= (eval_pixel(ctx, x0 + w - 1, y) == MAX_ITERATIONS);
+    }
+
+    if (all_inside) {
+        for (long long y = y0 + 1; y < y0 + h - 1; y++) {
+            for (long long x = x0 + 1; x < x0 + w - 1; x++) {
+                uint16_t *p = &ctx->buf[y * ctx->dim + x];
+                if (*p == PIXEL_PENDING) {
+                    *p = MAX_ITERATIONS;
+                    ctx->skipped++;
+                }
+            }
+        }
+        return;
+    }
+
+    long long hw = w / 2, hh = h / 2;
+    render_rect(ctx, x0,      y0,      hw,     hh);
+    render_rect(ctx, x0 + hw, y0,      w - hw, hh);
+    render_rect(ctx, x0,      y0 + hh, hw,     h - hh);
+    render_rect(ctx, x0 + hw, y0 + hh, w - hw, h - hh);
+}
+
+/* --- Вычисление детального уровня по тайлам --- */
+static void render_finest(uint16_t *buf, long long dim, const PyramidConfig *cfg, PyramidStats *stats) {
+    long long tile = cfg->tile_size;
+    long long tiles_per_side = dim / tile;
+    long long ntiles = tiles_per_side * tiles_per_side;
+    long long computed = 0, skipped = 0;
+
+    #pragma omp parallel reduction(+:computed, skipped)
+    {
+        RenderCtx ctx;
+        ctx.buf = buf;
+        ctx.dim = dim;
+        ctx.real_step = (REAL_MAX - REAL_MIN) / (double)dim;
+        ctx.imag_step = (IMAG_MAX - IMAG_MIN) / (double)dim;
+        ctx.computed = 0;
+        ctx.skipped = 0;
+
+        /* Тайлы сильно различаются по стоимости - динамическое распределение */
+        #pragma omp for schedule(dynamic, 1)
+        for (long long t = 0; t < ntiles; t++) {
+            long long x0 = (t % tiles_per_side) * tile;
+            long long y0 = (t / tiles_per_side) * tile;
+
+            /* Инициализация тайла тем же потоком, который его вычисляет */
+            for (long long y = y0; y < y0 + tile; y++)
+                for (long long x = x0; x < x0 + tile; x++)
+                    buf[y * dim + x] = PIXEL_PENDING;
+
+            if (cfg->skip_interior) {
+                render_rect(&ctx, x0, y0, tile, tile);
+            } else {
+                for (long long y = y0; y < y0 + tile; y++)
+                    for (long long x = x0; x < x0 + tile; x++)
+                        eval_pixel(&ctx, x, y);
+            }
+        }
+
+        computed += ctx.computed;
+        skipped += ctx.skipped;
+    }
+
+    /* Для режима принадлежности переводим итерации в 0/255 */
+    if (cfg->data == PYRAMID_MEMBER) {
+        #pragma omp parallel for schedule(static)
+        for (long long i = 0; i < dim * dim; i++) {
+            buf[i] = (buf[i] == MAX_ITERATIONS) ? 255 : 0;
+        }
+    }
+
+    stats->computed_pixels = computed;
+    stats->skipped_pixels = skipped;
+}
+
+/* --- Прореживание уровня 2x2 -> 1 (среднее значение) --- */
+static uint16_t *downsample_level(const uint16_t *src, long long dim) {
+    long long half = dim / 2;
+    uint16_t *dst = (uint16_t*)malloc((size_t)half * half * sizeof(uint16_t));
+    if (!dst) return NULL;
+
+    #pragma omp parallel for schedule(static)
+    for (long long y = 0; y < half; y++) {
+        const uint16_t *row0 = src + (2 * y) * dim;
+        const uint16_t *row1 = row0 + dim;
+        for (long long x = 0; x < half; x++) {
+            unsigned sum = row0[2*x] + row0[2*x + 1] + row1[2*x] + row1[2*x + 1];
+            dst[y * half + x] = (uint16_t)((sum + 2) / 4);
+        }
+    }
+
+    return dst;
+}
+
+/* --- Запись всех тайлов одного уровня в <out_dir>/<level>/<ty>_<tx>.pgm --- */
+static int write_level(const char *out_dir, int level, const uint16_t *buf, long long dim,
+                       const PyramidConfig *cfg, PyramidStats *stats) {
+    char level_dir[512];
+    snprintf(level_dir, sizeof(level_dir), "%s/%d", out_dir, level);
+    if (mkdir(level_dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Error: Cannot create %s: %s\n", level_dir, strerror(errno));
+        return 0;
+    }
+
+    long long tile = cfg->tile_size;
+    long long tiles_per_side = dim / tile;
+    long long ntiles = tiles_per_side * tiles_per_side;
+    int wide = (cfg->data == PYRAMID_ITER);     /* 16-битные отсчёты */
+    int maxval = wide ? MAX_ITERATIONS : 255;
+    size_t row_bytes = (size_t)tile * (wide ? 2 : 1);
+    long long bytes = 0;
+    int failed = 0;
+
+    #pragma omp parallel reduction(+:bytes)
+    {
+        unsigned char *row = (unsigned char*)malloc(row_bytes);
+
+        #pragma omp for schedule(dynamic, 1)
+        for (long long t = 0; t < ntiles; t++) {
+            long long tx = t % tiles_per_side;
+            long long ty = t / tiles_per_side;
+            char fname[600];
+            snprintf(fname, sizeof(fname), "%s/%lld_%lld.pgm", level_dir, ty, tx);
+
+            FILE *f = row ? fopen(fname, "wb") : NULL;
+            if (!f) {
+                #pragma omp atomic write
+                failed = 1;
+                continue;
+            }
+
+            bytes += fprintf(f, "P5\n%lld %lld\n%d\n", tile, tile, maxval);
+            for (long long y = ty * tile; y < (ty + 1) * tile; y++) {
+                const uint16_t *src = buf + y * dim + tx * tile;
+                for (long long x = 0; x < tile; x++) {
+                    if (wide) {
+                        /* PGM хранит 16-битные отсчёты в big-endian */
+                        row[2*x] = (unsigned char)(src[x] >> 8);
+                        row[2*x + 1] = (unsigned char)(src[x] & 0xFF);
+                    } else {
+                        row[x] = (unsigned char)src[x];
+                    }
+                }
+                bytes += fwrite(row, 1, row_bytes, f);
+            }
+            fclose(f);
+        }
+
+        free(row);
+    }
+
+    if (failed) {
+        fprintf(stderr, "Error: Failed to write tiles of level %d to %s\n", level, level_dir);
+        return 0;
+    }
+
+    stats->tiles_written += ntiles;
+    stats->bytes_written += bytes;
+    return 1;
+}
+
+/* --- Индексный файл пирамиды --- */
+static int write_index(const char *out_dir, const PyramidConfig *cfg, long long finest_dim) {
+    char fname[512];
+    snprintf(fname, sizeof(fname), "%s/index.json", out_dir);
+
+    FILE *f = fopen(fname, "w");
+    if (!f) {
+        fprintf(stderr, "Error: Cannot open %s for writing: %s\n", fname, strerror(errno));
+        return 0;
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"format\": \"pgm\",\n");
+    fprintf(f, "  \"data\": \"%s\",\n", cfg->data == PYRAMID_ITER ? "iterations" : "membership");
+    fprintf(f, "  \"max_value\": %d,\n", cfg->data == PYRAMID_ITER ? MAX_ITERATIONS : 255);
+    fprintf(f, "  \"max_iterations\": %d,\n", MAX_ITERATIONS);
+    fprintf(f, "  \"tile_size\": %d,\n", cfg->tile_size);
+    fprintf(f, "  \"levels\": %d,\n", cfg->levels);
+    fprintf(f, "  \"region\": {\"real_min\": %.6f, \"real_max\": %.6f, "
+               "\"imag_min\": %.6f, \"imag_max\": %.6f},\n",
+            REAL_MIN, REAL_MAX, IMAG_MIN, IMAG_MAX);
+    fprintf(f, "  \"sampling\": \"pixel centers, row 0 at imag_max, coarse levels are 2x2 means\",\n");
+    fprintf(f, "  \"tile_path\": \"{level}/{ty}_{tx}.pgm\",\n");
+    fprintf(f, "  \"level_info\": [\n");
+    for (int level = 0; level < cfg->levels; level++) {
+        long long dim = finest_dim >> (cfg->levels - 1 - level);
+        fprintf(f, "    {\"level\": %d, \"dim\": %lld, \"tiles_per_side\": %lld}%s\n",
+                level, dim, dim / cfg->tile_size, level + 1 < cfg->levels ? "," : "");
+    }
+    fprintf(f, "  ]\n");
+    fprintf(f, "}\n");
+
+    fclose(f);
+    return 1;
+}
+
+int pyramid_levels_for(long long grid_dim, int tile_size) {
+    int levels = 1;
+    while (((long long)tile_size << (levels - 1)) < grid_dim) {
+        levels++;
+    }
+    return levels;
+}
+
+int build_pyramid(const char *out_dir, const PyramidConfig *cfg, PyramidStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    if (cfg->tile_size <= 0 || cfg->levels <= 0 || cfg->levels > 16) {
+        fprintf(stderr, "Error: Invalid pyramid configuration (tile=%d, levels=%d)\n",
+                cfg->tile_size, cfg->levels);
+        return 0;
+    }
+
+    long long dim = (long long)cfg->tile_size << (cfg->levels - 1);
+    stats->finest_dim = dim;
+
+    uint16_t *buf = (uint16_t*)malloc((size_t)dim * dim * sizeof(uint16_t));
+    if (!buf) {
+        fprintf(stderr, "Error: Failed to allocate finest level (%lld x %lld)\n", dim, dim);
+        return 0;
+    }
+
+    double t0 = omp_get_wtime();
+    render_finest(buf, dim, cfg, stats);
+    stats->render_time = omp_get_wtime() - t0;
+
+    /* Уровни пишутся от детального к грубому; в памяти живут не более двух */
+    for (int level = cfg->levels - 1; level >= 0; level--) {
+        double tw = omp_get_wtime();
+        int ok = write_level(out_dir, level, buf, dim, cfg, stats);
+        stats->write_time += omp_get_wtime() - tw;
+        if (!ok) {
+            free(buf);
+            return 0;
+        }
+
+        if (level > 0) {
+            double td = omp_get_wtime();
+            uint16_t *coarse = downsample_level(buf, dim);
+            stats->downsample_time += omp_get_wtime() - td;
+            free(buf);
+            if (!coarse) {
+                fprintf(stderr, "Error: Failed to allocate level %d\n", level - 1);
+                return 0;
+            }
+            buf = coarse;
+            dim /= 2;
+        }
+    }
+
+    free(buf);
+    return write_index(out_dir, cfg, stats->finest_dim);
+}
@@ -0,0 +1,43 @@
+/* pyramid.h
+ * Построение многоуровневой пирамиды тайлов множества Мандельброта.
+ * Самый детальный уровень вычисляется один раз, грубые уровни получаются
+ * из него параллельным прореживанием 2x2 и записываются на диск по очереди.
+ */
+
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+/* Что хранится в пикселях тайлов */
+typedef enum {
+    PYRAMID_ITER = 0,     /* Число итераций (16-бит PGM, maxval = MAX_ITERATIONS) */
+    PYRAMID_MEMBER = 1    /* Принадлежность множеству (8-бит PGM, 255 = внутри) */
+} PyramidData;
+
+/* Параметры пирамиды */
+typedef struct {
+    int tile_size;          /* Размер тайла в пикселях */
+    int levels;             /* Число уровней (0 - самый грубый, один тайл) */
+    PyramidData data;       /* Тип данных в тайлах */
+    int skip_interior;      /* Пропускать области, граница которых целиком внутри множества (приближённо) */
+} PyramidConfig;
+
+/* Статистика построения */
+typedef struct {
+    long long finest_dim;       /* Размер самого детального уровня */
+    long long computed_pixels;  /* Пиксели, для которых выполнялись итерации */
+    long long skipped_pixels;   /* Пиксели, заполненные без итераций */
+    long long tiles_written;
+    long long bytes_written;
+    double render_time;         /* Вычисление детального уровня */
+    double downsample_time;     /* Построение грубых уровней */
+    double write_time;          /* Запись тайлов на диск */
+} PyramidStats;
+
+/* Минимальное число уровней, при котором детальный уровень не меньше grid_dim */
+int pyramid_levels_for(long long grid_dim, int tile_size);
+
+/* Строит пирамиду в каталоге out_dir (каталог должен существовать).
+ * Возвращает 1 при успехе, 0 при ошибке. */
+int build_pyramid(const char *out_dir, const PyramidConfig *cfg, PyramidStats *stats);
+
+#endif /* PYRAMID_H */
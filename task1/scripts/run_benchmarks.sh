@@ -4,7 +4,7 @@
 
 # Компиляция программы
 echo "Компиляция task1..."
-gcc -fopenmp -O3 -o task1/scripts/task1 task1/scripts/task1.c -lm
+gcc -fopenmp -O3 -o task1/scripts/task1 task1/scripts/task1.c task1/scripts/pyramid.c task1/scripts/contour.c task1/scripts/escape_stream.c common/trace.c common/env_info.c common/rapl.c common/scaling.c common/peak.c common/roofline.c common/mem_profile.c -lm
 
 if [ $? -ne 0 ]; then
     echo "Ошибка компиляции!"
@@ -13,14 +13,21 @@
 #include <errno.h>
 #include <math.h>
 #include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
-/* Конфигурационные константы */
-#define MAX_ITERATIONS 1000   
-#define ESCAPE_RADIUS 2.0     
-#define REAL_MIN -2.5         
-#define REAL_MAX 1.0
-#define IMAG_MIN -1.0
-#define IMAG_MAX 1.0
+#include "mandelbrot.h"
+#include "pyramid.h"
+#include "contour.h"
+#include "escape_stream.h"
+#include "../../common/env_info.h"
+#include "../../common/mem_profile.h"
+#include "../../common/rapl.h"
+#include "../../common/peak.h"
+#include "../../common/roofline.h"
+#include "../../common/scaling.h"
+#include "../../common/trace.h"
 
 /* --- Утилиты работы с файловой системой --- */
 void ensure_dir_exists(const char *path) {
@@ -65,28 +72,6 @@ void get_cpu_info(char *cpu_info, size_t size) {
     snprintf(cpu_info, size, "Unknown CPU");
 }
 
-/* --- Тест принадлежности множеству Mandelbrot --- */
-/* Возвращает 1, если c = (real, imag) принадлежит множеству Mandelbrot, иначе 0 */
-int is_in_mandelbrot(double c_real, double c_imag) {
-    double z_real = 0.0;
-    double z_imag = 0.0;
-    
-    for (int n = 0; n < MAX_ITERATIONS; n++) {
-        double z_real_sq = z_real * z_real;
-        double z_imag_sq = z_imag * z_imag;
-        
-        if (z_real_sq + z_imag_sq > ESCAPE_RADIUS * ESCAPE_RADIUS) {
-            return 0;  
-        }
-        
-        double new_z_imag = 2.0 * z_real * z_imag + c_imag;
-        z_real = z_real_sq - z_imag_sq + c_real;
-        z_imag = new_z_imag;
-    }
-    
-    return 1;
-}
-
 /* --- Структура для хранения результатов --- */
 typedef struct {
     double real;
@@ -104,41 +89,33 @@ typedef struct {
     double max_time;
     double avg_time;
     int num_runs;
+    long long iterations;           /* Итераций выхода за один запуск (по всем точкам) */
+    const ScalingPoint *scaling;    /* Точка масштабирования (--sweep), NULL - обычный запуск */
+    const MemProfile *memory;       /* Память по фазам, NULL - не снималась */
 } PerformanceMetrics;
 
 /* --- Запись метрик производительности в CSV --- */
-void write_performance_metrics(const char *csv_dir, const char *prefix, 
-                                PerformanceMetrics *metrics, const char *cpu_info) {
+void write_performance_metrics(const char *csv_dir, const char *prefix, PerformanceMetrics *metrics,
+                                const char *cpu_info, const MachinePeak *peak, const EnvInfo *env) {
     char fname[512];
     snprintf(fname, sizeof(fname), "%s/%s_performance.csv", csv_dir, prefix);
     
-    /* Проверяем, существует ли файл (для добавления заголовка) */
-    int file_exists = 0;
-    FILE *test = fopen(fname, "r");
-    if (test) {
-        file_exists = 1;
-        fclose(test);
-    }
-    
-    FILE *f = fopen(fname, "a");
+    /* Заголовок пишется в новый файл; файл со старой схемой сохраняется под другим именем */
+    FILE *f = env_csv_append(fname, "timestamp,cpu_info,nthreads,requested_points,grid_dim,actual_points,points_found,"
+                         "found_percentage,computation_time,min_time,max_time,avg_time,num_runs,"
+                         "iterations,giter_per_s,gflops,peak_gflops,peak_fraction,"
+                         SCALING_CSV_HEADER "," MEM_CSV_HEADER "," ENV_CSV_HEADER);
     if (!f) {
         fprintf(stderr, "Cannot open %s for writing\n", fname);
         return;
     }
     
-    /* Записываем заголовок, если файл новый */
-    if (!file_exists) {
-        fprintf(f, "timestamp,cpu_info,nthreads,requested_points,grid_dim,actual_points,points_found,");
-        fprintf(f, "found_percentage,computation_time,min_time,max_time,avg_time,num_runs\n");
-    }
-    
-    /* Получаем текущее время */
     time_t now = time(NULL);
     char timestamp[64];
     strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
     
     /* Записываем данные */
-    fprintf(f, "%s,\"%s\",%d,%lld,%lld,%lld,%lld,%.2f,%.6f,%.6f,%.6f,%.6f,%d\n",
+    fprintf(f, "%s,\"%s\",%d,%lld,%lld,%lld,%lld,%.2f,%.6f,%.6f,%.6f,%.6f,%d,",
             timestamp,
             cpu_info,
             metrics->nthreads,
@@ -152,15 +129,29 @@ void write_performance_metrics(const char *csv_dir, const char *prefix,
             metrics->max_time,
             metrics->avg_time,
             metrics->num_runs);
+    double iter_rate = metrics->avg_time > 0.0 ? metrics->iterations / metrics->avg_time : 0.0;
+    double gflops = iter_rate * MANDELBROT_FLOPS_PER_ITER * 1e-9;
+    fprintf(f, "%lld,%.6f,%.6f,", metrics->iterations, iter_rate * 1e-9, gflops);
+    if (peak->gflops > 0.0) fprintf(f, "%.3f,%.6f,", peak->gflops, peak_fraction(peak, gflops));
+    else fprintf(f, ",,");
+    scaling_csv_write(f, metrics->scaling);
+    fputc(',', f);
+    mem_csv_write(f, metrics->memory);
+    fputc(',', f);
+    env_csv_write(f, env);
+    fprintf(f, "\n");
     
     fclose(f);
     printf("Performance metrics written to %s\n", fname);
 }
 
-/* --- Основная функция вычисления --- */
+/* --- Основная функция вычисления ---
+ * iterations - итерации выхода всех точек (счётчики потоков складываются при слиянии) */
 long long compute_mandelbrot(long long grid_dim, double real_step, double imag_step,
-                              MandelbrotPoint **results_ptr, long long *result_capacity_ptr) {
+                              MandelbrotPoint **results_ptr, long long *result_capacity_ptr,
+                              long long *iterations) {
     long long result_count = 0;
+    long long total_iterations = 0;
     MandelbrotPoint *results = *results_ptr;
     long long result_capacity = *result_capacity_ptr;
     
@@ -169,6 +160,7 @@ long long compute_mandelbrot(long long grid_dim, double real_step, double imag_s
         /* Локальный буфер результатов для потока */
         long long local_capacity = 1000;
         long long local_count = 0;
+        long long local_iterations = 0;
         MandelbrotPoint *local_results = (MandelbrotPoint*)malloc(local_capacity * sizeof(MandelbrotPoint));
         
         if (!local_results) {
@@ -176,8 +168,9 @@ long long compute_mandelbrot(long long grid_dim, double real_step, double imag_s
             exit(1);
         }
         
-        /* Распределяем работу между потоками */
-        #pragma omp for schedule(dynamic, 100)
+        /* Распределяем работу между потоками; nowait - ожидание видно как merge_wait */
+        TRACE_BEGIN("mandelbrot_rows");
+        #pragma omp for schedule(dynamic, 100) nowait
         for (long long i = 0; i < grid_dim; i++) {
             double c_real = REAL_MIN + i * real_step;
             
@@ -185,7 +178,9 @@ long long compute_mandelbrot(long long grid_dim, double real_step, double imag_s
                 double c_imag = IMAG_MIN + j * imag_step;
                 
                 /* Проверяем, принадлежит ли точка множеству Mandelbrot */
-                if (is_in_mandelbrot(c_real, c_imag)) {
+                int n = mandelbrot_iterations(c_real, c_imag);
+                local_iterations += n;
+                if (n == MAX_ITERATIONS) {
                     /* Расширяем локальный буфер при необходимости */
                     if (local_count >= local_capacity) {
                         local_capacity *= 2;
@@ -207,9 +202,14 @@ long long compute_mandelbrot(long long grid_dim, double real_step, double imag_s
             }
         }
         
+        TRACE_END("mandelbrot_rows");
+        
         /* Объединяем локальные результаты в глобальный массив */
+        TRACE_BEGIN("merge_wait");
         #pragma omp critical
         {
+            TRACE_END("merge_wait");
+            TRACE_BEGIN("merge");
             /* Увеличиваем глобальный буфер при необходимости */
             while (result_count + local_count > result_capacity) {
                 result_capacity *= 2;
@@ -226,6 +226,8 @@ long long compute_mandelbrot(long long grid_dim, double real_step, double imag_s
             /* Копируем локальные результаты в глобальный массив */
             memcpy(&results[result_count], local_results, local_count * sizeof(MandelbrotPoint));
             result_count += local_count;
+            total_iterations += local_iterations;
+            TRACE_END("merge");
         }
         
         free(local_results);
@@ -233,32 +235,616 @@ long long compute_mandelbrot(long long grid_dim, double real_step, double imag_s
     
     *results_ptr = results;
     *result_capacity_ptr = result_capacity;
+    *iterations = total_iterations;
     return result_count;
 }
 
+/* --- Вычисление векторным ядром ---
+ * Ядро записывает принадлежность по номеру ячейки, точки собираются в порядке ячеек,
+ * поэтому result.csv не зависит от числа потоков */
+long long compute_mandelbrot_simd(long long grid_dim, double real_step, double imag_step,
+                                  EscapeKernel kernel, unsigned char *inside,
+                                  MandelbrotPoint **results_ptr, long long *result_capacity_ptr,
+                                  LaneStats *stats) {
+    long long found = classify_grid_simd(grid_dim, real_step, imag_step, kernel, inside, stats);
+
+    if (found > *result_capacity_ptr) {
+        MandelbrotPoint *new_buf = (MandelbrotPoint*)realloc(*results_ptr, found * sizeof(MandelbrotPoint));
+        if (!new_buf) {
+            fprintf(stderr, "Failed to grow global result buffer\n");
+            exit(1);
+        }
+        *results_ptr = new_buf;
+        *result_capacity_ptr = found;
+    }
+
+    MandelbrotPoint *results = *results_ptr;
+    long long count = 0;
+    for (long long i = 0; i < grid_dim; i++) {
+        const unsigned char *row = inside + i * grid_dim;
+        for (long long j = 0; j < grid_dim; j++) {
+            if (row[j]) {
+                results[count].real = REAL_MIN + i * real_step;
+                results[count].imag = IMAG_MIN + j * imag_step;
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+/* --- Вычисление сетки выбранным ядром ---
+ * iterations - итерации выхода всех точек; у векторных ядер это итерации активных дорожек */
+long long compute_grid(long long grid_dim, double real_step, double imag_step,
+                       EscapeKernel kernel, unsigned char *inside,
+                       MandelbrotPoint **results_ptr, long long *result_capacity_ptr,
+                       LaneStats *stats, long long *iterations) {
+    if (kernel == KERNEL_SCALAR) {
+        return compute_mandelbrot(grid_dim, real_step, imag_step, results_ptr, result_capacity_ptr, iterations);
+    }
+    long long found = compute_mandelbrot_simd(grid_dim, real_step, imag_step, kernel, inside,
+                                              results_ptr, result_capacity_ptr, stats);
+    *iterations = stats->active_slots;
+    return found;
+}
+
+/* --- Загрузка дорожек векторного ядра в CSV --- */
+void write_lane_stats(const char *csv_dir, const char *prefix, EscapeKernel kernel, int nthreads,
+                      long long grid_dim, const LaneStats *stats, double avg_time) {
+    double utilization = stats->lane_slots > 0 ? (double)stats->active_slots / stats->lane_slots : 0.0;
+    printf("\n=== SIMD Lanes (%s kernel, %d lanes, %d iterations per check) ===\n",
+           escape_kernel_name(kernel), ESCAPE_LANES, ESCAPE_BATCH);
+    printf("Lane utilization: %.2f%% (%lld useful of %lld lane-iterations)\n",
+           100.0 * utilization, stats->active_slots, stats->lane_slots);
+    printf("Lane refills:     %lld\n", stats->refills);
+    printf("Iterations/s:     %.3e\n", avg_time > 0.0 ? stats->active_slots / avg_time : 0.0);
+    printf("==================================================================\n\n");
+
+    char fname[512];
+    snprintf(fname, sizeof(fname), "%s/%s_simd.csv", csv_dir, prefix);
+    FILE *test = fopen(fname, "r");
+    int file_exists = (test != NULL);
+    if (test) fclose(test);
+
+    FILE *f = fopen(fname, "a");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s for writing\n", fname);
+        return;
+    }
+    if (!file_exists) {
+        fprintf(f, "kernel,nthreads,grid_dim,lanes,batch,lane_slots,active_slots,utilization,avg_time\n");
+    }
+    fprintf(f, "%s,%d,%lld,%d,%d,%lld,%lld,%.4f,%.6f\n",
+            escape_kernel_name(kernel), nthreads, grid_dim, ESCAPE_LANES, ESCAPE_BATCH,
+            stats->lane_slots, stats->active_slots, utilization, avg_time);
+    fclose(f);
+    printf("Lane utilization written to %s\n", fname);
+}
+
+/* --- Энергия запусков в CSV --- */
+void write_rapl_report(const char *csv_dir, const char *prefix, const RaplCounters *rapl,
+                       const PerformanceMetrics *metrics, const EnvInfo *env) {
+    double points = (double)(metrics->grid_dim * metrics->grid_dim) * metrics->num_runs;
+    rapl_print(rapl, points, "point");
+    if (!rapl->available) return;
+
+    char fname[512];
+    snprintf(fname, sizeof(fname), "%s/%s_rapl.csv", csv_dir, prefix);
+    FILE *test = fopen(fname, "r");
+    int file_exists = (test != NULL);
+    if (test) fclose(test);
+
+    FILE *f = fopen(fname, "a");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s for writing\n", fname);
+        return;
+    }
+    if (!file_exists) {
+        fprintf(f, "nthreads,grid_dim,num_runs,points,seconds,package_j,dram_j,package_w,joules_per_point,env_hash\n");
+    }
+    double package = rapl_joules(rapl, RAPL_PACKAGE);
+    double dram = rapl_joules(rapl, RAPL_DRAM);
+    double total = package + (dram > 0.0 ? dram : 0.0);
+    fprintf(f, "%d,%lld,%d,%.0f,%.6f,%.3f,%.3f,%.3f,%.6e,%s\n",
+            metrics->nthreads, metrics->grid_dim, metrics->num_runs, points, rapl->seconds,
+            package, dram, rapl->seconds > 0.0 ? package / rapl->seconds : 0.0,
+            total / points, env->hash);
+    fclose(f);
+    printf("Energy written to %s\n", fname);
+}
+
+/* --- Дополнительные режимы работы (опции вида --name [value]) --- */
+typedef struct {
+    int pyramid;                /* Построить пирамиду тайлов вместо списка точек */
+    int tile_size;              /* Размер тайла пирамиды */
+    PyramidData pyramid_data;   /* Данные в тайлах: итерации или принадлежность */
+    int pyramid_skip;           /* Пропуск внутренних областей при вычислении */
+    int contour;                /* Вывести границу множества ломаными */
+    int contour_level;          /* Порог итераций для контура */
+    EscapeKernel kernel;        /* Ядро классификации точек */
+    int kernel_given;           /* --kernel задан явно (иначе для --points - stream) */
+    const char *points_path;    /* Бинарный массив точек вместо сетки (NULL - сетка) */
+    const char *points_out;     /* Файл результата классификации массива точек */
+    PointsOutput points_data;   /* Принадлежность или число итераций */
+    int rapl;                   /* Энергия по счётчикам RAPL */
+    int sweep_threads[SCALING_MAX_POINTS];  /* Числа потоков для --sweep */
+    int sweep_count;            /* 0 - один запуск с nthreads потоками */
+} RunOptions;
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s <nthreads> <npoints> [num_runs] [prefix] [options]\n", prog);
+    fprintf(stderr, "  nthreads:  number of OpenMP threads\n");
+    fprintf(stderr, "  npoints:   number of sample points (square root taken for grid dimension)\n");
+    fprintf(stderr, "  num_runs:  number of runs for averaging (default: 1)\n");
+    fprintf(stderr, "  prefix:    output file prefix (default: task1)\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --pyramid               write a zoomable tile pyramid to task1/data/pyramid\n");
+    fprintf(stderr, "  --tile <size>           pyramid tile size in pixels (default: 256)\n");
+    fprintf(stderr, "  --pyramid-data <kind>   iter | member (default: iter)\n");
+    fprintf(stderr, "  --pyramid-skip          skip regions whose border lies inside the set (lossy approximation)\n");
+    fprintf(stderr, "  --contour               write the set boundary as polylines to task1/data/contour.csv\n");
+    fprintf(stderr, "  --contour-level <iter>  trace the iteration isoline instead of the set boundary\n");
+    fprintf(stderr, "  --kernel <name>         scalar | packet | stream (SIMD with lane refill,\n");
+    fprintf(stderr, "                          default: stream with --points, scalar otherwise)\n");
+    fprintf(stderr, "  --points <file>         classify (real, imag) double pairs from a binary file instead of the grid;\n");
+    fprintf(stderr, "                          npoints limits how many points are taken from the file\n");
+    fprintf(stderr, "  --points-out <file>     output for --points (default: task1/data/points_out.bin)\n");
+    fprintf(stderr, "  --points-data <kind>    member (uint8) | iter (uint16) (default: member)\n");
+    fprintf(stderr, "  --rapl                  measure package and DRAM energy (RAPL), write task1/data/<prefix>_rapl.csv\n");
+    fprintf(stderr, "  --sweep <list>          time the grid for each thread count (e.g. 1,2,4,8) in one process,\n");
+    fprintf(stderr, "                          report speedup, efficiency and Karp-Flatt serial fraction; nthreads is ignored\n");
+}
+
+/* Значение опции: следующий аргумент командной строки */
+const char *option_value(int argc, char *argv[], int *a) {
+    if (*a + 1 >= argc) {
+        fprintf(stderr, "Error: option %s requires a value\n", argv[*a]);
+        return NULL;
+    }
+    return argv[++(*a)];
+}
+
+/* Разбор одной опции; возвращает 0 при ошибке */
+int parse_option(int argc, char *argv[], int *a, RunOptions *opts) {
+    const char *name = argv[*a];
+    const char *value;
+
+    if (strcmp(name, "--pyramid") == 0) {
+        opts->pyramid = 1;
+    } else if (strcmp(name, "--tile") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->tile_size = atoi(value);
+        if (opts->tile_size <= 0) {
+            fprintf(stderr, "Error: tile size must be positive, got %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--pyramid-data") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        if (strcmp(value, "iter") == 0) {
+            opts->pyramid_data = PYRAMID_ITER;
+        } else if (strcmp(value, "member") == 0) {
+            opts->pyramid_data = PYRAMID_MEMBER;
+        } else {
+            fprintf(stderr, "Error: unknown pyramid data kind %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--pyramid-skip") == 0) {
+        opts->pyramid_skip = 1;
+    } else if (strcmp(name, "--contour") == 0) {
+        opts->contour = 1;
+    } else if (strcmp(name, "--contour-level") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->contour_level = atoi(value);
+        if (opts->contour_level <= 0 || opts->contour_level > MAX_ITERATIONS) {
+            fprintf(stderr, "Error: contour level must be in [1, %d], got %s\n", MAX_ITERATIONS, value);
+            return 0;
+        }
+    } else if (strcmp(name, "--kernel") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->kernel_given = 1;
+        if (strcmp(value, "scalar") == 0) {
+            opts->kernel = KERNEL_SCALAR;
+        } else if (strcmp(value, "packet") == 0) {
+            opts->kernel = KERNEL_PACKET;
+        } else if (strcmp(value, "stream") == 0) {
+            opts->kernel = KERNEL_STREAM;
+        } else {
+            fprintf(stderr, "Error: unknown kernel %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--rapl") == 0) {
+        opts->rapl = 1;
+    } else if (strcmp(name, "--sweep") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->sweep_count = scaling_parse_threads(value, opts->sweep_threads, SCALING_MAX_POINTS);
+        if (opts->sweep_count == 0) {
+            fprintf(stderr, "Error: thread list must be positive integers separated by commas, got %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--points") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->points_path = value;
+    } else if (strcmp(name, "--points-out") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->points_out = value;
+    } else if (strcmp(name, "--points-data") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        if (strcmp(value, "member") == 0) {
+            opts->points_data = POINTS_MEMBER;
+        } else if (strcmp(value, "iter") == 0) {
+            opts->points_data = POINTS_ITER;
+        } else {
+            fprintf(stderr, "Error: unknown points data kind %s\n", value);
+            return 0;
+        }
+    } else {
+        fprintf(stderr, "Error: unknown option %s\n", name);
+        return 0;
+    }
+    return 1;
+}
+
+/* --- Режим пирамиды тайлов --- */
+int run_pyramid(const RunOptions *opts, long long grid_dim, int nthreads,
+                const char *csv_dir, const char *prefix, const EnvInfo *env, MemProfile *memory) {
+    const char *out_dir = "./task1/data/pyramid";
+    ensure_dir_exists(out_dir);
+
+    PyramidConfig cfg;
+    cfg.tile_size = opts->tile_size;
+    cfg.levels = pyramid_levels_for(grid_dim, opts->tile_size);
+    cfg.data = opts->pyramid_data;
+    cfg.skip_interior = opts->pyramid_skip;
+
+    printf("Pyramid: %d levels, tile %d, finest level %lld x %lld\n",
+           cfg.levels, cfg.tile_size,
+           (long long)cfg.tile_size << (cfg.levels - 1),
+           (long long)cfg.tile_size << (cfg.levels - 1));
+
+    /* Вычисление - построение пирамиды вместе с записью тайлов: запись идёт по уровням */
+    mem_phase_end(memory, MEM_LOAD);
+    mem_phase_begin(memory, MEM_COMPUTE);
+    PyramidStats stats;
+    int built = build_pyramid(out_dir, &cfg, &stats);
+    mem_phase_end(memory, MEM_COMPUTE);
+    if (!built) {
+        fprintf(stderr, "Pyramid generation failed\n");
+        return 1;
+    }
+
+    long long total = stats.finest_dim * stats.finest_dim;
+    printf("\n=== Pyramid Summary ===\n");
+    printf("Computed pixels:  %lld (%.2f%%)\n", stats.computed_pixels,
+           100.0 * stats.computed_pixels / total);
+    printf("Skipped pixels:   %lld (%.2f%%)\n", stats.skipped_pixels,
+           100.0 * stats.skipped_pixels / total);
+    printf("Render time:      %.6f seconds\n", stats.render_time);
+    printf("Downsample time:  %.6f seconds\n", stats.downsample_time);
+    printf("Write time:       %.6f seconds\n", stats.write_time);
+    printf("Tiles written:    %lld (%.2f MB)\n", stats.tiles_written,
+           stats.bytes_written / (1024.0 * 1024.0));
+    printf("=======================\n\n");
+    printf("Pyramid written to %s (index: %s/index.json)\n", out_dir, out_dir);
+    mem_profile_print(memory);
+
+    char fname[512];
+    snprintf(fname, sizeof(fname), "%s/%s_pyramid.csv", csv_dir, prefix);
+    FILE *csv = env_csv_append(fname, "nthreads,levels,tile_size,finest_dim,data,skip_interior,"
+                               "computed_pixels,skipped_pixels,render_time,downsample_time,write_time,"
+                               "tiles_written,bytes_written," MEM_CSV_HEADER "," ENV_CSV_HEADER);
+    if (!csv) {
+        fprintf(stderr, "Cannot open %s for writing\n", fname);
+        return 1;
+    }
+    fprintf(csv, "%d,%d,%d,%lld,%s,%d,%lld,%lld,%.6f,%.6f,%.6f,%lld,%lld,",
+            nthreads, cfg.levels, cfg.tile_size, stats.finest_dim,
+            cfg.data == PYRAMID_ITER ? "iter" : "member", cfg.skip_interior,
+            stats.computed_pixels, stats.skipped_pixels, stats.render_time, stats.downsample_time,
+            stats.write_time, stats.tiles_written, stats.bytes_written);
+    mem_csv_write(csv, memory);
+    fputc(',', csv);
+    env_csv_write(csv, env);
+    fputc('\n', csv);
+    fclose(csv);
+    printf("Pyramid statistics written to %s\n", fname);
+    return 0;
+}
+
+/* --- Режим извлечения контура --- */
+int run_contour(const RunOptions *opts, long long grid_dim, int nthreads,
+                const char *csv_dir, const char *prefix, const EnvInfo *env, MemProfile *memory) {
+    char out_file[512];
+    snprintf(out_file, sizeof(out_file), "%s/contour.csv", csv_dir);
+
+    ContourConfig cfg;
+    cfg.tile_cells = opts->tile_size;
+    cfg.level = opts->contour_level;
+
+    printf("Contour: level %d%s, tile %d cells\n", cfg.level,
+           cfg.level == MAX_ITERATIONS ? " (set boundary)" : "", cfg.tile_cells);
+
+    /* Вычисление - сетка итераций, ломаные и запись contour.csv */
+    mem_phase_end(memory, MEM_LOAD);
+    mem_phase_begin(memory, MEM_COMPUTE);
+    ContourStats stats;
+    int extracted = extract_contours(grid_dim, &cfg, out_file, &stats);
+    mem_phase_end(memory, MEM_COMPUTE);
+    if (!extracted) {
+        fprintf(stderr, "Contour extraction failed\n");
+        return 1;
+    }
+
+    printf("\n=== Contour Summary ===\n");
+    printf("Fragments:        %lld\n", stats.fragments);
+    printf("Polylines:        %lld (%lld closed)\n", stats.polylines, stats.closed_polylines);
+    printf("Vertices:         %lld\n", stats.points);
+    printf("Grid time:        %.6f seconds\n", stats.classify_time);
+    printf("Trace time:       %.6f seconds\n", stats.trace_time);
+    printf("Stitch time:      %.6f seconds\n", stats.stitch_time);
+    printf("Write time:       %.6f seconds\n", stats.write_time);
+    printf("Output size:      %.2f MB\n", stats.bytes_written / (1024.0 * 1024.0));
+    printf("=======================\n\n");
+    printf("Contour written to %s\n", out_file);
+    mem_profile_print(memory);
+
+    char fname[512];
+    snprintf(fname, sizeof(fname), "%s/%s_contour.csv", csv_dir, prefix);
+    FILE *csv = env_csv_append(fname, "nthreads,grid_dim,level,tile_cells,fragments,polylines,"
+                               "closed_polylines,vertices,grid_time,trace_time,stitch_time,write_time,"
+                               "bytes_written," MEM_CSV_HEADER "," ENV_CSV_HEADER);
+    if (!csv) {
+        fprintf(stderr, "Cannot open %s for writing\n", fname);
+        return 1;
+    }
+    fprintf(csv, "%d,%lld,%d,%d,%lld,%lld,%lld,%lld,%.6f,%.6f,%.6f,%.6f,%lld,",
+            nthreads, grid_dim, cfg.level, cfg.tile_cells, stats.fragments, stats.polylines,
+            stats.closed_polylines, stats.points, stats.classify_time, stats.trace_time,
+            stats.stitch_time, stats.write_time, stats.bytes_written);
+    mem_csv_write(csv, memory);
+    fputc(',', csv);
+    env_csv_write(csv, env);
+    fputc('\n', csv);
+    fclose(csv);
+    printf("Contour statistics written to %s\n", fname);
+    return 0;
+}
+
+/* --- Режим классификации массива точек ---
+ * Вход отображается в память (mmap): npoints пар double (real, imag) в порядке машины.
+ * Выход - массив того же порядка: uint8 принадлежность или uint16 число итераций */
+int run_points(const RunOptions *opts, long long npoints, int nthreads, int num_runs,
+               const char *csv_dir, const char *prefix, const EnvInfo *env, MemProfile *memory) {
+    int fd = open(opts->points_path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Cannot open %s: %s\n", opts->points_path, strerror(errno));
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0 || st.st_size % (2 * sizeof(double)) != 0) {
+        fprintf(stderr, "Error: %s is not an array of (real, imag) double pairs\n", opts->points_path);
+        close(fd);
+        return 1;
+    }
+    const double *points = (const double*)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (points == MAP_FAILED) {
+        fprintf(stderr, "Error: Cannot map %s: %s\n", opts->points_path, strerror(errno));
+        return 1;
+    }
+
+    long long file_points = (long long)(st.st_size / (2 * sizeof(double)));
+    long long count = npoints < file_points ? npoints : file_points;
+    size_t elem_size = (opts->points_data == POINTS_ITER) ? sizeof(unsigned short) : sizeof(unsigned char);
+    void *out = malloc((size_t)count * elem_size);
+    if (!out) {
+        fprintf(stderr, "Error: Failed to allocate output for %lld points\n", count);
+        munmap((void*)points, (size_t)st.st_size);
+        return 1;
+    }
+
+    printf("Points: %lld of %lld from %s, output %s\n", count, file_points, opts->points_path,
+           opts->points_data == POINTS_ITER ? "iter (uint16)" : "member (uint8)");
+    mem_phase_end(memory, MEM_LOAD);
+
+    /* Вычисление: страницы отображённого файла читаются при первом касании */
+    mem_phase_begin(memory, MEM_COMPUTE);
+
+    double min_time = 1e9, avg_time = 0.0;
+    long long found = 0;
+    LaneStats lanes;
+    for (int run = 0; run < num_runs; run++) {
+        printf("Run %d/%d: ", run + 1, num_runs);
+        fflush(stdout);
+        found = classify_points(points, count, opts->kernel, opts->points_data, out, &lanes);
+        if (lanes.time < min_time) min_time = lanes.time;
+        avg_time += lanes.time;
+        printf("Time = %.6f s, Found = %lld points (%.2f%%)\n",
+               lanes.time, found, 100.0 * found / count);
+    }
+    avg_time /= num_runs;
+    munmap((void*)points, (size_t)st.st_size);
+    mem_phase_end(memory, MEM_COMPUTE);
+
+    mem_phase_begin(memory, MEM_OUTPUT);
+    double rate = avg_time > 0.0 ? count / avg_time : 0.0;
+    printf("\n=== Points Summary ===\n");
+    printf("Points found:     %lld (%.2f%%)\n", found, 100.0 * found / count);
+    printf("Min time:         %.6f seconds\n", min_time);
+    printf("Avg time:         %.6f seconds\n", avg_time);
+    printf("Throughput:       %.3e points/s\n", rate);
+    if (opts->kernel != KERNEL_SCALAR) {
+        printf("Lane utilization: %.2f%%\n",
+               lanes.lane_slots > 0 ? 100.0 * lanes.active_slots / lanes.lane_slots : 0.0);
+    }
+    printf("======================\n\n");
+
+    FILE *f = fopen(opts->points_out, "wb");
+    if (!f || fwrite(out, elem_size, (size_t)count, f) != (size_t)count) {
+        fprintf(stderr, "Error: Cannot write %s: %s\n", opts->points_out, strerror(errno));
+        if (f) fclose(f);
+        free(out);
+        return 1;
+    }
+    fclose(f);
+    free(out);
+    printf("Classification written to %s\n", opts->points_out);
+    mem_phase_end(memory, MEM_OUTPUT);
+    mem_profile_print(memory);
+
+    char fname[512];
+    snprintf(fname, sizeof(fname), "%s/%s_points.csv", csv_dir, prefix);
+    FILE *csv = env_csv_append(fname, "kernel,nthreads,npoints,output,num_runs,points_found,min_time,avg_time,"
+                               "points_per_sec," MEM_CSV_HEADER "," ENV_CSV_HEADER);
+    if (!csv) {
+        fprintf(stderr, "Cannot open %s for writing\n", fname);
+        return 1;
+    }
+    fprintf(csv, "%s,%d,%lld,%s,%d,%lld,%.6f,%.6f,%.1f,",
+            escape_kernel_name(opts->kernel), nthreads, count,
+            opts->points_data == POINTS_ITER ? "iter" : "member",
+            num_runs, found, min_time, avg_time, rate);
+    mem_csv_write(csv, memory);
+    fputc(',', csv);
+    env_csv_write(csv, env);
+    fputc('\n', csv);
+    fclose(csv);
+    printf("Throughput written to %s\n", fname);
+    return 0;
+}
+
+/* --- Режим масштабирования по числу потоков ---
+ * Сетка, буферы результатов и принадлежности выделяются один раз; для каждого
+ * числа потоков - прогревочный запуск (создание команды потоков, страницы буферов)
+ * и num_runs замеров. Каждое число потоков - строка в <prefix>_performance.csv;
+ * фаза вычисления в профиле памяти снимается отдельно для каждого числа потоков */
+int run_sweep(const RunOptions *opts, long long npoints, long long grid_dim, int num_runs,
+              const char *csv_dir, const char *prefix, const char *cpu_info,
+              const MachinePeak *peak, const EnvInfo *env, MemProfile *memory) {
+    double real_step = (REAL_MAX - REAL_MIN) / (double)grid_dim;
+    double imag_step = (IMAG_MAX - IMAG_MIN) / (double)grid_dim;
+    long long actual_points = grid_dim * grid_dim;
+
+    long long result_capacity = actual_points / 10 + 1;
+    MandelbrotPoint *results = (MandelbrotPoint*)malloc(result_capacity * sizeof(MandelbrotPoint));
+    unsigned char *inside = NULL;
+    if (opts->kernel != KERNEL_SCALAR) inside = (unsigned char*)malloc(actual_points);
+    if (!results || (opts->kernel != KERNEL_SCALAR && !inside)) {
+        fprintf(stderr, "Error: Failed to allocate memory for results\n");
+        free(results);
+        free(inside);
+        return 1;
+    }
+    mem_phase_end(memory, MEM_LOAD);
+
+    ScalingPoint points[SCALING_MAX_POINTS];
+    PerformanceMetrics metrics[SCALING_MAX_POINTS];
+    MemProfile memories[SCALING_MAX_POINTS];
+    LaneStats lanes;
+    for (int s = 0; s < opts->sweep_count; s++) {
+        int p = opts->sweep_threads[s];
+        omp_set_num_threads(p);
+        memories[s] = *memory;
+        mem_phase_begin(&memories[s], MEM_COMPUTE);
+
+        double warmup = omp_get_wtime();
+        long long iterations;
+        long long found = compute_grid(grid_dim, real_step, imag_step, opts->kernel, inside,
+                                       &results, &result_capacity, &lanes, &iterations);
+        printf("Threads %d, warmup: Time = %.6f s\n", p, omp_get_wtime() - warmup);
+
+        PerformanceMetrics *m = &metrics[s];
+        m->nthreads = p;
+        m->npoints = npoints;
+        m->grid_dim = grid_dim;
+        m->num_runs = num_runs;
+        m->min_time = 1e9;
+        m->max_time = 0.0;
+        m->avg_time = 0.0;
+        for (int run = 0; run < num_runs; run++) {
+            double start_time = omp_get_wtime();
+            found = compute_grid(grid_dim, real_step, imag_step, opts->kernel, inside,
+                                 &results, &result_capacity, &lanes, &iterations);
+            double elapsed = omp_get_wtime() - start_time;
+            if (elapsed < m->min_time) m->min_time = elapsed;
+            if (elapsed > m->max_time) m->max_time = elapsed;
+            m->avg_time += elapsed;
+            printf("Threads %d, run %d/%d: Time = %.6f s, Found = %lld points (%.2f%%)\n",
+                   p, run + 1, num_runs, elapsed, found, 100.0 * found / actual_points);
+        }
+        m->avg_time /= num_runs;
+        m->computation_time = m->avg_time;
+        m->points_found = found;
+        m->iterations = iterations;
+        mem_phase_end(&memories[s], MEM_COMPUTE);
+        m->memory = &memories[s];
+
+        points[s].threads = p;
+        points[s].min_time = m->min_time;
+        points[s].avg_time = m->avg_time;
+        m->scaling = &points[s];
+    }
+    free(results);
+    free(inside);
+
+    scaling_compute(points, opts->sweep_count);
+    scaling_print(points, opts->sweep_count, env->affinity_cpus);
+    mem_profile_print(&memories[opts->sweep_count - 1]);
+    for (int s = 0; s < opts->sweep_count; s++) {
+        write_performance_metrics(csv_dir, prefix, &metrics[s], cpu_info, peak, env);
+    }
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
-    /* Разбор аргументов командной строки */
-    if (argc < 3) {
-        fprintf(stderr, "Usage: %s <nthreads> <npoints> [num_runs] [prefix]\n", argv[0]);
-        fprintf(stderr, "  nthreads:  number of OpenMP threads\n");
-        fprintf(stderr, "  npoints:   number of sample points (square root taken for grid dimension)\n");
-        fprintf(stderr, "  num_runs:  number of runs for averaging (default: 1)\n");
-        fprintf(stderr, "  prefix:    output file prefix (default: task1)\n");
+    /* Временная шкала фаз (только при сборке с -DENABLE_TRACE) - до любых событий */
+    TRACE_INIT("./task1/data/task1_trace.json");
+
+    /* Разбор аргументов командной строки: позиционные аргументы и опции */
+    RunOptions opts;
+    opts.pyramid = 0;
+    opts.tile_size = 256;
+    opts.pyramid_data = PYRAMID_ITER;
+    opts.pyramid_skip = 0;
+    opts.contour = 0;
+    opts.contour_level = MAX_ITERATIONS;
+    opts.kernel = KERNEL_SCALAR;
+    opts.kernel_given = 0;
+    opts.points_path = NULL;
+    opts.points_out = "./task1/data/points_out.bin";
+    opts.points_data = POINTS_MEMBER;
+    opts.rapl = 0;
+    opts.sweep_count = 0;
+
+    const char *positional[4];
+    int npositional = 0;
+    for (int a = 1; a < argc; a++) {
+        if (strncmp(argv[a], "--", 2) == 0) {
+            if (!parse_option(argc, argv, &a, &opts)) return 1;
+        } else if (npositional < 4) {
+            positional[npositional++] = argv[a];
+        } else {
+            fprintf(stderr, "Error: unexpected argument %s\n", argv[a]);
+            return 1;
+        }
+    }
+
+    if (npositional < 2) {
+        print_usage(argv[0]);
         return 1;
     }
-    
-    int nthreads = atoi(argv[1]);
-    long long npoints = atoll(argv[2]);
-    int num_runs = (argc >= 4) ? atoi(argv[3]) : 1;
-    const char *prefix = (argc >= 5) ? argv[4] : "task1";
-    
+
+    int nthreads = atoi(positional[0]);
+    long long npoints = atoll(positional[1]);
+    int num_runs = (npositional >= 3) ? atoi(positional[2]) : 1;
+    const char *prefix = (npositional >= 4) ? positional[3] : "task1";
+
     if (nthreads <= 0) {
-        fprintf(stderr, "Error: nthreads must be positive, got %s\n", argv[1]);
+        fprintf(stderr, "Error: nthreads must be positive, got %s\n", positional[0]);
         return 1;
     }
-    
+
     if (npoints <= 0) {
-        fprintf(stderr, "Error: npoints must be positive, got %s\n", argv[2]);
+        fprintf(stderr, "Error: npoints must be positive, got %s\n", positional[1]);
         return 1;
     }
     
@@ -266,13 +852,45 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "Error: num_runs must be positive, got %d\n", num_runs);
         return 1;
     }
+
+    if (opts.kernel != KERNEL_SCALAR && (opts.pyramid || opts.contour)) {
+        fprintf(stderr, "Error: --kernel is supported only without --pyramid and --contour\n");
+        return 1;
+    }
+
+    if (opts.rapl && (opts.pyramid || opts.contour || opts.points_path)) {
+        fprintf(stderr, "Error: --rapl is supported only without --pyramid, --contour and --points\n");
+        return 1;
+    }
+
+    if (opts.points_path && (opts.pyramid || opts.contour)) {
+        fprintf(stderr, "Error: --points is supported only without --pyramid and --contour\n");
+        return 1;
+    }
+
+    /* Массив точек по умолчанию классифицируется векторным ядром; scalar - для проверки */
+    if (opts.points_path && !opts.kernel_given) opts.kernel = KERNEL_STREAM;
+
+    if (opts.sweep_count > 0 && (opts.pyramid || opts.contour || opts.points_path || opts.rapl)) {
+        fprintf(stderr, "Error: --sweep is supported only without --pyramid, --contour, --points and --rapl\n");
+        return 1;
+    }
     
+    /* Память по фазам: загрузка - от подготовки до начала замеров */
+    MemProfile memory;
+    mem_profile_init(&memory);
+    mem_phase_begin(&memory, MEM_LOAD);
+
     /* Устанавливаем число потоков OpenMP */
     omp_set_num_threads(nthreads);
     
     /* Получаем информацию о CPU */
     char cpu_info[256];
     get_cpu_info(cpu_info, sizeof(cpu_info));
+    EnvInfo env;
+    env_capture(&env);
+    MachinePeak peak;
+    peak_estimate(&peak, &env);
     
     /* Создаём директорию для вывода */
     const char *csv_dir = "./task1/data";
@@ -284,14 +902,45 @@ int main(int argc, char *argv[]) {
     
     printf("=== OpenMP Mandelbrot Set Benchmark ===\n");
     printf("CPU: %s\n", cpu_info);
-    printf("Threads: %d\n", nthreads);
+    env_print(&env);
+    peak_print(&peak);
+    if (opts.sweep_count > 0) {
+        printf("Threads: sweep");
+        for (int s = 0; s < opts.sweep_count; s++) printf("%s%d", s > 0 ? "," : " ", opts.sweep_threads[s]);
+        printf(" (warmup run before each)\n");
+    } else {
+        printf("Threads: %d\n", nthreads);
+    }
     printf("Requested points: %lld\n", npoints);
-    printf("Grid: %lld x %lld\n", grid_dim, grid_dim);
-    printf("Actual points: %lld\n", actual_points);
+    if (!opts.points_path) {
+        printf("Grid: %lld x %lld\n", grid_dim, grid_dim);
+        printf("Actual points: %lld\n", actual_points);
+    }
+    printf("Kernel: %s\n", escape_kernel_name(opts.kernel));
     printf("Number of runs: %d\n", num_runs);
     printf("Measurement method: %s\n", num_runs > 1 ? "Average over multiple runs" : "Single run");
     printf("========================================\n\n");
-    
+
+    /* Массив точек из файла заменяет сетку */
+    if (opts.points_path) {
+        return run_points(&opts, npoints, nthreads, num_runs, csv_dir, prefix, &env, &memory);
+    }
+
+    /* Серия замеров по числу потоков заменяет одиночный замер */
+    if (opts.sweep_count > 0) {
+        return run_sweep(&opts, npoints, grid_dim, num_runs, csv_dir, prefix, cpu_info, &peak, &env, &memory);
+    }
+
+    /* Пирамида тайлов заменяет вычисление списка точек */
+    if (opts.pyramid) {
+        return run_pyramid(&opts, grid_dim, nthreads, csv_dir, prefix, &env, &memory);
+    }
+
+    /* Контур границы заменяет вычисление списка точек */
+    if (opts.contour) {
+        return run_contour(&opts, grid_dim, nthreads, csv_dir, prefix, &env, &memory);
+    }
+
     /* Вычисляем шаги для выборки комплексной плоскости */
     double real_step = (REAL_MAX - REAL_MIN) / (double)grid_dim;
     double imag_step = (IMAG_MAX - IMAG_MIN) / (double)grid_dim;
@@ -302,6 +951,9 @@ int main(int argc, char *argv[]) {
     metrics.npoints = npoints;
     metrics.grid_dim = grid_dim;
     metrics.num_runs = num_runs;
+    metrics.scaling = NULL;
+    metrics.memory = &memory;
+    metrics.iterations = 0;
     metrics.min_time = 1e9;
     metrics.max_time = 0.0;
     metrics.avg_time = 0.0;
@@ -310,6 +962,24 @@ int main(int argc, char *argv[]) {
     MandelbrotPoint *results = NULL;
     long long result_count = 0;
     long long result_capacity = actual_points / 10;
+
+    /* Энергия по счётчикам RAPL */
+    RaplCounters rapl;
+    if (opts.rapl) rapl_open(&rapl);
+
+    /* Принадлежность по ячейкам для векторных ядер */
+    unsigned char *inside = NULL;
+    LaneStats lanes;
+    memset(&lanes, 0, sizeof(lanes));
+    if (opts.kernel != KERNEL_SCALAR) {
+        inside = (unsigned char*)malloc(actual_points);
+        if (!inside) {
+            fprintf(stderr, "Error: Failed to allocate cell membership buffer\n");
+            return 1;
+        }
+    }
+    mem_phase_end(&memory, MEM_LOAD);
+    mem_phase_begin(&memory, MEM_COMPUTE);
     
     /* Выполняем несколько запусков для усреднения */
     for (int run = 0; run < num_runs; run++) {
@@ -328,15 +998,20 @@ int main(int argc, char *argv[]) {
             result_count = 0;
         }
         
+        /* Счётчики энергии читаются вне замера времени */
+        if (opts.rapl) rapl_start(&rapl);
+
         /* Запускаем таймер */
         double start_time = omp_get_wtime();
         
         /* Выполняем вычисление */
-        result_count = compute_mandelbrot(grid_dim, real_step, imag_step, &results, &result_capacity);
+        result_count = compute_grid(grid_dim, real_step, imag_step, opts.kernel, inside,
+                                    &results, &result_capacity, &lanes, &metrics.iterations);
         
         /* Останавливаем таймер */
         double end_time = omp_get_wtime();
         double elapsed = end_time - start_time;
+        if (opts.rapl) rapl_stop(&rapl);
         
         /* Обновляем метрики */
         if (elapsed < metrics.min_time) metrics.min_time = elapsed;
@@ -351,6 +1026,8 @@ int main(int argc, char *argv[]) {
     metrics.avg_time /= num_runs;
     metrics.computation_time = metrics.avg_time;
     metrics.points_found = result_count;
+    mem_phase_end(&memory, MEM_COMPUTE);
+    mem_phase_begin(&memory, MEM_OUTPUT);
     
     printf("\n=== Performance Summary ===\n");
     printf("Points found: %lld (%.2f%% of samples)\n",
@@ -363,7 +1040,40 @@ int main(int argc, char *argv[]) {
     } else {
         printf("Elapsed time: %.6f seconds\n", metrics.computation_time);
     }
+    /* Итерации не зависят от запуска: нормированная скорость сравнима между размерами сетки */
+    double giter = metrics.iterations / metrics.avg_time * 1e-9;
+    double gflops = giter * MANDELBROT_FLOPS_PER_ITER;
+    printf("Iterations:   %lld (%.1f per point)\n", metrics.iterations, (double)metrics.iterations / actual_points);
+    printf("Throughput:   %.3f Giter/s, %.2f GFLOP/s", giter, gflops);
+    if (peak.gflops > 0.0) printf(" (%.2f%% of peak)", 100.0 * peak_fraction(&peak, gflops));
+    printf("\n");
     printf("===========================\n\n");
+
+    if (opts.rapl) {
+        write_rapl_report(csv_dir, prefix, &rapl, &metrics, &env);
+    }
+
+    /* Ядро на roofline машины. Итерации идут в регистрах; память - только результаты:
+     * точка множества пишется в буфер потока и копируется при слиянии (48 байт),
+     * у векторных ядер ещё запись и чтение байта принадлежности каждой ячейки */
+    {
+        Roofline roofline;
+        roofline_load(&roofline, ROOFLINE_CSV_PATH, nthreads);
+        char roofline_csv[512], kernel_name[64];
+        snprintf(roofline_csv, sizeof(roofline_csv), "%s/%s_roofline.csv", csv_dir, prefix);
+        snprintf(kernel_name, sizeof(kernel_name), "mandelbrot_%s", escape_kernel_name(opts.kernel));
+        double bytes = (opts.kernel == KERNEL_SCALAR)
+                       ? 3.0 * sizeof(MandelbrotPoint) * result_count
+                       : 2.0 * actual_points + sizeof(MandelbrotPoint) * result_count;
+        roofline_report(&roofline, kernel_name, nthreads, (double)metrics.iterations * MANDELBROT_FLOPS_PER_ITER,
+                        bytes, metrics.avg_time, bytes / nthreads, env.hash, roofline_csv);
+    }
+
+    /* Загрузка дорожек - по последнему запуску (не зависит от запуска) */
+    if (opts.kernel != KERNEL_SCALAR) {
+        write_lane_stats(csv_dir, prefix, opts.kernel, nthreads, grid_dim, &lanes, metrics.avg_time);
+        free(inside);
+    }
     
     /* Записываем результаты в CSV файл */
     char csv_path[512];
@@ -385,9 +1095,11 @@ int main(int argc, char *argv[]) {
     
     fclose(f);
     printf("Results written to %s\n", csv_path);
+    mem_phase_end(&memory, MEM_OUTPUT);
+    mem_profile_print(&memory);
     
     /* Записываем метрики производительности */
-    write_performance_metrics(csv_dir, prefix, &metrics, cpu_info);
+    write_performance_metrics(csv_dir, prefix, &metrics, cpu_info, &peak, &env);
     
     /* Очистка */
     free(results);
@@ -0,0 +1,122 @@
+/* cell_list.c
+ * Список ячеек для поиска соседей в радиусе отсечения
+ */
+
+#include "cell_list.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Координата ячейки вдоль одной оси */
+static inline int axis_cell(const CellList *cl, double pos, double origin) {
+    double u = (pos - origin) / cl->cell;
+    if (cl->periodic) {
+        u = fmod(u, (double)cl->nc);
+        if (u < 0.0) u += cl->nc;
+    }
+    int c = (int)floor(u);
+    if (c < 0) c = 0;
+    if (c >= cl->nc) c = cl->nc - 1;
+    return c;
+}
+
+int cl_build(CellList *cl, const Body *bodies, const double origin[3], double box,
+             double min_cell, int periodic) {
+    int n = cl->n;
+    /* Ограничение до перевода в int: box / min_cell может превышать INT_MAX */
+    double ratio = (min_cell > 0.0) ? floor(box / min_cell) : 1.0;
+    if (!(ratio >= 1.0)) ratio = 1.0;
+    if (ratio > CELL_LIST_MAX_AXIS) ratio = CELL_LIST_MAX_AXIS;
+    int nc = (int)ratio;
+    /* При периодичности и nc < 3 соседние ячейки совпадали бы - одна ячейка на весь куб */
+    if (periodic && nc < 3) nc = 1;
+
+    int ncells = nc * nc * nc;
+    if (ncells + 1 > cl->capacity) {
+        int *start = (int*)realloc(cl->cell_start, (size_t)(ncells + 1) * sizeof(int));
+        if (!start) {
+            fprintf(stderr, "Error: Failed to allocate cell list (%d^3 cells)\n", nc);
+            return 0;
+        }
+        cl->cell_start = start;
+        cl->capacity = ncells + 1;
+    }
+
+    cl->nc = nc;
+    cl->box = box;
+    cl->cell = box / nc;
+    cl->periodic = periodic;
+    for (int d = 0; d < 3; d++) cl->origin[d] = origin[d];
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        int cx = axis_cell(cl, bodies[i].x, origin[0]);
+        int cy = axis_cell(cl, bodies[i].y, origin[1]);
+        int cz = axis_cell(cl, bodies[i].z, origin[2]);
+        cl->cell_of[i] = cl_cell_index(cl, cx, cy, cz);
+    }
+
+    /* Сортировка подсчётом: число тел в ячейках -> начала -> раскладка */
+    memset(cl->cell_start, 0, (size_t)(ncells + 1) * sizeof(int));
+    for (int i = 0; i < n; i++) cl->cell_start[cl->cell_of[i] + 1]++;
+    for (int c = 0; c < ncells; c++) cl->cell_start[c + 1] += cl->cell_start[c];
+    for (int i = 0; i < n; i++) {
+        /* cell_start[c] служит курсором записи; после раскладки указывает на конец ячейки */
+        cl->index[cl->cell_start[cl->cell_of[i]]++] = i;
+    }
+    /* Конец ячейки c - начало ячейки c+1: сдвигаем обратно */
+    for (int c = ncells; c > 0; c--) cl->cell_start[c] = cl->cell_start[c - 1];
+    cl->cell_start[0] = 0;
+
+    return 1;
+}
+
+int cl_neighbor_cells(const CellList *cl, int c, int out[27]) {
+    int nc = cl->nc;
+    if (nc == 1) {
+        out[0] = 0;
+        return 1;
+    }
+
+    int cx = c / (nc * nc), cy = (c / nc) % nc, cz = c % nc;
+    int count = 0;
+    for (int dx = -1; dx <= 1; dx++) {
+        int x = cx + dx;
+        if (cl->periodic) x = (x + nc) % nc;
+        else if (x < 0 || x >= nc) continue;
+        for (int dy = -1; dy <= 1; dy++) {
+            int y = cy + dy;
+            if (cl->periodic) y = (y + nc) % nc;
+            else if (y < 0 || y >= nc) continue;
+            for (int dz = -1; dz <= 1; dz++) {
+                int z = cz + dz;
+                if (cl->periodic) z = (z + nc) % nc;
+                else if (z < 0 || z >= nc) continue;
+                out[count++] = cl_cell_index(cl, x, y, z);
+            }
+        }
+    }
+    return count;
+}
+
+int cl_init(CellList *cl, int n) {
+    memset(cl, 0, sizeof(*cl));
+    cl->n = n;
+    cl->index = (int*)malloc((size_t)n * sizeof(int));
+    cl->cell_of = (int*)malloc((size_t)n * sizeof(int));
+    if (!cl->index || !cl->cell_of) {
+        fprintf(stderr, "Error: Failed to allocate cell list (n=%d)\n", n);
+        cl_free(cl);
+        return 0;
+    }
+    return 1;
+}
+
+void cl_free(CellList *cl) {
+    free(cl->cell_start);
+    free(cl->index);
+    free(cl->cell_of);
+    memset(cl, 0, sizeof(*cl));
+}
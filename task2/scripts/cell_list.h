@@ -0,0 +1,44 @@
+/* cell_list.h
+ * Список ячеек: куб делится на nc^3 ячеек с ребром не меньше радиуса отсечения,
+ * тела сортируются по ячейкам подсчётом. Соседи тела на расстоянии до радиуса
+ * отсечения лежат в его ячейке или в 26 соседних.
+ */
+
+#ifndef CELL_LIST_H
+#define CELL_LIST_H
+
+#include "nbody.h"
+
+#define CELL_LIST_MAX_AXIS 128     /* Ограничение числа ячеек по оси (память nc^3) */
+
+typedef struct {
+    int n;
+    int nc;                 /* Ячеек по оси */
+    double origin[3];       /* Угол куба */
+    double box;             /* Ребро куба */
+    double cell;            /* Ребро ячейки */
+    int periodic;           /* Периодические границы (иначе тела снаружи - в крайних ячейках) */
+    int *cell_start;        /* Тела ячейки c: index[cell_start[c] .. cell_start[c+1]) */
+    int *index;             /* Номера тел, упорядоченные по ячейкам */
+    int *cell_of;           /* Ячейка каждого тела */
+    int capacity;           /* Выделено элементов cell_start */
+} CellList;
+
+/* Выделение буферов для n тел; возвращает 0 при ошибке */
+int cl_init(CellList *cl, int n);
+
+/* Раскладка тел по ячейкам с ребром не меньше min_cell; возвращает 0 при ошибке */
+int cl_build(CellList *cl, const Body *bodies, const double origin[3], double box,
+             double min_cell, int periodic);
+
+/* Индекс ячейки по координатам ячейки (с учётом периодичности) */
+static inline int cl_cell_index(const CellList *cl, int cx, int cy, int cz) {
+    return (cx * cl->nc + cy) * cl->nc + cz;
+}
+
+/* Различные соседние ячейки (включая саму ячейку); возвращает их число (до 27) */
+int cl_neighbor_cells(const CellList *cl, int c, int out[27]);
+
+void cl_free(CellList *cl);
+
+#endif /* CELL_LIST_H */
@@ -0,0 +1,302 @@
+/* ewald.c
+ * Периодическая гравитация суммированием Эвальда
+ */
+
+#include "ewald.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define EWALD_COST_RATIO 40.0
+
+/* --- Прямое пространство: короткодействующая часть в радиусе отсечения --- */
+/* Тела копируются в SoA-массивы в порядке ячеек с координатами, приведёнными в куб,
+ * так что тела соседней ячейки лежат подряд. Параллельно по ячейкам, каждое тело
+ * суммирует всех соседей (без гонок за силы j) */
+static void real_space_forces(EwaldState *s, const Body *bodies, int n,
+                              double *fx, double *fy, double *fz) {
+    const CellList *cl = &s->cells;
+    double box = s->box, half = 0.5 * box, inv_box = 1.0 / box;
+    double alpha = s->alpha, rc2 = s->rc * s->rc;
+    double two_alpha_sqrtpi = 2.0 * alpha / sqrt(M_PI);
+    double *cx = s->cx, *cy = s->cy, *cz = s->cz, *cm = s->cm;
+
+    #pragma omp parallel for schedule(static)
+    for (int p = 0; p < n; p++) {
+        const Body *b = &bodies[cl->index[p]];
+        double u[3] = {b->x - s->origin[0], b->y - s->origin[1], b->z - s->origin[2]};
+        for (int d = 0; d < 3; d++) u[d] -= box * floor(u[d] * inv_box);
+        cx[p] = u[0];
+        cy[p] = u[1];
+        cz[p] = u[2];
+        cm[p] = b->mass;
+    }
+
+    int ncells = cl->nc * cl->nc * cl->nc;
+
+    #pragma omp parallel for schedule(dynamic, 4)
+    for (int c = 0; c < ncells; c++) {
+        int neighbors[27];
+        int nn = cl_neighbor_cells(cl, c, neighbors);
+
+        for (int pi = cl->cell_start[c]; pi < cl->cell_start[c + 1]; pi++) {
+            double xi = cx[pi], yi = cy[pi], zi = cz[pi];
+            double ax = 0.0, ay = 0.0, az = 0.0;
+
+            for (int q = 0; q < nn; q++) {
+                int lo = cl->cell_start[neighbors[q]], hi = cl->cell_start[neighbors[q] + 1];
+
+                #pragma omp simd reduction(+:ax, ay, az)
+                for (int pj = lo; pj < hi; pj++) {
+                    /* Ближайший образ: координаты в кубе, rc <= box / 2 */
+                    double dx = cx[pj] - xi;
+                    double dy = cy[pj] - yi;
+                    double dz = cz[pj] - zi;
+                    dx = (dx > half) ? dx - box : ((dx < -half) ? dx + box : dx);
+                    dy = (dy > half) ? dy - box : ((dy < -half) ? dy + box : dy);
+                    dz = (dz > half) ? dz - box : ((dz < -half) ? dz + box : dz);
+
+                    double r_sq = dx*dx + dy*dy + dz*dz;
+                    if (r_sq < rc2 && pj != pi) {
+                        r_sq += SOFTENING;
+                        double r = sqrt(r_sq);
+                        double ar = alpha * r;
+                        double k = cm[pj] * (erfc(ar) / r + two_alpha_sqrtpi * exp(-ar * ar)) / r_sq;
+                        ax += k * dx;
+                        ay += k * dy;
+                        az += k * dz;
+                    }
+                }
+            }
+
+            int i = cl->index[pi];
+            double gm = G * cm[pi];
+            fx[i] = gm * ax;
+            fy[i] = gm * ay;
+            fz[i] = gm * az;
+        }
+    }
+}
+
+/* Таблица exp(i 2 pi m u), m = -kmax..kmax, для одной оси (re, im чередуются) */
+static inline void axis_phases(double *table, double u, int kmax) {
+    double c1 = cos(2.0 * M_PI * u), s1 = sin(2.0 * M_PI * u);
+    double *zero = table + 2 * kmax;
+    zero[0] = 1.0;
+    zero[1] = 0.0;
+    for (int m = 1; m <= kmax; m++) {
+        double re = zero[2*(m-1)] * c1 - zero[2*(m-1)+1] * s1;
+        double im = zero[2*(m-1)] * s1 + zero[2*(m-1)+1] * c1;
+        zero[2*m] = re;
+        zero[2*m+1] = im;
+        zero[-2*m] = re;        /* exp(-i m theta) - сопряжённое */
+        zero[-2*m+1] = -im;
+    }
+}
+
+/* Таблицы фаз тела по трём осям */
+static inline void body_phases(const EwaldState *s, const Body *b, double *px, double *py, double *pz) {
+    double inv_box = 1.0 / s->box;
+    axis_phases(px, (b->x - s->origin[0]) * inv_box, s->kmax);
+    axis_phases(py, (b->y - s->origin[1]) * inv_box, s->kmax);
+    axis_phases(pz, (b->z - s->origin[2]) * inv_box, s->kmax);
+}
+
+/* --- Обратное пространство: структурный фактор и силы по волновым векторам --- */
+/* cos, sin(k r) собираются произведением табличных фаз по осям; циклы по k векторизуются */
+static void reciprocal_forces(EwaldState *s, const Body *bodies, int n,
+                              double *fx, double *fy, double *fz) {
+    int nk = s->nk;
+    int table = 2 * (2 * s->kmax + 1);
+    const int *kix = s->kix, *kiy = s->kiy, *kiz = s->kiz;
+    const double *kx = s->kx, *ky = s->ky, *kz = s->kz;
+    const double *sk_cos = s->sk_cos, *sk_sin = s->sk_sin;
+
+    #pragma omp parallel num_threads(s->nthreads)
+    {
+        int tid = omp_get_thread_num();
+        int nt = omp_get_num_threads();
+        double *px = s->phase + (size_t)tid * 3 * table;
+        double *py = px + table;
+        double *pz = py + table;
+        double *part_cos = s->sk_thread + (size_t)tid * 2 * nk;
+        double *part_sin = part_cos + nk;
+        memset(part_cos, 0, 2 * (size_t)nk * sizeof(double));
+
+        /* Частичные структурные факторы по телам потока */
+        #pragma omp for schedule(static)
+        for (int i = 0; i < n; i++) {
+            body_phases(s, &bodies[i], px, py, pz);
+            double m = bodies[i].mass;
+
+            #pragma omp simd
+            for (int k = 0; k < nk; k++) {
+                double xr = px[2*kix[k]], xi = px[2*kix[k]+1];
+                double yr = py[2*kiy[k]], yi = py[2*kiy[k]+1];
+                double zr = pz[2*kiz[k]], zi = pz[2*kiz[k]+1];
+                double xyr = xr * yr - xi * yi;
+                double xyi = xr * yi + xi * yr;
+                part_cos[k] += m * (xyr * zr - xyi * zi);
+                part_sin[k] += m * (xyr * zi + xyi * zr);
+            }
+        }
+        /* Неявный барьер: частичные суммы готовы */
+
+        #pragma omp for schedule(static)
+        for (int k = 0; k < nk; k++) {
+            double c = 0.0, sn = 0.0;
+            for (int t = 0; t < nt; t++) {
+                c += s->sk_thread[(size_t)t * 2 * nk + k];
+                sn += s->sk_thread[(size_t)t * 2 * nk + nk + k];
+            }
+            /* Множитель волнового вектора включён заранее */
+            s->sk_cos[k] = s->kcoef[k] * c;
+            s->sk_sin[k] = s->kcoef[k] * sn;
+        }
+
+        /* Силы: F_i = -G m_i sum_k coef_k k [sin(k r_i) C_k - cos(k r_i) S_k] */
+        #pragma omp for schedule(static)
+        for (int i = 0; i < n; i++) {
+            body_phases(s, &bodies[i], px, py, pz);
+            double ax = 0.0, ay = 0.0, az = 0.0;
+
+            #pragma omp simd reduction(+:ax, ay, az)
+            for (int k = 0; k < nk; k++) {
+                double xr = px[2*kix[k]], xi = px[2*kix[k]+1];
+                double yr = py[2*kiy[k]], yi = py[2*kiy[k]+1];
+                double zr = pz[2*kiz[k]], zi = pz[2*kiz[k]+1];
+                double xyr = xr * yr - xi * yi;
+                double xyi = xr * yi + xi * yr;
+                double cos_kr = xyr * zr - xyi * zi;
+                double sin_kr = xyr * zi + xyi * zr;
+                double w = sin_kr * sk_cos[k] - cos_kr * sk_sin[k];
+                ax += w * kx[k];
+                ay += w * ky[k];
+                az += w * kz[k];
+            }
+
+            double gm = G * bodies[i].mass;
+            fx[i] -= gm * ax;
+            fy[i] -= gm * ay;
+            fz[i] -= gm * az;
+        }
+    }
+}
+
+int ewald_forces(EwaldState *s, const Body *bodies, int n, double *fx, double *fy, double *fz) {
+    double t0 = omp_get_wtime();
+    if (!cl_build(&s->cells, bodies, s->origin, s->box, s->rc, 1)) return 0;
+    real_space_forces(s, bodies, n, fx, fy, fz);
+    double t1 = omp_get_wtime();
+    reciprocal_forces(s, bodies, n, fx, fy, fz);
+    double t2 = omp_get_wtime();
+
+    s->timings.real += t1 - t0;
+    s->timings.reciprocal += t2 - t1;
+    s->timings.evaluations++;
+    return 1;
+}
+
+int ewald_init(EwaldState *s, const Body *bodies, int n, double box,
+               double alpha_box, double tol, int nthreads) {
+    memset(s, 0, sizeof(*s));
+    s->nthreads = nthreads;
+
+    if (box > 0.0) {
+        s->box = box;
+    } else {
+        s->box = bounding_cube(bodies, n, s->origin);
+        if (s->box <= 0.0) s->box = 1.0;
+    }
+
+    /* Обе части убывают как exp(-x^2): x = alpha rc в прямом пространстве
+     * и x = pi kmax / (alpha box) в обратном */
+    double x = sqrt(-log(tol));
+    if (alpha_box <= 0.0) {
+        /* Баланс стоимостей N^2 (rc / box)^3 c_real = N kmax^3 c_recip даёт
+         * alpha box = sqrt(pi) (N c_real / c_recip)^(1/6); отношение стоимостей пары
+         * в прямом пространстве (erfc, exp) и слагаемого по k измерено около 40 */
+        alpha_box = sqrt(M_PI) * pow(EWALD_COST_RATIO * n, 1.0 / 6.0);
+    }
+    /* Ближайший образ требует rc <= box / 2 */
+    if (alpha_box < 2.0 * x) alpha_box = 2.0 * x;
+    s->alpha = alpha_box / s->box;
+    s->rc = x / s->alpha;
+    s->kmax = (int)ceil(x * alpha_box / M_PI);
+
+    if (!cl_init(&s->cells, n)) return 0;
+    s->cx = (double*)malloc((size_t)n * sizeof(double));
+    s->cy = (double*)malloc((size_t)n * sizeof(double));
+    s->cz = (double*)malloc((size_t)n * sizeof(double));
+    s->cm = (double*)malloc((size_t)n * sizeof(double));
+
+    /* Волновые векторы полупространства внутри сферы |n| <= kmax */
+    int kmax = s->kmax;
+    int side = 2 * kmax + 1;
+    size_t max_k = (size_t)side * side * side / 2 + 1;
+    s->kix = (int*)malloc(max_k * sizeof(int));
+    s->kiy = (int*)malloc(max_k * sizeof(int));
+    s->kiz = (int*)malloc(max_k * sizeof(int));
+    s->kx = (double*)malloc(max_k * sizeof(double));
+    s->ky = (double*)malloc(max_k * sizeof(double));
+    s->kz = (double*)malloc(max_k * sizeof(double));
+    s->kcoef = (double*)malloc(max_k * sizeof(double));
+    s->sk_cos = (double*)malloc(max_k * sizeof(double));
+    s->sk_sin = (double*)malloc(max_k * sizeof(double));
+    s->sk_thread = (double*)malloc((size_t)nthreads * 2 * max_k * sizeof(double));
+    s->phase = (double*)malloc((size_t)nthreads * 3 * 2 * side * sizeof(double));
+    if (!s->kix || !s->kiy || !s->kiz || !s->kx || !s->ky || !s->kz || !s->kcoef ||
+        !s->sk_cos || !s->sk_sin || !s->sk_thread || !s->phase ||
+        !s->cx || !s->cy || !s->cz || !s->cm) {
+        fprintf(stderr, "Error: Failed to allocate Ewald tables (kmax=%d)\n", kmax);
+        ewald_free(s);
+        return 0;
+    }
+
+    double volume = s->box * s->box * s->box;
+    double two_pi_box = 2.0 * M_PI / s->box;
+    int nk = 0;
+    for (int a = 0; a <= kmax; a++) {
+        for (int b = -kmax; b <= kmax; b++) {
+            for (int c = -kmax; c <= kmax; c++) {
+                /* Одна половина пар (n, -n) */
+                if (a == 0 && (b < 0 || (b == 0 && c <= 0))) continue;
+                if (a*a + b*b + c*c > kmax * kmax) continue;
+
+                double kx = two_pi_box * a, ky = two_pi_box * b, kz = two_pi_box * c;
+                double k2 = kx*kx + ky*ky + kz*kz;
+                s->kix[nk] = a + kmax;
+                s->kiy[nk] = b + kmax;
+                s->kiz[nk] = c + kmax;
+                s->kx[nk] = kx;
+                s->ky[nk] = ky;
+                s->kz[nk] = kz;
+                s->kcoef[nk] = 2.0 * 4.0 * M_PI / volume
+                             * exp(-k2 / (4.0 * s->alpha * s->alpha)) / k2;
+                nk++;
+            }
+        }
+    }
+    s->nk = nk;
+
+    return 1;
+}
+
+void ewald_free(EwaldState *s) {
+    cl_free(&s->cells);
+    free(s->kix); free(s->kiy); free(s->kiz);
+    free(s->kx); free(s->ky); free(s->kz);
+    free(s->kcoef);
+    free(s->sk_cos); free(s->sk_sin);
+    free(s->sk_thread);
+    free(s->phase);
+    free(s->cx); free(s->cy); free(s->cz); free(s->cm);
+    memset(s, 0, sizeof(*s));
+}
@@ -0,0 +1,54 @@
+/* ewald.h
+ * Периодическая гравитация суммированием Эвальда: потенциал делится параметром
+ * alpha на короткодействующую часть (erfc, радиус отсечения, список ячеек)
+ * и гладкую часть, суммируемую по волновым векторам. Больший alpha переносит
+ * работу из прямого пространства в обратное; точность задаётся допуском tol.
+ */
+
+#ifndef EWALD_H
+#define EWALD_H
+
+#include "nbody.h"
+#include "cell_list.h"
+
+/* Время частей (секунды, сумма по всем вычислениям сил) */
+typedef struct {
+    double real;            /* Прямое пространство, включая построение списка ячеек */
+    double reciprocal;      /* Обратное пространство */
+    int evaluations;
+} EwaldTimings;
+
+typedef struct {
+    double box;             /* Ребро периодического куба, м */
+    double origin[3];
+    double alpha;           /* Параметр разделения, 1/м */
+    double rc;              /* Радиус отсечения прямой части */
+    int kmax;               /* |n| <= kmax для k = 2 pi n / box */
+    int nthreads;
+
+    CellList cells;
+    double *cx, *cy, *cz, *cm;      /* Тела в порядке ячеек, координаты в кубе */
+
+    /* Волновые векторы полупространства (k и -k учтены вместе) */
+    int nk;
+    int *kix, *kiy, *kiz;   /* Индексы nx, ny, nz + kmax в таблицах фаз */
+    double *kx, *ky, *kz;
+    double *kcoef;          /* 2 * 4 pi / V * exp(-k^2 / 4 alpha^2) / k^2 */
+    double *sk_cos, *sk_sin;        /* kcoef * структурный фактор: sum m cos(k r), sum m sin(k r) */
+    double *sk_thread;              /* Пер-поточные частичные суммы: nthreads * 2 * nk */
+    double *phase;                  /* Пер-поточные таблицы exp(i 2 pi m x / box): nthreads * 6 * (2 kmax + 1) */
+
+    EwaldTimings timings;
+} EwaldState;
+
+/* box <= 0 - куб вокруг начальных положений; alpha_box = alpha * box (0 - выбор по N);
+ * tol - допуск погрешности обеих частей. Возвращает 0 при ошибке */
+int ewald_init(EwaldState *s, const Body *bodies, int n, double box,
+               double alpha_box, double tol, int nthreads);
+
+/* Силы на тела (F = m a) в fx, fy, fz. Возвращает 0, если не построен список ячеек */
+int ewald_forces(EwaldState *s, const Body *bodies, int n, double *fx, double *fy, double *fz);
+
+void ewald_free(EwaldState *s);
+
+#endif /* EWALD_H */
@@ -0,0 +1,223 @@
+/* fof.c
+ * Поиск групп друзей-друзей и запись каталогов групп
+ */
+
+#include "fof.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+
+/* --- Объединение множеств без блокировок ---
+ * Корень всегда связывается с корнем меньшего номера, поэтому номера вдоль пути
+ * к корню строго убывают и циклов не бывает. Связь ставится сравнением с обменом:
+ * если другой поток успел переподвесить корень, поиск повторяется. */
+static inline int uf_find(int *parent, int x) {
+    for (;;) {
+        int p = __atomic_load_n(&parent[x], __ATOMIC_ACQUIRE);
+        if (p == x) return x;
+        int gp = __atomic_load_n(&parent[p], __ATOMIC_ACQUIRE);
+        /* Сокращение пути вдвое: gp остаётся предком x при любых параллельных связях */
+        if (gp != p) {
+            __atomic_compare_exchange_n(&parent[x], &p, gp, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+        }
+        x = gp;
+    }
+}
+
+static inline void uf_union(int *parent, int a, int b) {
+    for (;;) {
+        a = uf_find(parent, a);
+        b = uf_find(parent, b);
+        if (a == b) return;
+        if (a < b) {
+            int t = a;
+            a = b;
+            b = t;
+        }
+        int expected = a;
+        if (__atomic_compare_exchange_n(&parent[a], &expected, b, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            return;
+        }
+    }
+}
+
+/* --- Связывание пар ближе длины связи: параллельно по ячейкам --- */
+static void link_pairs(FofState *s, const Body *bodies) {
+    const CellList *cl = &s->cl;
+    int ncells = cl->nc * cl->nc * cl->nc;
+    double link2 = s->link * s->link;
+
+    #pragma omp parallel for schedule(dynamic, 16) num_threads(s->nthreads)
+    for (int c = 0; c < ncells; c++) {
+        int begin = cl->cell_start[c], end = cl->cell_start[c + 1];
+        if (begin == end) continue;
+
+        int neigh[27];
+        int count = cl_neighbor_cells(cl, c, neigh);
+        for (int a = begin; a < end; a++) {
+            int i = cl->index[a];
+            double xi = bodies[i].x, yi = bodies[i].y, zi = bodies[i].z;
+            for (int k = 0; k < count; k++) {
+                int c2 = neigh[k];
+                /* Каждая пара ячеек просматривается один раз */
+                if (c2 < c) continue;
+                int b = (c2 == c) ? a + 1 : cl->cell_start[c2];
+                int b_end = cl->cell_start[c2 + 1];
+                for (; b < b_end; b++) {
+                    int j = cl->index[b];
+                    double dx = bodies[j].x - xi;
+                    double dy = bodies[j].y - yi;
+                    double dz = bodies[j].z - zi;
+                    if (dx * dx + dy * dy + dz * dz < link2) uf_union(s->parent, i, j);
+                }
+            }
+        }
+    }
+}
+
+/* --- Сборка каталога: корни -> номера групп -> списки тел -> свойства групп ---
+ * Возвращает число групп; группы идут в порядке наименьшего номера тела,
+ * поэтому каталог не зависит от числа потоков */
+static int collect_groups(FofState *s, const Body *bodies, int n) {
+    int *parent = s->parent;
+
+    /* Все тела подвешиваются прямо к корню */
+    #pragma omp parallel for schedule(static) num_threads(s->nthreads)
+    for (int i = 0; i < n; i++) {
+        __atomic_store_n(&parent[i], uf_find(parent, i), __ATOMIC_RELAXED);
+    }
+
+    memset(s->size, 0, (size_t)n * sizeof(int));
+    for (int i = 0; i < n; i++) s->size[parent[i]]++;
+
+    int ngroups = 0;
+    for (int r = 0; r < n; r++) {
+        s->group_of[r] = (parent[r] == r && s->size[r] >= s->min_members) ? ngroups++ : -1;
+    }
+
+    /* Сортировка подсчётом тел по группам, как в списке ячеек */
+    memset(s->member_start, 0, (size_t)(ngroups + 1) * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        int g = s->group_of[parent[i]];
+        if (g >= 0) s->member_start[g + 1]++;
+    }
+    for (int g = 0; g < ngroups; g++) s->member_start[g + 1] += s->member_start[g];
+    for (int i = 0; i < n; i++) {
+        int g = s->group_of[parent[i]];
+        if (g >= 0) s->members[s->member_start[g]++] = i;
+    }
+    for (int g = ngroups; g > 0; g--) s->member_start[g] = s->member_start[g - 1];
+    s->member_start[0] = 0;
+
+    #pragma omp parallel for schedule(dynamic, 4) num_threads(s->nthreads)
+    for (int g = 0; g < ngroups; g++) {
+        double m = 0.0, x = 0.0, y = 0.0, z = 0.0, vx = 0.0, vy = 0.0, vz = 0.0;
+        for (int k = s->member_start[g]; k < s->member_start[g + 1]; k++) {
+            const Body *b = &bodies[s->members[k]];
+            m += b->mass;
+            x += b->mass * b->x;
+            y += b->mass * b->y;
+            z += b->mass * b->z;
+            vx += b->mass * b->vx;
+            vy += b->mass * b->vy;
+            vz += b->mass * b->vz;
+        }
+        double inv = (m > 0.0) ? 1.0 / m : 0.0;
+        double *p = s->props + (size_t)g * 7;
+        p[0] = m;
+        p[1] = x * inv;
+        p[2] = y * inv;
+        p[3] = z * inv;
+        p[4] = vx * inv;
+        p[5] = vy * inv;
+        p[6] = vz * inv;
+    }
+    return ngroups;
+}
+
+int fof_catalog(FofState *s, const Body *bodies, int n, int step) {
+    double start = omp_get_wtime();
+
+    /* Сетка строится заново по текущим положениям: ребро ячейки не меньше длины связи */
+    double origin[3];
+    double box = bounding_cube(bodies, n, origin);
+    if (box <= 0.0) box = s->link;
+    if (!cl_build(&s->cl, bodies, origin, box, s->link, 0)) return 0;
+
+    #pragma omp parallel for schedule(static) num_threads(s->nthreads)
+    for (int i = 0; i < n; i++) s->parent[i] = i;
+
+    link_pairs(s, bodies);
+    int ngroups = collect_groups(s, bodies, n);
+
+    char fname[600];
+    snprintf(fname, sizeof(fname), "%s/groups_%06d.csv", s->dir, step);
+    FILE *f = fopen(fname, "w");
+    if (!f) {
+        fprintf(stderr, "Error: Cannot open %s for writing\n", fname);
+        return 0;
+    }
+    fprintf(f, "group,members,mass,x,y,z,vx,vy,vz\n");
+    int largest = 0;
+    for (int g = 0; g < ngroups; g++) {
+        int members = s->member_start[g + 1] - s->member_start[g];
+        const double *p = s->props + (size_t)g * 7;
+        fprintf(f, "%d,%d,%.6e,%.6e,%.6e,%.6e,%.6e,%.6e,%.6e\n",
+                g, members, p[0], p[1], p[2], p[3], p[4], p[5], p[6]);
+        if (members > largest) largest = members;
+    }
+    fclose(f);
+
+    s->catalogs++;
+    s->last_groups = ngroups;
+    s->last_largest = largest;
+    s->time += omp_get_wtime() - start;
+    return 1;
+}
+
+int fof_init(FofState *s, const Body *bodies, int n, double link_param, int min_members,
+             const char *dir, int nthreads) {
+    memset(s, 0, sizeof(*s));
+    s->n = n;
+    s->min_members = min_members;
+    s->nthreads = nthreads;
+    snprintf(s->dir, sizeof(s->dir), "%s", dir);
+
+    /* Среднее межчастичное расстояние - по начальному кубу, содержащему все тела */
+    double origin[3];
+    double box = bounding_cube(bodies, n, origin);
+    s->link = (box > 0.0) ? link_param * box / cbrt((double)n) : link_param;
+
+    int max_groups = n / min_members + 1;
+    s->parent = (int*)malloc((size_t)n * sizeof(int));
+    s->size = (int*)malloc((size_t)n * sizeof(int));
+    s->group_of = (int*)malloc((size_t)n * sizeof(int));
+    s->member_start = (int*)malloc((size_t)(max_groups + 1) * sizeof(int));
+    s->members = (int*)malloc((size_t)n * sizeof(int));
+    s->props = (double*)malloc((size_t)max_groups * 7 * sizeof(double));
+    if (!s->parent || !s->size || !s->group_of || !s->member_start || !s->members || !s->props) {
+        fprintf(stderr, "Error: Failed to allocate group finder buffers (n=%d)\n", n);
+        fof_free(s);
+        return 0;
+    }
+    if (!cl_init(&s->cl, n)) {
+        fof_free(s);
+        return 0;
+    }
+    return 1;
+}
+
+void fof_free(FofState *s) {
+    cl_free(&s->cl);
+    free(s->parent);
+    free(s->size);
+    free(s->group_of);
+    free(s->member_start);
+    free(s->members);
+    free(s->props);
+    memset(s, 0, sizeof(*s));
+}
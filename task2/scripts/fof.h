@@ -0,0 +1,44 @@
+/* fof.h
+ * Поиск групп методом друзей-друзей (friends-of-friends) прямо из памяти:
+ * тела на расстоянии меньше длины связи объединяются в одну группу.
+ * Пары ищутся через список ячеек, группы собираются параллельным
+ * объединением множеств (union-find) без блокировок.
+ */
+
+#ifndef FOF_H
+#define FOF_H
+
+#include "nbody.h"
+#include "cell_list.h"
+
+typedef struct {
+    int n;
+    double link;            /* Длина связи, м */
+    int min_members;        /* Меньшие группы не попадают в каталог */
+    int nthreads;
+    CellList cl;
+    int *parent;            /* Лес объединения множеств: корень - наименьший номер тела группы */
+    int *size;              /* Число тел в группе с корнем r */
+    int *group_of;          /* Номер группы в каталоге для корня (-1 - не в каталоге) */
+    int *member_start;      /* Тела группы g: members[member_start[g] .. member_start[g+1]) */
+    int *members;
+    double *props;          /* По группе: масса, центр масс (3), скорость центра масс (3) */
+    char dir[512];          /* Каталог каталогов групп */
+
+    int catalogs;
+    int last_groups;        /* Групп в последнем каталоге */
+    int last_largest;       /* Тел в крупнейшей группе последнего каталога */
+    double time;            /* Суммарное время поиска и записи, с */
+} FofState;
+
+/* link_param - длина связи в долях среднего межчастичного расстояния
+ * начального куба. Возвращает 0 при ошибке */
+int fof_init(FofState *s, const Body *bodies, int n, double link_param, int min_members,
+             const char *dir, int nthreads);
+
+/* Каталог <dir>/groups_<step>.csv; возвращает 0 при ошибке записи */
+int fof_catalog(FofState *s, const Body *bodies, int n, int step);
+
+void fof_free(FofState *s);
+
+#endif /* FOF_H */
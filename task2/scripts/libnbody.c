@@ -0,0 +1,229 @@
+/* libnbody.c
+ * Встраиваемый интерфейс движка N тел поверх модулей задания 2
+ */
+
+#include "libnbody.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+void nbody_config_default(NbodyConfig *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->integrator = NBODY_EULER;
+    cfg->forces = NBODY_FORCES_DIRECT;
+    cfg->dt = 0.01;
+    cfg->ewald_tol = 1e-5;
+}
+
+static int resolve_threads(const NbodyConfig *cfg) {
+    return cfg->nthreads > 0 ? cfg->nthreads : omp_get_max_threads();
+}
+
+/* Интегратор Эйлера считает силы сам; остальным рабочая память не нужна */
+static int uses_force_buffers(const NbodyConfig *cfg) {
+    return cfg->integrator == NBODY_EULER && cfg->passive_mass <= 0.0;
+}
+
+size_t nbody_workspace_bytes(int n, const NbodyConfig *cfg) {
+    if (!uses_force_buffers(cfg)) return 0;
+    size_t per_force = 3 * (size_t)n * sizeof(double);
+    if (cfg->forces == NBODY_FORCES_DIRECT) {
+        return per_force * (1 + (size_t)resolve_threads(cfg));
+    }
+    return per_force;
+}
+
+/* Те же ограничения, что и у опций task2 */
+static int validate_config(const NbodyConfig *cfg, int n) {
+    if (n <= 0) {
+        fprintf(stderr, "Error: number of bodies must be positive, got %d\n", n);
+        return 0;
+    }
+    if (cfg->dt <= 0.0) {
+        fprintf(stderr, "Error: dt must be positive, got %g\n", cfg->dt);
+        return 0;
+    }
+    if (cfg->passive_mass > 0.0 && cfg->integrator != NBODY_EULER) {
+        fprintf(stderr, "Error: passive particles are supported only with the euler integrator\n");
+        return 0;
+    }
+    if (cfg->forces != NBODY_FORCES_DIRECT && (cfg->integrator != NBODY_EULER || cfg->passive_mass > 0.0)) {
+        fprintf(stderr, "Error: force methods other than direct are supported only with "
+                        "the euler integrator without passive particles\n");
+        return 0;
+    }
+    if (cfg->forces == NBODY_FORCES_PM &&
+        (cfg->pm_grid < 2 || (cfg->pm_grid & (cfg->pm_grid - 1)) != 0)) {
+        fprintf(stderr, "Error: PM grid size must be a power of two, got %d\n", cfg->pm_grid);
+        return 0;
+    }
+    if (cfg->forces == NBODY_FORCES_EWALD && (cfg->ewald_tol <= 0.0 || cfg->ewald_tol >= 1.0)) {
+        fprintf(stderr, "Error: Ewald tolerance must be in (0, 1), got %g\n", cfg->ewald_tol);
+        return 0;
+    }
+    return 1;
+}
+
+int nbody_init(NbodySim *sim, Body *bodies, int n, const NbodyConfig *cfg,
+               void *workspace, size_t workspace_bytes) {
+    memset(sim, 0, sizeof(*sim));
+    if (!validate_config(cfg, n)) return 0;
+    sim->bodies = bodies;
+    sim->n = n;
+    sim->cfg = *cfg;
+    sim->nthreads = resolve_threads(cfg);
+
+    /* Рабочая память сил: fx, fy, fz, затем пер-поточные буферы */
+    size_t need = nbody_workspace_bytes(n, cfg);
+    if (need > 0) {
+        if (workspace) {
+            if (workspace_bytes < need) {
+                fprintf(stderr, "Error: workspace of %zu bytes is smaller than required %zu\n",
+                        workspace_bytes, need);
+                return 0;
+            }
+            sim->workspace = workspace;
+        } else {
+            sim->workspace = malloc(need);
+            if (!sim->workspace) {
+                fprintf(stderr, "Error: Failed to allocate force workspace (n=%d)\n", n);
+                return 0;
+            }
+            sim->owns_workspace = 1;
+        }
+        double *w = (double*)sim->workspace;
+        size_t stride = (size_t)sim->nthreads * n;
+        sim->fx = w;
+        sim->fy = w + n;
+        sim->fz = w + 2 * (size_t)n;
+        if (cfg->forces == NBODY_FORCES_DIRECT) {
+            sim->fx_all = w + 3 * (size_t)n;
+            sim->fy_all = sim->fx_all + stride;
+            sim->fz_all = sim->fy_all + stride;
+        }
+    }
+
+    int ok = 1;
+    if (cfg->integrator == NBODY_WH) {
+        ok = wh_init(&sim->wh, bodies, n, sim->nthreads);
+    } else if (cfg->passive_mass > 0.0) {
+        ok = tp_init(&sim->tp, bodies, n, cfg->passive_mass, sim->nthreads);
+    } else if (cfg->forces == NBODY_FORCES_PM) {
+        ok = pm_init(&sim->pm, bodies, n, cfg->pm_grid, cfg->box, sim->nthreads);
+    } else if (cfg->forces == NBODY_FORCES_EWALD) {
+        ok = ewald_init(&sim->ewald, bodies, n, cfg->box, cfg->ewald_alpha, cfg->ewald_tol,
+                        sim->nthreads);
+    }
+    if (!ok) {
+        if (sim->owns_workspace) free(sim->workspace);
+        memset(sim, 0, sizeof(*sim));
+        return 0;
+    }
+    return 1;
+}
+
+/* Шаг без смены числа потоков вызывающего; возвращает 0 при ошибке */
+static int step_once(NbodySim *sim) {
+    const NbodyConfig *cfg = &sim->cfg;
+    Body *bodies = sim->bodies;
+    int n = sim->n;
+
+    if (cfg->integrator == NBODY_WH) {
+        wh_step(&sim->wh, cfg->dt);
+        sim->bodies_stale = 1;
+    } else if (cfg->passive_mass > 0.0) {
+        tp_step(&sim->tp, cfg->dt);
+        sim->bodies_stale = 1;
+    } else {
+        switch (cfg->forces) {
+            case NBODY_FORCES_PM:
+                pm_forces(&sim->pm, bodies, n, sim->fx, sim->fy, sim->fz);
+                break;
+            case NBODY_FORCES_EWALD:
+                if (!ewald_forces(&sim->ewald, bodies, n, sim->fx, sim->fy, sim->fz)) return 0;
+                break;
+            case NBODY_FORCES_ORDERED:
+                compute_forces_ordered(bodies, n, sim->fx, sim->fy, sim->fz);
+                break;
+            default:
+                compute_forces(bodies, n, sim->fx, sim->fy, sim->fz,
+                               sim->fx_all, sim->fy_all, sim->fz_all, sim->nthreads);
+                break;
+        }
+        update_bodies(bodies, n, sim->fx, sim->fy, sim->fz, cfg->dt);
+    }
+    sim->step++;
+    sim->t = sim->step * cfg->dt;
+    return 1;
+}
+
+/* Число потоков - свойство вызывающего потока OpenMP: задаётся на время шагов и возвращается */
+int nbody_step(NbodySim *sim) {
+    if (!sim->bodies) return 0;
+    int saved = omp_get_max_threads();
+    omp_set_num_threads(sim->nthreads);
+    int ok = step_once(sim);
+    omp_set_num_threads(saved);
+    return ok;
+}
+
+long long nbody_run(NbodySim *sim, long long nsteps, int callback_every,
+                    NbodyStepCallback callback, void *user) {
+    if (!sim->bodies) return -1;
+    if (callback && callback_every <= 0) {
+        fprintf(stderr, "Error: callback interval must be positive, got %d\n", callback_every);
+        return -1;
+    }
+    int saved = omp_get_max_threads();
+    omp_set_num_threads(sim->nthreads);
+
+    long long done = 0;
+    while (done < nsteps) {
+        if (!step_once(sim)) {
+            omp_set_num_threads(saved);
+            return -1;
+        }
+        done++;
+        if (callback && sim->step % callback_every == 0) {
+            /* Обратный вызов - код вызывающего: его число потоков */
+            omp_set_num_threads(saved);
+            int stop = callback(sim, user);
+            omp_set_num_threads(sim->nthreads);
+            if (stop) break;
+        }
+    }
+
+    omp_set_num_threads(saved);
+    return done;
+}
+
+Body *nbody_bodies(NbodySim *sim) {
+    if (sim->bodies_stale) {
+        if (sim->cfg.integrator == NBODY_WH) wh_to_bodies(&sim->wh, sim->bodies);
+        else tp_to_bodies(&sim->tp, sim->bodies);
+        sim->bodies_stale = 0;
+    }
+    return sim->bodies;
+}
+
+double nbody_energy(NbodySim *sim) {
+    return compute_energy(nbody_bodies(sim), sim->n);
+}
+
+void nbody_free(NbodySim *sim) {
+    if (!sim->bodies) return;
+    nbody_bodies(sim);
+    if (sim->cfg.integrator == NBODY_WH) {
+        wh_free(&sim->wh);
+    } else if (sim->cfg.passive_mass > 0.0) {
+        tp_free(&sim->tp);
+    } else if (sim->cfg.forces == NBODY_FORCES_PM) {
+        pm_free(&sim->pm);
+    } else if (sim->cfg.forces == NBODY_FORCES_EWALD) {
+        ewald_free(&sim->ewald);
+    }
+    if (sim->owns_workspace) free(sim->workspace);
+    memset(sim, 0, sizeof(*sim));
+}
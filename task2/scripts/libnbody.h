@@ -0,0 +1,103 @@
+/* libnbody.h
+ * Встраиваемый интерфейс движка N тел: симуляция без запуска процесса и без
+ * файлового ввода-вывода. Глобального состояния нет - всё состояние лежит
+ * в NbodySim, который выделяет вызывающий; несколько симуляций могут
+ * выполняться одновременно из разных потоков.
+ *
+ * Тела - буфер вызывающего, библиотека работает с ним напрямую (без копий):
+ * в режиме Эйлера он обновляется на каждом шаге, у интеграторов с
+ * собственными координатами (Уиздом-Холман, пробные частицы) -
+ * при вызове nbody_bodies().
+ *
+ * Сборка: gcc -fopenmp -O3 -fPIC -shared -o task2/scripts/libnbody.so <модули task2> -lm
+ */
+
+#ifndef LIBNBODY_H
+#define LIBNBODY_H
+
+#include <stddef.h>
+
+#include "nbody.h"
+#include "wisdom_holman.h"
+#include "test_particles.h"
+#include "particle_mesh.h"
+#include "ewald.h"
+
+typedef enum {
+    NBODY_EULER = 0,        /* Метод Эйлера 1-го порядка */
+    NBODY_WH = 1            /* Уиздом-Холман (центральное тело - первое) */
+} NbodyIntegrator;
+
+typedef enum {
+    NBODY_FORCES_DIRECT = 0,    /* compute_forces: пары с третьим законом Ньютона */
+    NBODY_FORCES_ORDERED = 1,   /* compute_forces_ordered: не зависит от числа потоков */
+    NBODY_FORCES_PM = 2,        /* Частица-сетка в периодическом кубе */
+    NBODY_FORCES_EWALD = 3      /* Суммирование Эвальда в периодическом кубе */
+} NbodyForces;
+
+typedef struct {
+    NbodyIntegrator integrator;
+    NbodyForces forces;     /* Только для метода Эйлера */
+    double dt;              /* Шаг по времени, с */
+    int nthreads;           /* Потоков OpenMP (0 - omp_get_max_threads()) */
+    double passive_mass;    /* Порог массы пробных частиц (0 - все тела активные) */
+    int pm_grid;            /* Узлов сетки PM по оси */
+    double box;             /* Ребро периодического куба (0 - по начальным положениям) */
+    double ewald_alpha;     /* alpha * box (0 - выбор по N) */
+    double ewald_tol;       /* Допуск частей Эвальда */
+} NbodyConfig;
+
+typedef struct NbodySim NbodySim;
+
+/* Вызывается каждые callback_every шагов nbody_run; ненулевой результат останавливает прогон */
+typedef int (*NbodyStepCallback)(NbodySim *sim, void *user);
+
+struct NbodySim {
+    Body *bodies;           /* Буфер вызывающего */
+    int n;
+    NbodyConfig cfg;
+    int nthreads;
+    long long step;
+    double t;
+
+    double *fx, *fy, *fz;   /* Силы (метод Эйлера) */
+    double *fx_all, *fy_all, *fz_all;   /* Пер-поточные буферы compute_forces */
+    void *workspace;        /* Рабочая память сил */
+    int owns_workspace;     /* Выделена библиотекой (иначе - вызывающим) */
+
+    WHState wh;
+    TestParticleState tp;
+    PMState pm;
+    EwaldState ewald;
+    int bodies_stale;       /* Буфер тел отстаёт от внутренних координат интегратора */
+};
+
+/* Параметры по умолчанию: Эйлер, прямой расчёт, dt = 0.01 */
+void nbody_config_default(NbodyConfig *cfg);
+
+/* Байт рабочей памяти сил для n тел (0 - не нужна) */
+size_t nbody_workspace_bytes(int n, const NbodyConfig *cfg);
+
+/* Начало симуляции над буфером bodies. workspace - память вызывающего не меньше
+ * nbody_workspace_bytes(), либо NULL (выделит библиотека). Возвращает 0 при ошибке */
+int nbody_init(NbodySim *sim, Body *bodies, int n, const NbodyConfig *cfg,
+               void *workspace, size_t workspace_bytes);
+
+/* Один шаг; возвращает 0 при ошибке */
+int nbody_step(NbodySim *sim);
+
+/* nsteps шагов с вызовом callback (может быть NULL) каждые callback_every шагов.
+ * Возвращает число выполненных шагов или -1 при ошибке */
+long long nbody_run(NbodySim *sim, long long nsteps, int callback_every,
+                    NbodyStepCallback callback, void *user);
+
+/* Буфер тел вызывающего с актуальными положениями и скоростями */
+Body *nbody_bodies(NbodySim *sim);
+
+/* Полная энергия текущего состояния */
+double nbody_energy(NbodySim *sim);
+
+/* Освобождение; буфер тел остаётся с конечным состоянием */
+void nbody_free(NbodySim *sim);
+
+#endif /* LIBNBODY_H */
@@ -0,0 +1,231 @@
+/* nbody.c
+ * Вычислительные ядра задачи N тел (OpenMP)
+ */
+
+#include "nbody.h"
+#include "../../common/trace.h"
+
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <omp.h>
+
+#define FORCE_BLOCK 256     /* Тел в блоке строки при детерминированном суммировании */
+
+/* --- Фазы compute_forces ---
+ * Обе функции содержат только "omp for" и вызываются внутри параллельной области:
+ * так compute_forces делает их одной областью, а микробенчмарки замеряют по отдельности */
+
+/* Вклады пар (i,j) в локальный буфер потока — третий закон Ньютона соблюдается.
+ * Барьера в конце нет (nowait): перед чтением чужих буферов вызывающий ставит свой */
+void compute_forces_pairs(const Body *bodies, int n, double *fx_loc, double *fy_loc, double *fz_loc) {
+    #pragma omp for schedule(static) nowait
+    for (int i = 0; i < n - 1; i++) {
+        double xi = bodies[i].x;
+        double yi = bodies[i].y;
+        double zi = bodies[i].z;
+        double mi = bodies[i].mass;
+
+        for (int j = i + 1; j < n; j++) {
+            double dx = bodies[j].x - xi;
+            double dy = bodies[j].y - yi;
+            double dz = bodies[j].z - zi;
+
+            double r_sq = dx*dx + dy*dy + dz*dz + SOFTENING;
+            double inv_r = 1.0 / sqrt(r_sq);
+            double inv_r3 = inv_r * inv_r * inv_r;
+
+            double force_factor = G * mi * bodies[j].mass * inv_r3;
+
+            double Fx = force_factor * dx;
+            double Fy = force_factor * dy;
+            double Fz = force_factor * dz;
+
+            fx_loc[i] += Fx;
+            fy_loc[i] += Fy;
+            fz_loc[i] += Fz;
+
+            fx_loc[j] -= Fx;
+            fy_loc[j] -= Fy;
+            fz_loc[j] -= Fz;
+        }
+    }
+}
+
+/* Сумма nt пер-поточных буферов в fx, fy, fz */
+void compute_forces_reduce(int n, int nt, double *fx, double *fy, double *fz,
+                           const double *fx_all, const double *fy_all, const double *fz_all) {
+    size_t per_thread = (size_t)n;
+
+    #pragma omp for schedule(static)
+    for (int i = 0; i < n; i++) {
+        double sfx = 0.0, sfy = 0.0, sfz = 0.0;
+        size_t base = (size_t)i;
+        for (int t = 0; t < nt; t++) {
+            size_t idx = (size_t)t * per_thread + base;
+            sfx += fx_all[idx];
+            sfy += fy_all[idx];
+            sfz += fz_all[idx];
+        }
+        fx[i] = sfx;
+        fy[i] = sfy;
+        fz[i] = sfz;
+    }
+}
+
+/* --- Вычисление сил между всеми телами --- */
+/* Использует третий закон Ньютона: Fpq = -Fqp для оптимизации */
+void compute_forces(Body *bodies, int n, double *fx, double *fy, double *fz,
+                    double *fx_all, double *fy_all, double *fz_all, int nthreads) {
+
+    /* Обнуляем глобальные силы (глобальный буфер результата) */
+    for (int i = 0; i < n; i++) {
+        fx[i] = 0.0;
+        fy[i] = 0.0;
+        fz[i] = 0.0;
+    }
+
+    size_t per_thread = (size_t)n;
+
+    /* Однократная параллельная область: вычисление + редукция внутри.
+     * Потоков не больше nthreads - под столько рассчитаны буферы fx_all */
+    #pragma omp parallel num_threads(nthreads)
+    {
+        int tid = omp_get_thread_num();
+        int nt = omp_get_num_threads();
+        double *fx_loc = fx_all + (size_t)tid * per_thread;
+        double *fy_loc = fy_all + (size_t)tid * per_thread;
+        double *fz_loc = fz_all + (size_t)tid * per_thread;
+
+        /* Сбрасываем локальную область */
+        TRACE_BEGIN("forces_clear");
+        memset(fx_loc, 0, per_thread * sizeof(double));
+        memset(fy_loc, 0, per_thread * sizeof(double));
+        memset(fz_loc, 0, per_thread * sizeof(double));
+        TRACE_END("forces_clear");
+
+        TRACE_BEGIN("forces_pairs");
+        compute_forces_pairs(bodies, n, fx_loc, fy_loc, fz_loc);
+        TRACE_END("forces_pairs");
+
+        /* Барьер — все потоки закончили записывать в свои локальные буферы */
+        TRACE_BEGIN("forces_barrier");
+        #pragma omp barrier
+        TRACE_END("forces_barrier");
+
+        /* Включает ожидание на неявном барьере omp for */
+        TRACE_BEGIN("forces_reduce");
+        compute_forces_reduce(n, nt, fx, fy, fz, fx_all, fy_all, fz_all);
+        TRACE_END("forces_reduce");
+    } 
+}
+
+
+/* --- Детерминированный расчёт сил ---
+ * Без третьего закона Ньютона: каждая пара считается дважды, зато вклады в fx[i]
+ * складывает один поток в одном и том же порядке при любом числе потоков.
+ * Строка суммируется блоками по FORCE_BLOCK тел: порядок внутри блока задаётся
+ * векторизацией при компиляции, суммы блоков складываются последовательно. */
+void compute_forces_ordered(const Body *bodies, int n, double *fx, double *fy, double *fz) {
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        double xi = bodies[i].x;
+        double yi = bodies[i].y;
+        double zi = bodies[i].z;
+        double gmi = G * bodies[i].mass;
+        double sfx = 0.0, sfy = 0.0, sfz = 0.0;
+
+        for (int jb = 0; jb < n; jb += FORCE_BLOCK) {
+            int jend = (jb + FORCE_BLOCK < n) ? jb + FORCE_BLOCK : n;
+            double bfx = 0.0, bfy = 0.0, bfz = 0.0;
+
+            /* При j == i dx = dy = dz = 0 и вклад равен нулю - ветвление не нужно */
+            #pragma omp simd reduction(+:bfx, bfy, bfz)
+            for (int j = jb; j < jend; j++) {
+                double dx = bodies[j].x - xi;
+                double dy = bodies[j].y - yi;
+                double dz = bodies[j].z - zi;
+
+                double r_sq = dx*dx + dy*dy + dz*dz + SOFTENING;
+                double inv_r = 1.0 / sqrt(r_sq);
+                double force_factor = gmi * bodies[j].mass * inv_r * inv_r * inv_r;
+
+                bfx += force_factor * dx;
+                bfy += force_factor * dy;
+                bfz += force_factor * dz;
+            }
+            sfx += bfx;
+            sfy += bfy;
+            sfz += bfz;
+        }
+
+        fx[i] = sfx;
+        fy[i] = sfy;
+        fz[i] = sfz;
+    }
+}
+
+
+/* --- Обновление позиций и скоростей методом Эйлера --- */
+void update_bodies(Body *bodies, int n, double *fx, double *fy, double *fz, double dt) {
+    #pragma omp parallel
+    {
+        TRACE_BEGIN("update_bodies");
+        #pragma omp for schedule(static) nowait
+        for (int i = 0; i < n; i++) {
+            /* Обновляем позиции: x^n = x^(n-1) + v^(n-1) * dt */
+            bodies[i].x += bodies[i].vx * dt;
+            bodies[i].y += bodies[i].vy * dt;
+            bodies[i].z += bodies[i].vz * dt;
+
+            /* Обновляем скорости: v^n = v^(n-1) + F^(n-1)/m * dt */
+            bodies[i].vx += (fx[i] / bodies[i].mass) * dt;
+            bodies[i].vy += (fy[i] / bodies[i].mass) * dt;
+            bodies[i].vz += (fz[i] / bodies[i].mass) * dt;
+        }
+        TRACE_END("update_bodies");
+    }
+}
+
+/* --- Полная энергия системы --- */
+/* Используется для контроля точности интеграторов: E = sum(m v^2 / 2) - sum(G m_i m_j / r_ij) */
+double compute_energy(const Body *bodies, int n) {
+    double kinetic = 0.0, potential = 0.0;
+
+    #pragma omp parallel for schedule(dynamic, 16) reduction(+:kinetic, potential)
+    for (int i = 0; i < n; i++) {
+        double v_sq = bodies[i].vx * bodies[i].vx + bodies[i].vy * bodies[i].vy
+                    + bodies[i].vz * bodies[i].vz;
+        kinetic += 0.5 * bodies[i].mass * v_sq;
+
+        for (int j = i + 1; j < n; j++) {
+            double dx = bodies[j].x - bodies[i].x;
+            double dy = bodies[j].y - bodies[i].y;
+            double dz = bodies[j].z - bodies[i].z;
+            double r = sqrt(dx*dx + dy*dy + dz*dz + SOFTENING);
+            potential -= G * bodies[i].mass * bodies[j].mass / r;
+        }
+    }
+
+    return kinetic + potential;
+}
+
+/* --- Описанный куб --- */
+/* Угол и ребро наименьшего куба с тем же углом, что у ограничивающего параллелепипеда */
+double bounding_cube(const Body *bodies, int n, double origin[3]) {
+    double lo[3] = {DBL_MAX, DBL_MAX, DBL_MAX}, hi[3] = {-DBL_MAX, -DBL_MAX, -DBL_MAX};
+    for (int i = 0; i < n; i++) {
+        double p[3] = {bodies[i].x, bodies[i].y, bodies[i].z};
+        for (int d = 0; d < 3; d++) {
+            if (p[d] < lo[d]) lo[d] = p[d];
+            if (p[d] > hi[d]) hi[d] = p[d];
+        }
+    }
+
+    double extent = 0.0;
+    for (int d = 0; d < 3; d++) {
+        origin[d] = lo[d];
+        if (hi[d] - lo[d] > extent) extent = hi[d] - lo[d];
+    }
+    return extent;
+}
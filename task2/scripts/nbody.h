@@ -0,0 +1,64 @@
+/* nbody.h
+ * Общие определения задачи N тел: состояние частиц, физические константы
+ * и вычислительные ядра, используемые интеграторами задания 2.
+ */
+
+#ifndef NBODY_H
+#define NBODY_H
+
+/* Физические константы */
+#define G 6.67430e-11  /* Гравитационная постоянная (м^3 кг^-1 с^-2) */
+
+/* Мелкая константа для предотвращения деления на ноль при близких вкладах */
+#define SOFTENING 1e-9
+
+/* Операций double в ядрах (sqrt и деление - по одной операции):
+ * пара в compute_forces_pairs - разность 3, r^2 6, 1/sqrt 2, r^-3 2, множитель 3, сила 3, вклады в i и j 6;
+ * упорядоченная пара в compute_forces_ordered - без вклада в j и с другим порядком множителей;
+ * тело в update_bodies - позиция 6, скорость 9 */
+#define PAIR_FLOPS 25
+#define ORDERED_PAIR_FLOPS 21
+#define UPDATE_FLOPS 15
+
+/* Байтов обмена с уровнем памяти, где лежит рабочий набор, за шаг (для roofline).
+ * Загрузки и записи внутри цикла пар попадают в L1 и не считаются: на тело
+ * приходится O(1) байтов за шаг, а не O(N). Каждый поток проходит x, y, z, mass
+ * всех тел - 32; буфер сил потока обнуляется, пополняется и читается при
+ * редукции - 72; итоговые силы записываются - 24; тело в update_bodies -
+ * чтение тела 56 и сил 24, запись позиции и скорости 48 */
+#define BODY_STREAM_BYTES 32
+#define FORCE_BUFFER_BYTES 72
+#define FORCE_BYTES 24
+#define UPDATE_BYTES 128
+
+/* --- Структура для хранения состояния частицы --- */
+typedef struct {
+    double x, y, z;     /* Позиция */
+    double vx, vy, vz;  /* Скорость */
+    double mass;        /* Масса */
+} Body;
+
+/* Вычисление сил между всеми телами (fx_all.. - пер-поточные буферы nthreads * n) */
+void compute_forces(Body *bodies, int n, double *fx, double *fy, double *fz,
+                    double *fx_all, double *fy_all, double *fz_all, int nthreads);
+
+/* Фазы compute_forces (только "omp for", вызываются внутри параллельной области):
+ * вклады пар в локальные буферы потока и сумма nt пер-поточных буферов */
+void compute_forces_pairs(const Body *bodies, int n, double *fx_loc, double *fy_loc, double *fz_loc);
+void compute_forces_reduce(int n, int nt, double *fx, double *fy, double *fz,
+                           const double *fx_all, const double *fy_all, const double *fz_all);
+
+/* Детерминированный расчёт сил: каждая строка i суммируется одним потоком в фиксированном
+ * порядке блоков по j, поэтому результат не зависит от числа потоков */
+void compute_forces_ordered(const Body *bodies, int n, double *fx, double *fy, double *fz);
+
+/* Обновление позиций и скоростей методом Эйлера */
+void update_bodies(Body *bodies, int n, double *fx, double *fy, double *fz, double dt);
+
+/* Полная энергия системы (кинетическая + потенциальная) */
+double compute_energy(const Body *bodies, int n);
+
+/* Куб, содержащий все тела: угол в origin, возвращает длину ребра */
+double bounding_cube(const Body *bodies, int n, double origin[3]);
+
+#endif /* NBODY_H */
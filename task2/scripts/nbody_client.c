@@ -0,0 +1,164 @@
+/* nbody_client.c
+ * Локальный клиент сервиса симуляций (nbody_service): отправляет задание
+ * из входного файла task2 и печатает ответы сервиса по мере поступления.
+ *
+ * Компиляция: gcc -O3 -o task2/scripts/nbody_client task2/scripts/nbody_client.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s <socket_path> submit <nthreads> <tend> <input_file> [options]\n", prog);
+    fprintf(stderr, "       %s <socket_path> stats | shutdown\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --integrator <name>  euler | wh (default: euler)\n");
+    fprintf(stderr, "  --dt <seconds>       time step (default: 0.01)\n");
+    fprintf(stderr, "  --progress <K>       progress line every K steps (default: off)\n");
+    fprintf(stderr, "  --output <file>      write the final state in the input format\n");
+}
+
+int connect_service(const char *path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "Error: Cannot connect to %s: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Задание: заголовок и тела из входного файла (формат task2) */
+int send_job(FILE *out, const char *input_file, int nthreads, double tend, double dt,
+             const char *integrator, int progress, int want_output) {
+    FILE *f = fopen(input_file, "r");
+    if (!f) {
+        fprintf(stderr, "Error: Cannot open input file %s: %s\n", input_file, strerror(errno));
+        return 0;
+    }
+    int n;
+    if (fscanf(f, "%d", &n) != 1 || n <= 0) {
+        fprintf(stderr, "Error: Invalid number of bodies in input file\n");
+        fclose(f);
+        return 0;
+    }
+    fprintf(out, "JOB n=%d tend=%.17g dt=%.17g integrator=%s threads=%d progress=%d output=%s\n",
+            n, tend, dt, integrator, nthreads, progress, want_output ? "final" : "none");
+    for (int i = 0; i < n; i++) {
+        double v[7];
+        if (fscanf(f, "%lf %lf %lf %lf %lf %lf %lf", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6]) != 7) {
+            fprintf(stderr, "Error: Invalid data for body %d\n", i);
+            fclose(f);
+            return 0;
+        }
+        fprintf(out, "%.17g %.17g %.17g %.17g %.17g %.17g %.17g\n", v[0], v[1], v[2], v[3], v[4], v[5], v[6]);
+    }
+    fclose(f);
+    fflush(out);
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const char *path = argv[1];
+    const char *command = argv[2];
+
+    int is_submit = (strcmp(command, "submit") == 0);
+    if (!is_submit && strcmp(command, "stats") != 0 && strcmp(command, "shutdown") != 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (is_submit && argc < 6) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const char *integrator = "euler";
+    const char *output_file = NULL;
+    double dt = 0.01;
+    int progress = 0;
+    for (int a = 6; is_submit && a < argc; a++) {
+        if (strcmp(argv[a], "--integrator") == 0 && a + 1 < argc) {
+            integrator = argv[++a];
+        } else if (strcmp(argv[a], "--dt") == 0 && a + 1 < argc) {
+            dt = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--progress") == 0 && a + 1 < argc) {
+            progress = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--output") == 0 && a + 1 < argc) {
+            output_file = argv[++a];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    int fd = connect_service(path);
+    if (fd < 0) return 1;
+    FILE *out = fdopen(dup(fd), "w");
+    FILE *in = fdopen(fd, "r");
+    if (!out || !in) {
+        fprintf(stderr, "Error: Cannot open socket streams\n");
+        return 1;
+    }
+
+    int ok;
+    if (is_submit) {
+        ok = send_job(out, argv[5], atoi(argv[3]), atof(argv[4]), dt, integrator, progress,
+                      output_file != NULL);
+    } else {
+        ok = (fprintf(out, "%s\n", strcmp(command, "stats") == 0 ? "STATS" : "SHUTDOWN") > 0);
+        fflush(out);
+    }
+    fclose(out);
+    if (!ok) {
+        fclose(in);
+        return 1;
+    }
+
+    /* Ответы до END; строки BODY - в файл конечного состояния */
+    FILE *state = NULL;
+    int nstate = 0, failed = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), in)) {
+        if (strncmp(line, "END", 3) == 0) break;
+        if (strncmp(line, "BODY ", 5) == 0) {
+            if (!state) {
+                state = fopen(output_file, "w");
+                if (!state) {
+                    fprintf(stderr, "Error: Cannot open %s for writing: %s\n", output_file, strerror(errno));
+                    failed = 1;
+                    break;
+                }
+                /* Число тел - в начало файла, когда станет известно */
+                fprintf(state, "%-12d\n", 0);
+            }
+            fputs(line + 5, state);
+            nstate++;
+            continue;
+        }
+        if (strncmp(line, "ERROR", 5) == 0) failed = 1;
+        fputs(line, stdout);
+        fflush(stdout);
+    }
+    fclose(in);
+
+    if (state) {
+        rewind(state);
+        fprintf(state, "%-12d", nstate);
+        fclose(state);
+        printf("Final state written to %s\n", output_file);
+    }
+    return failed ? 1 : 0;
+}
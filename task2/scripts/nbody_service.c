@@ -0,0 +1,530 @@
+/* nbody_service.c
+ * Долгоживущий сервис симуляций N тел на локальном Unix-сокете.
+ * Задания (начальные условия, tend, интегратор, число потоков) ставятся
+ * в очередь и выполняются пулом рабочих потоков через libnbody: у каждого
+ * задания свой бюджет потоков OpenMP, сумма бюджетов запущенных заданий
+ * не превышает бюджета сервиса. Ход выполнения передаётся клиенту по тому
+ * же соединению.
+ *
+ * Протокол (текстовые строки):
+ *   JOB n=<N> tend=<t> dt=<dt> integrator=euler|wh threads=<k> progress=<K> output=none|final
+ *   <N строк: x y z vx vy vz mass>
+ *     -> QUEUED id=.. position=..
+ *        STARTED id=.. wait=..
+ *        PROGRESS id=.. step=.. t=.. steps_per_sec=..   (каждые K шагов)
+ *        DONE id=.. steps=.. wait=.. run=.. steps_per_sec=.. interactions_per_sec=.. energy_error=..
+ *                                  (interactions_per_sec пусто, кроме прямого расчёта методом Эйлера)
+ *        BODY x y z vx vy vz mass                     (N строк при output=final)
+ *        END
+ *   STATS    -> STATS queued=.. running=.. ... ; END
+ *   SHUTDOWN -> OK ; END (запущенные задания доделываются, ожидающие отменяются)
+ *
+ * Компиляция:
+ *   gcc -fopenmp -O3 -pthread -o task2/scripts/nbody_service task2/scripts/nbody_service.c \
+ *       task2/scripts/libnbody.c task2/scripts/nbody.c task2/scripts/wisdom_holman.c \
+ *       task2/scripts/test_particles.c task2/scripts/particle_mesh.c task2/scripts/cell_list.c \
+ *       task2/scripts/ewald.c common/trace.c -lm
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <omp.h>
+
+#include "libnbody.h"
+
+#define SERVICE_LINE 512
+#define SERVICE_BACKLOG 64
+
+typedef struct Job {
+    int id;
+    int client;             /* Соединение клиента: закрывает рабочий поток */
+    Body *bodies;
+    int n;
+    double tend, dt;
+    NbodyIntegrator integrator;
+    int nthreads;
+    int progress_every;
+    int output_final;
+    double submitted;       /* omp_get_wtime() постановки в очередь */
+    double started;
+    struct Job *next;
+} Job;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    Job *head, *tail;       /* Очередь FIFO */
+    int queued;
+    int running;
+    int budget;             /* Бюджет потоков OpenMP сервиса */
+    int free_threads;
+    int shutdown;
+    int next_id;
+    int listen_fd;
+
+    /* Накопленная статистика завершённых заданий */
+    int completed, failed;
+    int pairwise_completed; /* Завершённые задания с прямым расчётом пар */
+    double total_wait, total_run;
+    double total_steps_per_sec, total_interactions_per_sec;
+} Service;
+
+/* Строка клиенту; ошибка записи означает, что клиент отключился */
+static int send_line(int fd, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static int send_line(int fd, const char *fmt, ...) {
+    char buf[SERVICE_LINE];
+    va_list ap;
+    va_start(ap, fmt);
+    int len = vsnprintf(buf, sizeof(buf) - 1, fmt, ap);
+    va_end(ap);
+    if (len < 0) return 0;
+    if (len > (int)sizeof(buf) - 2) len = (int)sizeof(buf) - 2;
+    buf[len++] = '\n';
+    for (int off = 0; off < len;) {
+        ssize_t w = write(fd, buf + off, (size_t)(len - off));
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        off += (int)w;
+    }
+    return 1;
+}
+
+/* --- Разбор задания --- */
+/* Значение ключа key=value из строки заголовка; NULL - ключа нет */
+static const char *header_value(const char *header, const char *key, char *out, size_t size) {
+    size_t klen = strlen(key);
+    for (const char *p = header; (p = strstr(p, key)) != NULL; p += klen) {
+        if ((p == header || p[-1] == ' ') && p[klen] == '=') {
+            const char *v = p + klen + 1;
+            size_t len = strcspn(v, " \r\n");
+            if (len >= size) len = size - 1;
+            memcpy(out, v, len);
+            out[len] = '\0';
+            return out;
+        }
+    }
+    return NULL;
+}
+
+/* Заголовок JOB и N строк тел; возвращает NULL и сообщение об ошибке */
+static Job *read_job(FILE *in, const char *header, const char **error) {
+    char value[64];
+    Job *job = (Job*)calloc(1, sizeof(Job));
+    if (!job) {
+        *error = "out of memory";
+        return NULL;
+    }
+    job->dt = 0.01;
+    job->integrator = NBODY_EULER;
+    job->nthreads = 1;
+
+    job->n = header_value(header, "n", value, sizeof(value)) ? atoi(value) : 0;
+    job->tend = header_value(header, "tend", value, sizeof(value)) ? atof(value) : 0.0;
+    if (header_value(header, "dt", value, sizeof(value))) job->dt = atof(value);
+    if (header_value(header, "threads", value, sizeof(value))) job->nthreads = atoi(value);
+    if (header_value(header, "progress", value, sizeof(value))) job->progress_every = atoi(value);
+    if (header_value(header, "output", value, sizeof(value))) {
+        job->output_final = (strcmp(value, "final") == 0);
+    }
+    if (header_value(header, "integrator", value, sizeof(value))) {
+        if (strcmp(value, "wh") == 0) {
+            job->integrator = NBODY_WH;
+        } else if (strcmp(value, "euler") != 0) {
+            *error = "unknown integrator";
+            free(job);
+            return NULL;
+        }
+    }
+    if (job->n <= 0 || job->tend <= 0.0 || job->dt <= 0.0 || job->nthreads <= 0 || job->progress_every < 0) {
+        *error = "n, tend, dt and threads must be positive";
+        free(job);
+        return NULL;
+    }
+
+    job->bodies = (Body*)malloc((size_t)job->n * sizeof(Body));
+    if (!job->bodies) {
+        *error = "out of memory for bodies";
+        free(job);
+        return NULL;
+    }
+    char line[SERVICE_LINE];
+    for (int i = 0; i < job->n; i++) {
+        Body *b = &job->bodies[i];
+        if (!fgets(line, sizeof(line), in) ||
+            sscanf(line, "%lf %lf %lf %lf %lf %lf %lf",
+                   &b->x, &b->y, &b->z, &b->vx, &b->vy, &b->vz, &b->mass) != 7) {
+            *error = "invalid body data";
+            free(job->bodies);
+            free(job);
+            return NULL;
+        }
+    }
+    return job;
+}
+
+/* --- Очередь и пул --- */
+/* Возвращает 0, если сервис уже завершается (job->id = 0 - номер не выдан).
+ * Ответы клиентам пишутся без блокировки сервиса: клиент, переставший читать,
+ * иначе остановил бы рабочие потоки и приём соединений. Место в очереди
+ * резервируется (queued) вместе с номером, а задание встаёт в очередь после
+ * QUEUED, чтобы рабочий поток не ответил STARTED раньше него */
+static int enqueue(Service *svc, Job *job) {
+    pthread_mutex_lock(&svc->lock);
+    if (svc->shutdown) {
+        pthread_mutex_unlock(&svc->lock);
+        return 0;
+    }
+    job->id = ++svc->next_id;
+    job->submitted = omp_get_wtime();
+    /* Бюджет задания не больше бюджета сервиса - иначе оно не запустится никогда */
+    if (job->nthreads > svc->budget) job->nthreads = svc->budget;
+    int position = ++svc->queued;
+    pthread_mutex_unlock(&svc->lock);
+
+    send_line(job->client, "QUEUED id=%d position=%d threads=%d", job->id, position, job->nthreads);
+
+    pthread_mutex_lock(&svc->lock);
+    if (svc->shutdown) {
+        svc->queued--;
+        pthread_mutex_unlock(&svc->lock);
+        return 0;
+    }
+    if (svc->tail) svc->tail->next = job;
+    else svc->head = job;
+    svc->tail = job;
+    pthread_cond_broadcast(&svc->changed);
+    pthread_mutex_unlock(&svc->lock);
+    return 1;
+}
+
+typedef struct {
+    Job *job;
+    NbodySim *sim;
+    double start;
+    int disconnected;
+} Progress;
+
+static int report_progress(NbodySim *sim, void *user) {
+    Progress *p = (Progress*)user;
+    double elapsed = omp_get_wtime() - p->start;
+    if (!send_line(p->job->client, "PROGRESS id=%d step=%lld t=%.6f steps_per_sec=%.2f",
+                   p->job->id, sim->step, sim->t, elapsed > 0.0 ? sim->step / elapsed : 0.0)) {
+        p->disconnected = 1;
+        return 1;
+    }
+    return 0;
+}
+
+/* Выполнение задания в рабочем потоке: команда потоков OpenMP этого
+ * рабочего потока переиспользуется от задания к заданию */
+static void run_job(Service *svc, Job *job) {
+    double wait = job->started - job->submitted;
+    send_line(job->client, "STARTED id=%d wait=%.6f", job->id, wait);
+
+    NbodyConfig cfg;
+    nbody_config_default(&cfg);
+    cfg.integrator = job->integrator;
+    cfg.dt = job->dt;
+    cfg.nthreads = job->nthreads;
+
+    NbodySim sim;
+    int ok = nbody_init(&sim, job->bodies, job->n, &cfg, NULL, 0);
+    long long steps = 0;
+    double run = 0.0, energy_error = 0.0;
+    Progress progress = {job, &sim, 0.0, 0};
+    if (ok) {
+        double energy_start = nbody_energy(&sim);
+        progress.start = omp_get_wtime();
+        steps = nbody_run(&sim, (long long)(job->tend / job->dt), job->progress_every,
+                          job->progress_every > 0 ? report_progress : NULL, &progress);
+        run = omp_get_wtime() - progress.start;
+        double energy_end = nbody_energy(&sim);
+        energy_error = (energy_start != 0.0) ? fabs((energy_end - energy_start) / energy_start) : 0.0;
+        nbody_free(&sim);
+        ok = (steps >= 0 && !progress.disconnected);
+    }
+
+    double steps_per_sec = (run > 0.0) ? steps / run : 0.0;
+    /* Пары n(n-1)/2 за шаг считает только прямой расчёт сил методом Эйлера;
+     * у Уиздома-Холмана и пробных частиц число взаимодействий другое */
+    int pairwise = (cfg.integrator == NBODY_EULER && cfg.forces == NBODY_FORCES_DIRECT
+                    && cfg.passive_mass <= 0.0);
+    double interactions_per_sec = pairwise ? steps_per_sec * 0.5 * job->n * (job->n - 1.0) : 0.0;
+
+    /* Потоки освобождаются и статистика обновляется до ответа: клиент, получивший END,
+     * видит задание завершённым, а следующее задание не ждёт передачи тел */
+    pthread_mutex_lock(&svc->lock);
+    if (ok) {
+        svc->completed++;
+        svc->total_wait += wait;
+        svc->total_run += run;
+        svc->total_steps_per_sec += steps_per_sec;
+        if (pairwise) {
+            svc->pairwise_completed++;
+            svc->total_interactions_per_sec += interactions_per_sec;
+        }
+    } else {
+        svc->failed++;
+    }
+    svc->running--;
+    svc->free_threads += job->nthreads;
+    pthread_cond_broadcast(&svc->changed);
+    pthread_mutex_unlock(&svc->lock);
+
+    if (ok) {
+        char interactions[32] = "";
+        if (pairwise) snprintf(interactions, sizeof(interactions), "%.4e", interactions_per_sec);
+        send_line(job->client, "DONE id=%d steps=%lld wait=%.6f run=%.6f steps_per_sec=%.2f "
+                  "interactions_per_sec=%s energy_error=%.6e",
+                  job->id, steps, wait, run, steps_per_sec, interactions, energy_error);
+        if (job->output_final) {
+            for (int i = 0; i < job->n; i++) {
+                const Body *b = &job->bodies[i];
+                send_line(job->client, "BODY %.17g %.17g %.17g %.17g %.17g %.17g %.17g",
+                          b->x, b->y, b->z, b->vx, b->vy, b->vz, b->mass);
+            }
+        }
+    } else {
+        send_line(job->client, "ERROR id=%d %s", job->id,
+                  progress.disconnected ? "client disconnected" : "simulation setup failed");
+    }
+    send_line(job->client, "END");
+
+    printf("Job %d: n=%d threads=%d steps=%lld wait=%.3f s run=%.3f s %s\n",
+           job->id, job->n, job->nthreads, steps, wait, run, ok ? "done" : "failed");
+    fflush(stdout);
+}
+
+/* Рабочий поток: берёт голову очереди, когда свободных потоков хватает на её бюджет.
+ * Очередь строго FIFO - большое задание не обгоняется мелкими и не голодает */
+static void *worker_main(void *arg) {
+    Service *svc = (Service*)arg;
+    for (;;) {
+        pthread_mutex_lock(&svc->lock);
+        while (!svc->shutdown && !(svc->head && svc->head->nthreads <= svc->free_threads)) {
+            pthread_cond_wait(&svc->changed, &svc->lock);
+        }
+        if (svc->shutdown) {
+            pthread_mutex_unlock(&svc->lock);
+            return NULL;
+        }
+        Job *job = svc->head;
+        svc->head = job->next;
+        if (!svc->head) svc->tail = NULL;
+        svc->queued--;
+        svc->running++;
+        svc->free_threads -= job->nthreads;
+        job->started = omp_get_wtime();
+        pthread_mutex_unlock(&svc->lock);
+
+        run_job(svc, job);
+        close(job->client);
+        free(job->bodies);
+        free(job);
+    }
+}
+
+/* --- Соединения --- */
+typedef struct {
+    Service *svc;
+    int fd;
+} Connection;
+
+/* Строка статистики формируется под блокировкой, отправляется после неё */
+static void send_stats(Service *svc, int fd) {
+    char line[SERVICE_LINE];
+    pthread_mutex_lock(&svc->lock);
+    int done = svc->completed;
+    double k = done > 0 ? 1.0 / done : 0.0;
+    /* Среднее взаимодействий - по заданиям с прямым расчётом пар */
+    char interactions[32] = "";
+    if (svc->pairwise_completed > 0) {
+        snprintf(interactions, sizeof(interactions), "%.4e",
+                 svc->total_interactions_per_sec / svc->pairwise_completed);
+    }
+    snprintf(line, sizeof(line), "STATS queued=%d running=%d busy_threads=%d budget=%d completed=%d failed=%d "
+             "avg_wait=%.6f avg_run=%.6f avg_steps_per_sec=%.2f avg_interactions_per_sec=%s",
+             svc->queued, svc->running, svc->budget - svc->free_threads, svc->budget,
+             done, svc->failed, svc->total_wait * k, svc->total_run * k,
+             svc->total_steps_per_sec * k, interactions);
+    pthread_mutex_unlock(&svc->lock);
+    send_line(fd, "%s", line);
+    send_line(fd, "END");
+}
+
+static void *connection_main(void *arg) {
+    Connection *conn = (Connection*)arg;
+    Service *svc = conn->svc;
+    int fd = conn->fd;
+    free(conn);
+
+    /* Чтение строками через отдельный дескриптор: fd остаётся для ответов */
+    int rfd = dup(fd);
+    FILE *in = (rfd >= 0) ? fdopen(rfd, "r") : NULL;
+    char header[SERVICE_LINE];
+    if (!in || !fgets(header, sizeof(header), in)) {
+        if (in) fclose(in);
+        else if (rfd >= 0) close(rfd);
+        close(fd);
+        return NULL;
+    }
+
+    if (strncmp(header, "JOB", 3) == 0) {
+        const char *error = NULL;
+        Job *job = read_job(in, header, &error);
+        fclose(in);
+        if (!job) {
+            send_line(fd, "ERROR %s", error);
+            send_line(fd, "END");
+            close(fd);
+            return NULL;
+        }
+        job->client = fd;
+        if (!enqueue(svc, job)) {
+            /* После QUEUED клиент ждёт ответа по номеру задания */
+            if (job->id > 0) send_line(fd, "ERROR id=%d rejected: service shutting down", job->id);
+            else send_line(fd, "ERROR service shutting down");
+            send_line(fd, "END");
+            close(fd);
+            free(job->bodies);
+            free(job);
+        }
+        return NULL;
+    }
+
+    fclose(in);
+    if (strncmp(header, "STATS", 5) == 0) {
+        send_stats(svc, fd);
+    } else if (strncmp(header, "SHUTDOWN", 8) == 0) {
+        pthread_mutex_lock(&svc->lock);
+        svc->shutdown = 1;
+        pthread_cond_broadcast(&svc->changed);
+        pthread_mutex_unlock(&svc->lock);
+        send_line(fd, "OK");
+        send_line(fd, "END");
+        /* Прерывает accept в основном потоке */
+        shutdown(svc->listen_fd, SHUT_RDWR);
+    } else {
+        send_line(fd, "ERROR unknown command");
+        send_line(fd, "END");
+    }
+    close(fd);
+    return NULL;
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s <socket_path> <thread_budget>\n", prog);
+    fprintf(stderr, "  socket_path:   Unix socket to listen on (e.g. /tmp/nbody.sock)\n");
+    fprintf(stderr, "  thread_budget: OpenMP threads shared by all running jobs\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const char *path = argv[1];
+    int budget = atoi(argv[2]);
+    if (budget <= 0) {
+        fprintf(stderr, "Error: thread budget must be positive, got %s\n", argv[2]);
+        return 1;
+    }
+    if (strlen(path) >= sizeof(((struct sockaddr_un*)0)->sun_path)) {
+        fprintf(stderr, "Error: socket path %s is too long\n", path);
+        return 1;
+    }
+
+    /* Отключившийся клиент не должен завершать сервис */
+    signal(SIGPIPE, SIG_IGN);
+
+    Service svc;
+    memset(&svc, 0, sizeof(svc));
+    pthread_mutex_init(&svc.lock, NULL);
+    pthread_cond_init(&svc.changed, NULL);
+    svc.budget = budget;
+    svc.free_threads = budget;
+
+    svc.listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    if (svc.listen_fd < 0 || bind(svc.listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(svc.listen_fd, SERVICE_BACKLOG) != 0) {
+        fprintf(stderr, "Error: Cannot listen on %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    /* Рабочих потоков столько, сколько заданий по одному потоку помещается в бюджет */
+    pthread_t *workers = (pthread_t*)malloc((size_t)budget * sizeof(pthread_t));
+    if (!workers) {
+        fprintf(stderr, "Error: Failed to allocate worker pool\n");
+        return 1;
+    }
+    for (int w = 0; w < budget; w++) {
+        pthread_create(&workers[w], NULL, worker_main, &svc);
+    }
+
+    printf("=== N-Body Simulation Service ===\n");
+    printf("Socket: %s\n", path);
+    printf("Thread budget: %d\n", budget);
+    printf("=================================\n");
+    fflush(stdout);
+
+    for (;;) {
+        int fd = accept(svc.listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        Connection *conn = (Connection*)malloc(sizeof(Connection));
+        pthread_t thread;
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+        conn->svc = &svc;
+        conn->fd = fd;
+        if (pthread_create(&thread, NULL, connection_main, conn) != 0) {
+            close(fd);
+            free(conn);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+
+    /* Завершение: запущенные задания доделываются, ожидающие отменяются */
+    for (int w = 0; w < budget; w++) pthread_join(workers[w], NULL);
+    pthread_mutex_lock(&svc.lock);
+    Job *pending = svc.head;
+    svc.head = svc.tail = NULL;
+    svc.queued = 0;
+    pthread_mutex_unlock(&svc.lock);
+    for (Job *job = pending; job;) {
+        Job *next = job->next;
+        send_line(job->client, "ERROR id=%d service shutting down", job->id);
+        send_line(job->client, "END");
+        close(job->client);
+        free(job->bodies);
+        free(job);
+        job = next;
+    }
+
+    close(svc.listen_fd);
+    unlink(path);
+    printf("Service stopped: %d jobs completed, %d failed\n", svc.completed, svc.failed);
+    free(workers);
+    return 0;
+}
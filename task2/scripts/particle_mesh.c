@@ -0,0 +1,334 @@
+/* particle_mesh.c
+ * Метод частица-сетка: CIC, уравнение Пуассона через БПФ, интерполяция сил
+ */
+
+#include "particle_mesh.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Индекс узла сетки (x - самая медленная ось, z - непрерывная) */
+static inline size_t cell(int ng, int i, int j, int k) {
+    return ((size_t)i * ng + j) * ng + k;
+}
+
+/* --- Одномерное БПФ по основанию 2 (на месте, чередование re/im) --- */
+/* sign = -1 - прямое, +1 - обратное без нормировки */
+static void fft_1d(double *a, int n, const double *twiddle, const int *bitrev, int sign) {
+    for (int i = 0; i < n; i++) {
+        int r = bitrev[i];
+        if (i < r) {
+            double tr = a[2*i], ti = a[2*i+1];
+            a[2*i] = a[2*r]; a[2*i+1] = a[2*r+1];
+            a[2*r] = tr; a[2*r+1] = ti;
+        }
+    }
+
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len >> 1;
+        int step = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int j = 0; j < half; j++) {
+                double wr = twiddle[2 * j * step];
+                double wi = sign * twiddle[2 * j * step + 1];
+                double *u = a + 2 * (i + j);
+                double *v = a + 2 * (i + j + half);
+                double vr = v[0] * wr - v[1] * wi;
+                double vi = v[0] * wi + v[1] * wr;
+                v[0] = u[0] - vr; v[1] = u[1] - vi;
+                u[0] += vr;       u[1] += vi;
+            }
+        }
+    }
+}
+
+/* --- Трёхмерное БПФ: одномерные преобразования вдоль каждой оси --- */
+/* Строки распределяются между потоками; строки с шагом > 1 копируются в буфер потока */
+static void fft_3d(PMState *s, int sign) {
+    int ng = s->ng;
+    double *grid = s->grid;
+    size_t plane = (size_t)ng * ng;
+
+    /* Ось z: строки непрерывны */
+    #pragma omp parallel for schedule(static)
+    for (long l = 0; l < (long)plane; l++) {
+        fft_1d(grid + 2 * (size_t)l * ng, ng, s->twiddle, s->bitrev, sign);
+    }
+
+    /* Ось y: шаг ng */
+    #pragma omp parallel num_threads(s->nthreads)
+    {
+        double *line = s->line + (size_t)omp_get_thread_num() * 2 * ng;
+        #pragma omp for schedule(static)
+        for (long l = 0; l < (long)plane; l++) {
+            int i = (int)(l / ng), k = (int)(l % ng);
+            for (int j = 0; j < ng; j++) {
+                size_t c = cell(ng, i, j, k);
+                line[2*j] = grid[2*c]; line[2*j+1] = grid[2*c+1];
+            }
+            fft_1d(line, ng, s->twiddle, s->bitrev, sign);
+            for (int j = 0; j < ng; j++) {
+                size_t c = cell(ng, i, j, k);
+                grid[2*c] = line[2*j]; grid[2*c+1] = line[2*j+1];
+            }
+        }
+    }
+
+    /* Ось x: шаг ng^2 */
+    #pragma omp parallel num_threads(s->nthreads)
+    {
+        double *line = s->line + (size_t)omp_get_thread_num() * 2 * ng;
+        #pragma omp for schedule(static)
+        for (long l = 0; l < (long)plane; l++) {
+            int j = (int)(l / ng), k = (int)(l % ng);
+            for (int i = 0; i < ng; i++) {
+                size_t c = cell(ng, i, j, k);
+                line[2*i] = grid[2*c]; line[2*i+1] = grid[2*c+1];
+            }
+            fft_1d(line, ng, s->twiddle, s->bitrev, sign);
+            for (int i = 0; i < ng; i++) {
+                size_t c = cell(ng, i, j, k);
+                grid[2*c] = line[2*i]; grid[2*c+1] = line[2*i+1];
+            }
+        }
+    }
+}
+
+/* --- Веса CIC: узел i0 и доля d, приходящаяся на узел i0 + 1 --- */
+static inline void cic_weights(double pos, double origin, double h, int ng, int *i0, double *d) {
+    double u = fmod((pos - origin) / h - 0.5, (double)ng);
+    if (u < 0.0) u += ng;
+    int i = (int)u;
+    *d = u - i;
+    *i0 = i & (ng - 1);
+}
+
+/* --- Распределение масс: каждый поток пишет в свою сетку, затем редукция --- */
+static void assign_mass(PMState *s, const Body *bodies, int n) {
+    int ng = s->ng;
+    size_t ncells = (size_t)ng * ng * ng;
+    double inv_vol = 1.0 / (s->h * s->h * s->h);
+
+    #pragma omp parallel num_threads(s->nthreads)
+    {
+        int nt = omp_get_num_threads();
+        double *rho = s->rho_thread + (size_t)omp_get_thread_num() * ncells;
+        memset(rho, 0, ncells * sizeof(double));
+
+        #pragma omp for schedule(static)
+        for (int b = 0; b < n; b++) {
+            int i0, j0, k0;
+            double dx, dy, dz;
+            cic_weights(bodies[b].x, s->origin[0], s->h, ng, &i0, &dx);
+            cic_weights(bodies[b].y, s->origin[1], s->h, ng, &j0, &dy);
+            cic_weights(bodies[b].z, s->origin[2], s->h, ng, &k0, &dz);
+            int i1 = (i0 + 1) & (ng - 1), j1 = (j0 + 1) & (ng - 1), k1 = (k0 + 1) & (ng - 1);
+            double m = bodies[b].mass * inv_vol;
+            double tx = 1.0 - dx, ty = 1.0 - dy, tz = 1.0 - dz;
+
+            rho[cell(ng, i0, j0, k0)] += m * tx * ty * tz;
+            rho[cell(ng, i0, j0, k1)] += m * tx * ty * dz;
+            rho[cell(ng, i0, j1, k0)] += m * tx * dy * tz;
+            rho[cell(ng, i0, j1, k1)] += m * tx * dy * dz;
+            rho[cell(ng, i1, j0, k0)] += m * dx * ty * tz;
+            rho[cell(ng, i1, j0, k1)] += m * dx * ty * dz;
+            rho[cell(ng, i1, j1, k0)] += m * dx * dy * tz;
+            rho[cell(ng, i1, j1, k1)] += m * dx * dy * dz;
+        }
+        /* Неявный барьер: все сетки заполнены */
+
+        #pragma omp for schedule(static)
+        for (long c = 0; c < (long)ncells; c++) {
+            double sum = 0.0;
+            for (int t = 0; t < nt; t++) sum += s->rho_thread[(size_t)t * ncells + c];
+            s->grid[2*c] = sum;
+            s->grid[2*c+1] = 0.0;
+        }
+    }
+}
+
+/* --- Функция Грина дискретного лапласиана: phi_k = -4 pi G rho_k / K^2 --- */
+static void solve_poisson(PMState *s) {
+    int ng = s->ng;
+    double *grid = s->grid;
+    const double *sin2 = s->sin2;
+    double norm = 1.0 / ((double)ng * ng * ng);    /* Нормировка обратного БПФ */
+
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (int i = 0; i < ng; i++) {
+        for (int j = 0; j < ng; j++) {
+            for (int k = 0; k < ng; k++) {
+                size_t c = cell(ng, i, j, k);
+                double k2 = sin2[i] + sin2[j] + sin2[k];
+                double green = (k2 > 0.0) ? -4.0 * M_PI * G * norm / k2 : 0.0;
+                grid[2*c] *= green;
+                grid[2*c+1] *= green;
+            }
+        }
+    }
+}
+
+/* --- Ускорения в узлах: центральные разности потенциала --- */
+static void compute_gradient(PMState *s) {
+    int ng = s->ng, mask = ng - 1;
+    const double *grid = s->grid;
+    double inv_2h = 1.0 / (2.0 * s->h);
+
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (int i = 0; i < ng; i++) {
+        for (int j = 0; j < ng; j++) {
+            for (int k = 0; k < ng; k++) {
+                size_t c = cell(ng, i, j, k);
+                s->ax[c] = -(grid[2 * cell(ng, (i + 1) & mask, j, k)]
+                           - grid[2 * cell(ng, (i - 1) & mask, j, k)]) * inv_2h;
+                s->ay[c] = -(grid[2 * cell(ng, i, (j + 1) & mask, k)]
+                           - grid[2 * cell(ng, i, (j - 1) & mask, k)]) * inv_2h;
+                s->az[c] = -(grid[2 * cell(ng, i, j, (k + 1) & mask)]
+                           - grid[2 * cell(ng, i, j, (k - 1) & mask)]) * inv_2h;
+            }
+        }
+    }
+}
+
+/* --- Интерполяция ускорений на тела теми же весами CIC --- */
+static void interpolate_forces(PMState *s, const Body *bodies, int n,
+                               double *fx, double *fy, double *fz) {
+    int ng = s->ng;
+
+    #pragma omp parallel for schedule(static)
+    for (int b = 0; b < n; b++) {
+        int i0, j0, k0;
+        double dx, dy, dz;
+        cic_weights(bodies[b].x, s->origin[0], s->h, ng, &i0, &dx);
+        cic_weights(bodies[b].y, s->origin[1], s->h, ng, &j0, &dy);
+        cic_weights(bodies[b].z, s->origin[2], s->h, ng, &k0, &dz);
+        int i1 = (i0 + 1) & (ng - 1), j1 = (j0 + 1) & (ng - 1), k1 = (k0 + 1) & (ng - 1);
+        double tx = 1.0 - dx, ty = 1.0 - dy, tz = 1.0 - dz;
+
+        size_t c[8] = {
+            cell(ng, i0, j0, k0), cell(ng, i0, j0, k1), cell(ng, i0, j1, k0), cell(ng, i0, j1, k1),
+            cell(ng, i1, j0, k0), cell(ng, i1, j0, k1), cell(ng, i1, j1, k0), cell(ng, i1, j1, k1)
+        };
+        double w[8] = {
+            tx * ty * tz, tx * ty * dz, tx * dy * tz, tx * dy * dz,
+            dx * ty * tz, dx * ty * dz, dx * dy * tz, dx * dy * dz
+        };
+
+        double ax = 0.0, ay = 0.0, az = 0.0;
+        for (int q = 0; q < 8; q++) {
+            ax += w[q] * s->ax[c[q]];
+            ay += w[q] * s->ay[c[q]];
+            az += w[q] * s->az[c[q]];
+        }
+        fx[b] = bodies[b].mass * ax;
+        fy[b] = bodies[b].mass * ay;
+        fz[b] = bodies[b].mass * az;
+    }
+}
+
+void pm_forces(PMState *s, const Body *bodies, int n, double *fx, double *fy, double *fz) {
+    PMTimings *t = &s->timings;
+    double t0 = omp_get_wtime();
+    assign_mass(s, bodies, n);
+    double t1 = omp_get_wtime();
+    fft_3d(s, -1);
+    double t2 = omp_get_wtime();
+    solve_poisson(s);
+    double t3 = omp_get_wtime();
+    fft_3d(s, +1);
+    double t4 = omp_get_wtime();
+    compute_gradient(s);
+    double t5 = omp_get_wtime();
+    interpolate_forces(s, bodies, n, fx, fy, fz);
+    double t6 = omp_get_wtime();
+
+    t->assign += t1 - t0;
+    t->fft_forward += t2 - t1;
+    t->solve += t3 - t2;
+    t->fft_inverse += t4 - t3;
+    t->gradient += t5 - t4;
+    t->interpolate += t6 - t5;
+    t->evaluations++;
+}
+
+int pm_init(PMState *s, const Body *bodies, int n, int ng, double box, int nthreads) {
+    memset(s, 0, sizeof(*s));
+    if (ng < 2 || (ng & (ng - 1)) != 0) {
+        fprintf(stderr, "Error: PM grid size must be a power of two, got %d\n", ng);
+        return 0;
+    }
+    s->ng = ng;
+    s->nthreads = nthreads;
+
+    if (box > 0.0) {
+        s->box = box;
+        s->origin[0] = s->origin[1] = s->origin[2] = 0.0;
+    } else {
+        /* Куб вокруг начальных положений с отступом в одну ячейку */
+        double lo[3];
+        double extent = bounding_cube(bodies, n, lo);
+        if (extent <= 0.0) extent = 1.0;
+        s->box = extent * ng / (ng - 2.0);
+        for (int d = 0; d < 3; d++) s->origin[d] = lo[d] - s->box / ng;
+    }
+    s->h = s->box / ng;
+
+    size_t ncells = (size_t)ng * ng * ng;
+    s->grid = (double*)malloc(2 * ncells * sizeof(double));
+    s->rho_thread = (double*)malloc((size_t)nthreads * ncells * sizeof(double));
+    s->ax = (double*)malloc(ncells * sizeof(double));
+    s->ay = (double*)malloc(ncells * sizeof(double));
+    s->az = (double*)malloc(ncells * sizeof(double));
+    s->twiddle = (double*)malloc(ng * sizeof(double));
+    s->bitrev = (int*)malloc(ng * sizeof(int));
+    s->line = (double*)malloc((size_t)nthreads * 2 * ng * sizeof(double));
+    s->sin2 = (double*)malloc(ng * sizeof(double));
+    if (!s->grid || !s->rho_thread || !s->ax || !s->ay || !s->az ||
+        !s->twiddle || !s->bitrev || !s->line || !s->sin2) {
+        fprintf(stderr, "Error: Failed to allocate PM grids (ng=%d, nthreads=%d)\n", ng, nthreads);
+        pm_free(s);
+        return 0;
+    }
+
+    /* cos, sin(2 pi k / ng) для k < ng/2; знак мнимой части задаёт fft_1d */
+    for (int k = 0; k < ng / 2; k++) {
+        s->twiddle[2*k] = cos(2.0 * M_PI * k / ng);
+        s->twiddle[2*k+1] = sin(2.0 * M_PI * k / ng);
+    }
+    int bits = 0;
+    while ((1 << bits) < ng) bits++;
+    for (int i = 0; i < ng; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        }
+        s->bitrev[i] = r;
+    }
+
+    /* Собственные значения дискретного лапласиана по оси */
+    double scale = 4.0 / (s->h * s->h);
+    for (int i = 0; i < ng; i++) {
+        double v = sin(M_PI * i / ng);
+        s->sin2[i] = scale * v * v;
+    }
+
+    return 1;
+}
+
+void pm_free(PMState *s) {
+    free(s->grid);
+    free(s->rho_thread);
+    free(s->ax); free(s->ay); free(s->az);
+    free(s->twiddle);
+    free(s->bitrev);
+    free(s->line);
+    free(s->sin2);
+    memset(s, 0, sizeof(*s));
+}
@@ -0,0 +1,52 @@
+/* particle_mesh.h
+ * Метод частица-сетка (PM) для периодического куба: распределение масс
+ * по схеме CIC, решение уравнения Пуассона трёхмерным БПФ и интерполяция
+ * ускорений обратно на тела. Стоимость шага O(N + Ng^3 log Ng) вместо O(N^2).
+ */
+
+#ifndef PARTICLE_MESH_H
+#define PARTICLE_MESH_H
+
+#include "nbody.h"
+
+/* Время стадий (секунды, сумма по всем вычислениям сил) */
+typedef struct {
+    double assign;          /* CIC: пер-поточные сетки + редукция */
+    double fft_forward;     /* Прямое БПФ плотности */
+    double solve;           /* Умножение на функцию Грина */
+    double fft_inverse;     /* Обратное БПФ потенциала */
+    double gradient;        /* Ускорения разностями потенциала */
+    double interpolate;     /* CIC-интерполяция ускорений на тела */
+    int evaluations;
+} PMTimings;
+
+typedef struct {
+    int ng;                 /* Узлов сетки по оси (степень двойки) */
+    double box;             /* Длина ребра периодического куба, м */
+    double origin[3];       /* Угол куба */
+    double h;               /* Шаг сетки */
+    int nthreads;
+
+    double *grid;           /* Комплексная сетка (re, im), ng^3: плотность -> потенциал */
+    double *rho_thread;     /* Пер-поточные сетки плотности: nthreads * ng^3 */
+    double *ax, *ay, *az;   /* Ускорения в узлах */
+
+    /* Таблицы одномерного БПФ длины ng */
+    double *twiddle;        /* cos, sin для k < ng/2 */
+    int *bitrev;
+    double *line;           /* Пер-поточные буферы строк: nthreads * 2 * ng */
+    double *sin2;           /* (2 sin(pi i / ng) / h)^2 - слагаемые K^2 по оси */
+
+    PMTimings timings;
+} PMState;
+
+/* Куб [origin, origin + box); box <= 0 - куб вокруг тел с запасом в одну ячейку.
+ * Возвращает 0 при ошибке */
+int pm_init(PMState *s, const Body *bodies, int n, int ng, double box, int nthreads);
+
+/* Силы на тела (F = m a) в fx, fy, fz */
+void pm_forces(PMState *s, const Body *bodies, int n, double *fx, double *fy, double *fz);
+
+void pm_free(PMState *s);
+
+#endif /* PARTICLE_MESH_H */
@@ -0,0 +1,334 @@
+/* regularization.c
+ * Поиск тесных пар и интегрирование их относительного движения в переменных KS
+ */
+
+#include "regularization.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <omp.h>
+
+#define REG_MAX_SUBSTEPS 1000000   /* Защита от зацикливания при вырожденной паре */
+#define REG_NEWTON_ITERATIONS 4    /* Подбор длины последнего шага под конец глобального шага */
+
+/* --- Преобразование KS ---
+ * Матрица L(u):
+ *   | u1 -u2 -u3  u4 |
+ *   | u2  u1 -u4 -u3 |
+ *   | u3  u4  u1  u2 |
+ *   | u4 -u3  u2 -u1 |
+ * r = L(u) u (четвёртая компонента равна нулю), u' = L(u)^T v / 2, v = 2 L(u) u' / r */
+static void ks_L(const double u[4], const double a[4], double out[4]) {
+    out[0] = u[0] * a[0] - u[1] * a[1] - u[2] * a[2] + u[3] * a[3];
+    out[1] = u[1] * a[0] + u[0] * a[1] - u[3] * a[2] - u[2] * a[3];
+    out[2] = u[2] * a[0] + u[3] * a[1] + u[0] * a[2] + u[1] * a[3];
+    out[3] = u[3] * a[0] - u[2] * a[1] + u[1] * a[2] - u[0] * a[3];
+}
+
+static void ks_LT(const double u[4], const double a[4], double out[4]) {
+    out[0] =  u[0] * a[0] + u[1] * a[1] + u[2] * a[2] + u[3] * a[3];
+    out[1] = -u[1] * a[0] + u[0] * a[1] + u[3] * a[2] - u[2] * a[3];
+    out[2] = -u[2] * a[0] - u[3] * a[1] + u[0] * a[2] + u[1] * a[3];
+    out[3] =  u[3] * a[0] - u[2] * a[1] + u[1] * a[2] - u[0] * a[3];
+}
+
+/* Обратное преобразование с выбором ветви без деления на малое число */
+static void ks_from_position(const double r[3], double u[4]) {
+    double rr = sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+    if (r[0] >= 0.0) {
+        u[0] = sqrt(0.5 * (rr + r[0]));
+        u[1] = (u[0] > 0.0) ? 0.5 * r[1] / u[0] : 0.0;
+        u[2] = (u[0] > 0.0) ? 0.5 * r[2] / u[0] : 0.0;
+        u[3] = 0.0;
+    } else {
+        u[1] = sqrt(0.5 * (rr - r[0]));
+        u[0] = 0.5 * r[1] / u[1];
+        u[3] = 0.5 * r[2] / u[1];
+        u[2] = 0.0;
+    }
+}
+
+/* Состояние KS: u[4], u'[4], h, t */
+#define KS_DIM 10
+
+/* Правые части по фиктивному времени s при постоянном возмущении P */
+static void ks_derivs(const double y[KS_DIM], const double P[4], double dy[KS_DIM]) {
+    const double *u = y, *up = y + 4;
+    double h = y[8];
+    double r = u[0] * u[0] + u[1] * u[1] + u[2] * u[2] + u[3] * u[3];
+    double q[4];
+    ks_LT(u, P, q);
+    for (int k = 0; k < 4; k++) {
+        dy[k] = up[k];
+        dy[4 + k] = 0.5 * h * u[k] + 0.5 * r * q[k];
+    }
+    dy[8] = 2.0 * (up[0] * q[0] + up[1] * q[1] + up[2] * q[2] + up[3] * q[3]);
+    dy[9] = r;
+}
+
+static void ks_rk4(double y[KS_DIM], const double P[4], double ds) {
+    double k1[KS_DIM], k2[KS_DIM], k3[KS_DIM], k4[KS_DIM], tmp[KS_DIM];
+    ks_derivs(y, P, k1);
+    for (int k = 0; k < KS_DIM; k++) tmp[k] = y[k] + 0.5 * ds * k1[k];
+    ks_derivs(tmp, P, k2);
+    for (int k = 0; k < KS_DIM; k++) tmp[k] = y[k] + 0.5 * ds * k2[k];
+    ks_derivs(tmp, P, k3);
+    for (int k = 0; k < KS_DIM; k++) tmp[k] = y[k] + ds * k3[k];
+    ks_derivs(tmp, P, k4);
+    for (int k = 0; k < KS_DIM; k++) {
+        y[k] += ds / 6.0 * (k1[k] + 2.0 * k2[k] + 2.0 * k3[k] + k4[k]);
+    }
+}
+
+/* --- Относительное движение пары за dt: r'' = -mu r / |r|^3 + P ---
+ * Шаг по s задаёт долю местного динамического времени: dt_loc = r ds = REG_ETA sqrt(r^3/mu).
+ * Последний шаг подбирается под остаток времени: t' = r меняется за шаг, поэтому
+ * длина шага уточняется итерациями Ньютона. Возвращает число шагов. */
+static int ks_advance(double r[3], double v[3], const double P3[3], double mu, double dt) {
+    double y[KS_DIM];
+    double *u = y, *up = y + 4;
+    ks_from_position(r, u);
+    double v4[4] = {v[0], v[1], v[2], 0.0};
+    double q[4];
+    ks_LT(u, v4, q);
+    for (int k = 0; k < 4; k++) up[k] = 0.5 * q[k];
+    double rr = u[0] * u[0] + u[1] * u[1] + u[2] * u[2] + u[3] * u[3];
+    y[8] = 0.5 * (v[0] * v[0] + v[1] * v[1] + v[2] * v[2]) - mu / rr;
+    y[9] = 0.0;
+
+    double P[4] = {P3[0], P3[1], P3[2], 0.0};
+    int steps = 0;
+    for (;;) {
+        rr = u[0] * u[0] + u[1] * u[1] + u[2] * u[2] + u[3] * u[3];
+        double ds = REG_ETA * sqrt(rr / mu);
+        if (y[9] + rr * ds < dt && steps < REG_MAX_SUBSTEPS) {
+            ks_rk4(y, P, ds);
+            steps++;
+            continue;
+        }
+
+        /* Последний шаг: ds по методу Ньютона из условия t(s) = dt, dt/ds = r */
+        double y0[KS_DIM];
+        memcpy(y0, y, sizeof(y0));
+        ds = (dt - y0[9]) / rr;
+        for (int it = 0; it < REG_NEWTON_ITERATIONS; it++) {
+            memcpy(y, y0, sizeof(y0));
+            ks_rk4(y, P, ds);
+            double r_end = u[0] * u[0] + u[1] * u[1] + u[2] * u[2] + u[3] * u[3];
+            double miss = dt - y[9];
+            if (fabs(miss) <= 1e-15 * dt) break;
+            ds += miss / r_end;
+        }
+        steps++;
+        break;
+    }
+
+    double x4[4], w4[4];
+    ks_L(u, u, x4);
+    ks_L(u, up, w4);
+    rr = u[0] * u[0] + u[1] * u[1] + u[2] * u[2] + u[3] * u[3];
+    for (int d = 0; d < 3; d++) {
+        r[d] = x4[d];
+        v[d] = 2.0 * w4[d] / rr;
+    }
+    return steps;
+}
+
+/* --- Поиск взаимно ближайших соседей в радиусе регуляризации ---
+ * Заодно находится наименьшее расстояние между телами в пределах ребра ячейки
+ * (clearance) для пропуска следующих поисков. Пока пар нет, ячейки не меньше
+ * 2 radius - иначе пропуск невозможен; при парах пропуска нет, и ячейки не
+ * меньше radius. Ячеек не больше 4 cbrt(n) по оси (до 64 на тело) - при большом
+ * кубе и малом радиусе иначе обнуление и префиксная сумма по миллионам пустых
+ * ячеек стоили бы больше самого поиска */
+static int find_pairs(RegState *s, const Body *bodies) {
+    int n = s->n;
+    double search = (s->npairs == 0 ? 2.0 : 1.0) * s->radius;
+    double origin[3];
+    double box = bounding_cube(bodies, n, origin);
+    if (box <= 0.0) box = search;
+    double min_cell = box / (4.0 * ceil(cbrt((double)n)));
+    if (min_cell < search) min_cell = search;
+    if (!cl_build(&s->cl, bodies, origin, box, min_cell, 0)) return 0;
+
+    const CellList *cl = &s->cl;
+    double r2max = s->radius * s->radius;
+    /* Тела не из соседних ячеек дальше ребра ячейки */
+    double closest2 = cl->cell * cl->cell;
+
+    #pragma omp parallel for schedule(dynamic, 64) num_threads(s->nthreads) reduction(min:closest2)
+    for (int i = 0; i < n; i++) {
+        int neigh[27];
+        int count = cl_neighbor_cells(cl, cl->cell_of[i], neigh);
+        double best = r2max;
+        int nearest = -1;
+        for (int k = 0; k < count; k++) {
+            int c2 = neigh[k];
+            for (int b = cl->cell_start[c2]; b < cl->cell_start[c2 + 1]; b++) {
+                int j = cl->index[b];
+                if (j == i) continue;
+                double dx = bodies[j].x - bodies[i].x;
+                double dy = bodies[j].y - bodies[i].y;
+                double dz = bodies[j].z - bodies[i].z;
+                double d2 = dx * dx + dy * dy + dz * dz;
+                if (d2 < closest2) closest2 = d2;
+                /* При равных расстояниях - меньший номер: выбор не зависит от порядка ячеек */
+                if (d2 < best || (d2 == best && nearest >= 0 && j < nearest)) {
+                    best = d2;
+                    nearest = j;
+                }
+            }
+        }
+        s->nearest[i] = nearest;
+    }
+
+    for (int i = 0; i < n; i++) {
+        s->ref[3 * i] = bodies[i].x;
+        s->ref[3 * i + 1] = bodies[i].y;
+        s->ref[3 * i + 2] = bodies[i].z;
+    }
+    s->clearance = sqrt(closest2);
+
+    s->npairs = 0;
+    for (int i = 0; i < n; i++) {
+        int j = s->nearest[i];
+        if (j > i && s->nearest[j] == i) {
+            s->pairs[s->npairs].i = i;
+            s->pairs[s->npairs].j = j;
+            s->npairs++;
+        }
+    }
+    return 1;
+}
+
+/* Наибольшее смещение тела от координат последнего поиска */
+static double max_displacement(const RegState *s, const Body *bodies) {
+    double max2 = 0.0;
+    #pragma omp parallel for schedule(static) num_threads(s->nthreads) reduction(max:max2)
+    for (int i = 0; i < s->n; i++) {
+        double dx = bodies[i].x - s->ref[3 * i];
+        double dy = bodies[i].y - s->ref[3 * i + 1];
+        double dz = bodies[i].z - s->ref[3 * i + 2];
+        double d2 = dx * dx + dy * dy + dz * dz;
+        if (d2 > max2) max2 = d2;
+    }
+    return sqrt(max2);
+}
+
+void reg_advance(RegState *s, const Body *bodies, const double *fx, const double *fy,
+                 const double *fz, double dt) {
+    double start = omp_get_wtime();
+
+    /* Пар не было, и ни одна пара тел не могла сблизиться до radius - поиск не нужен */
+    if (s->npairs == 0 && s->clearance >= 0.0 &&
+        s->clearance - 2.0 * max_displacement(s, bodies) > s->radius) {
+        s->skipped++;
+        s->time += omp_get_wtime() - start;
+        return;
+    }
+    s->searches++;
+    if (!find_pairs(s, bodies)) {
+        s->npairs = 0;
+        s->time += omp_get_wtime() - start;
+        return;
+    }
+
+    long long substeps = 0;
+    double min_sep = s->min_separation;
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(s->nthreads) \
+        reduction(+:substeps) reduction(min:min_sep)
+    for (int p = 0; p < s->npairs; p++) {
+        RegPair *pair = &s->pairs[p];
+        const Body *a = &bodies[pair->i], *b = &bodies[pair->j];
+        double ma = a->mass, mb = b->mass, m = ma + mb;
+
+        /* Взаимная сила пары - той же формулой, что в compute_forces; остаток - внешняя */
+        double r[3] = {b->x - a->x, b->y - a->y, b->z - a->z};
+        double v[3] = {b->vx - a->vx, b->vy - a->vy, b->vz - a->vz};
+        double r_sq = r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+        double inv_r = 1.0 / sqrt(r_sq + SOFTENING);
+        double ff = G * ma * mb * inv_r * inv_r * inv_r;
+        double fa[3] = {fx[pair->i] - ff * r[0], fy[pair->i] - ff * r[1], fz[pair->i] - ff * r[2]};
+        double fb[3] = {fx[pair->j] + ff * r[0], fy[pair->j] + ff * r[1], fz[pair->j] + ff * r[2]};
+        if (sqrt(r_sq) < min_sep) min_sep = sqrt(r_sq);
+
+        /* Центр масс - шаг Эйлера как у остальных тел; P - приливное ускорение */
+        double xc[3] = {(ma * a->x + mb * b->x) / m, (ma * a->y + mb * b->y) / m,
+                        (ma * a->z + mb * b->z) / m};
+        double vc[3] = {(ma * a->vx + mb * b->vx) / m, (ma * a->vy + mb * b->vy) / m,
+                        (ma * a->vz + mb * b->vz) / m};
+        double P[3];
+        for (int d = 0; d < 3; d++) {
+            xc[d] += vc[d] * dt;
+            vc[d] += (fa[d] + fb[d]) / m * dt;
+            P[d] = fb[d] / mb - fa[d] / ma;
+        }
+
+        pair->substeps = ks_advance(r, v, P, G * m, dt);
+        substeps += pair->substeps;
+
+        pair->bi = *a;
+        pair->bj = *b;
+        pair->bi.x = xc[0] - mb / m * r[0];
+        pair->bi.y = xc[1] - mb / m * r[1];
+        pair->bi.z = xc[2] - mb / m * r[2];
+        pair->bi.vx = vc[0] - mb / m * v[0];
+        pair->bi.vy = vc[1] - mb / m * v[1];
+        pair->bi.vz = vc[2] - mb / m * v[2];
+        pair->bj.x = xc[0] + ma / m * r[0];
+        pair->bj.y = xc[1] + ma / m * r[1];
+        pair->bj.z = xc[2] + ma / m * r[2];
+        pair->bj.vx = vc[0] + ma / m * v[0];
+        pair->bj.vy = vc[1] + ma / m * v[1];
+        pair->bj.vz = vc[2] + ma / m * v[2];
+    }
+
+    s->substeps += substeps;
+    s->pair_steps += s->npairs;
+    if (s->npairs > s->max_pairs) s->max_pairs = s->npairs;
+    s->min_separation = min_sep;
+    s->time += omp_get_wtime() - start;
+}
+
+void reg_apply(const RegState *s, Body *bodies) {
+    for (int p = 0; p < s->npairs; p++) {
+        bodies[s->pairs[p].i] = s->pairs[p].bi;
+        bodies[s->pairs[p].j] = s->pairs[p].bj;
+    }
+}
+
+int reg_init(RegState *s, int n, double radius, int nthreads) {
+    memset(s, 0, sizeof(*s));
+    s->n = n;
+    s->radius = radius;
+    s->nthreads = nthreads;
+    s->min_separation = DBL_MAX;
+
+    s->clearance = -1.0;
+
+    s->nearest = (int*)malloc((size_t)n * sizeof(int));
+    s->pairs = (RegPair*)malloc((size_t)(n / 2 + 1) * sizeof(RegPair));
+    s->ref = (double*)malloc((size_t)n * 3 * sizeof(double));
+    if (!s->nearest || !s->pairs || !s->ref) {
+        fprintf(stderr, "Error: Failed to allocate regularization buffers (n=%d)\n", n);
+        reg_free(s);
+        return 0;
+    }
+    if (!cl_init(&s->cl, n)) {
+        reg_free(s);
+        return 0;
+    }
+    return 1;
+}
+
+void reg_free(RegState *s) {
+    cl_free(&s->cl);
+    free(s->nearest);
+    free(s->pairs);
+    free(s->ref);
+    memset(s, 0, sizeof(*s));
+}
@@ -0,0 +1,63 @@
+/* regularization.h
+ * Регуляризация тесных сближений для метода Эйлера: пары тел ближе радиуса
+ * регуляризации, взаимно ближайшие друг к другу, выделяются на каждом шаге.
+ * Центр масс пары делает обычный шаг Эйлера под действием внешних сил,
+ * относительное движение интегрируется в переменных Кустаанхеймо-Штифеля (KS):
+ *
+ *   r = L(u) u,  dt = r ds,  u'' = h u / 2 + r L(u)^T P / 2,  h' = 2 u' . L(u)^T P
+ *
+ * где h - удельная энергия пары, P - разность внешних ускорений тел. Без
+ * возмущения уравнения для u - гармонический осциллятор: особенности при
+ * r -> 0 нет, и шаг по s не уменьшается в перицентре.
+ */
+
+#ifndef REGULARIZATION_H
+#define REGULARIZATION_H
+
+#include "nbody.h"
+#include "cell_list.h"
+
+#define REG_ETA 0.05        /* Шаг по s: dt_loc = REG_ETA * sqrt(r^3 / mu) */
+
+typedef struct {
+    int i, j;               /* Тела пары, i < j */
+    Body bi, bj;            /* Состояние после шага */
+    int substeps;           /* Шагов KS за глобальный шаг */
+} RegPair;
+
+typedef struct {
+    int n;
+    double radius;          /* Радиус регуляризации, м */
+    int nthreads;
+    CellList cl;
+    int *nearest;           /* Ближайший сосед в радиусе (-1 - нет) */
+    RegPair *pairs;
+    int npairs;
+
+    /* Пропуск поиска: пара ближе radius не могла появиться, пока clearance
+     * минус удвоенное наибольшее смещение тела от ref больше radius */
+    double *ref;            /* Координаты тел при последнем поиске (x, y, z подряд) */
+    double clearance;       /* Наименьшее расстояние между телами при нём (до ребра ячейки), <0 - поиска не было */
+    long long searches;     /* Шагов с поиском пар */
+    long long skipped;      /* Шагов, где поиск пропущен */
+
+    long long pair_steps;   /* Шагов, сделанных парами в KS */
+    long long substeps;     /* Шагов KS всего */
+    int max_pairs;          /* Наибольшее число пар за шаг */
+    double min_separation;  /* Наименьшее расстояние в регуляризованной паре */
+    double time;            /* Время поиска и интегрирования пар, с */
+} RegState;
+
+/* Возвращает 0 при ошибке */
+int reg_init(RegState *s, int n, double radius, int nthreads);
+
+/* Поиск пар и шаг их относительного движения по силам fx, fy, fz (до update_bodies) */
+void reg_advance(RegState *s, const Body *bodies, const double *fx, const double *fy,
+                 const double *fz, double dt);
+
+/* Запись состояний пар поверх шага Эйлера (после update_bodies) */
+void reg_apply(const RegState *s, Body *bodies);
+
+void reg_free(RegState *s);
+
+#endif /* REGULARIZATION_H */
@@ -0,0 +1,154 @@
+/* render.c
+ * Проекции плотности тел в PGM
+ */
+
+#include "render.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <omp.h>
+
+#define RENDER_MARGIN 0.1      /* Поля вокруг начальной области */
+
+const char *render_axis_name(RenderAxis axis) {
+    switch (axis) {
+        case RENDER_XZ: return "xz";
+        case RENDER_YZ: return "yz";
+        default:        return "xy";
+    }
+}
+
+/* Координаты тела в плоскости проекции */
+static inline void project(RenderAxis axis, const Body *b, double *u, double *v) {
+    switch (axis) {
+        case RENDER_XZ: *u = b->x; *v = b->z; break;
+        case RENDER_YZ: *u = b->y; *v = b->z; break;
+        default:        *u = b->x; *v = b->y; break;
+    }
+}
+
+/* --- Суммирование масс: каждый поток в своё изображение, затем редукция по пикселям --- */
+static void deposit(RenderState *s, const Body *bodies, int n) {
+    int size = s->size;
+    size_t npix = (size_t)size * size;
+
+    #pragma omp parallel num_threads(s->nthreads)
+    {
+        int nt = omp_get_num_threads();
+        float *img = s->thread_img + (size_t)omp_get_thread_num() * npix;
+        memset(img, 0, npix * sizeof(float));
+
+        #pragma omp for schedule(static)
+        for (int i = 0; i < n; i++) {
+            double u, v;
+            project(s->axis, &bodies[i], &u, &v);
+            double px = (u - s->lo[0]) * s->scale;
+            double py = (v - s->lo[1]) * s->scale;
+            if (px < 0.0 || py < 0.0 || px >= size || py >= size) continue;
+            /* Ось v направлена вверх: строка 0 кадра - верх области */
+            img[(size_t)(size - 1 - (int)py) * size + (int)px] += (float)bodies[i].mass;
+        }
+        /* Неявный барьер: все изображения заполнены */
+
+        #pragma omp for schedule(static)
+        for (long p = 0; p < (long)npix; p++) {
+            float sum = 0.0f;
+            for (int t = 0; t < nt; t++) sum += s->thread_img[(size_t)t * npix + p];
+            s->img[p] = sum;
+        }
+    }
+}
+
+int render_frame(RenderState *s, const Body *bodies, int n, int step) {
+    double start = omp_get_wtime();
+    size_t npix = (size_t)s->size * s->size;
+
+    deposit(s, bodies, n);
+
+    /* Логарифмическая шкала: log(1 + m / m_unit); верх шкалы фиксируется первым кадром,
+     * чтобы яркость кадров была сравнимой */
+    if (s->frames == 0) {
+        float max_mass = 0.0f;
+        #pragma omp parallel for reduction(max:max_mass)
+        for (long p = 0; p < (long)npix; p++) {
+            if (s->img[p] > max_mass) max_mass = s->img[p];
+        }
+        s->log_max = log1p(max_mass / s->mass_unit);
+        if (s->log_max <= 0.0) s->log_max = 1.0;
+    }
+
+    double k = 255.0 / s->log_max;
+    #pragma omp parallel for schedule(static)
+    for (long p = 0; p < (long)npix; p++) {
+        double value = k * log1p(s->img[p] / s->mass_unit);
+        s->pixels[p] = (unsigned char)(value > 255.0 ? 255.0 : value);
+    }
+
+    char fname[600];
+    snprintf(fname, sizeof(fname), "%s/frame_%06d.pgm", s->dir, step);
+    FILE *f = fopen(fname, "wb");
+    if (!f) {
+        fprintf(stderr, "Error: Cannot open %s for writing\n", fname);
+        return 0;
+    }
+    long long bytes = fprintf(f, "P5\n%d %d\n255\n", s->size, s->size);
+    bytes += (long long)fwrite(s->pixels, 1, npix, f);
+    fclose(f);
+
+    s->frames++;
+    s->bytes += bytes;
+    s->time += omp_get_wtime() - start;
+    return 1;
+}
+
+int render_init(RenderState *s, const Body *bodies, int n, int size, RenderAxis axis,
+                const char *dir, int nthreads) {
+    memset(s, 0, sizeof(*s));
+    s->size = size;
+    s->axis = axis;
+    s->nthreads = nthreads;
+    snprintf(s->dir, sizeof(s->dir), "%s", dir);
+
+    /* Квадрат вокруг проекций начальных положений */
+    double lo[2] = {DBL_MAX, DBL_MAX}, hi[2] = {-DBL_MAX, -DBL_MAX};
+    double min_mass = DBL_MAX;
+    for (int i = 0; i < n; i++) {
+        double p[2];
+        project(axis, &bodies[i], &p[0], &p[1]);
+        for (int d = 0; d < 2; d++) {
+            if (p[d] < lo[d]) lo[d] = p[d];
+            if (p[d] > hi[d]) hi[d] = p[d];
+        }
+        if (bodies[i].mass > 0.0 && bodies[i].mass < min_mass) min_mass = bodies[i].mass;
+    }
+    double extent = (hi[0] - lo[0] > hi[1] - lo[1]) ? hi[0] - lo[0] : hi[1] - lo[1];
+    if (extent <= 0.0) extent = 1.0;
+    double view = extent * (1.0 + 2.0 * RENDER_MARGIN);
+    for (int d = 0; d < 2; d++) {
+        s->lo[d] = 0.5 * (lo[d] + hi[d]) - 0.5 * view;
+    }
+    s->scale = size / view;
+    /* Единица шкалы - самое лёгкое тело: оно остаётся видимым рядом с тяжёлыми */
+    s->mass_unit = (min_mass < DBL_MAX) ? min_mass : 1.0;
+
+    size_t npix = (size_t)size * size;
+    s->thread_img = (float*)malloc((size_t)nthreads * npix * sizeof(float));
+    s->img = (float*)malloc(npix * sizeof(float));
+    s->pixels = (unsigned char*)malloc(npix);
+    if (!s->thread_img || !s->img || !s->pixels) {
+        fprintf(stderr, "Error: Failed to allocate render buffers (%dx%d)\n", size, size);
+        render_free(s);
+        return 0;
+    }
+    return 1;
+}
+
+void render_free(RenderState *s) {
+    free(s->thread_img);
+    free(s->img);
+    free(s->pixels);
+    memset(s, 0, sizeof(*s));
+}
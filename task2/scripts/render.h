@@ -0,0 +1,50 @@
+/* render.h
+ * Рендеринг проекций плотности прямо из памяти: масса тел суммируется
+ * в пиксели двумерной сетки и записывается в логарифмической шкале как
+ * 8-битный PGM. Кадр весит size^2 байт независимо от числа тел.
+ */
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stddef.h>
+
+#include "nbody.h"
+
+typedef enum {
+    RENDER_XY = 0,
+    RENDER_XZ = 1,
+    RENDER_YZ = 2
+} RenderAxis;
+
+typedef struct {
+    int size;               /* Ширина и высота кадра, пиксели */
+    RenderAxis axis;        /* Плоскость проекции */
+    double lo[2];           /* Угол видимой области (м) */
+    double scale;           /* Пикселей на метр */
+    int nthreads;
+    float *thread_img;      /* Пер-поточные изображения масс: nthreads * size^2 */
+    float *img;             /* Сумма по потокам */
+    unsigned char *pixels;  /* Кадр в логарифмической шкале */
+    double mass_unit;       /* Масса самого лёгкого тела - единица под логарифмом */
+    double log_max;         /* Верх шкалы, задаётся первым кадром */
+    char dir[512];          /* Каталог кадров */
+
+    int frames;
+    long long bytes;
+    double time;            /* Суммарное время рендеринга, с */
+} RenderState;
+
+/* Область кадра - квадрат вокруг начальных положений с полями 10%.
+ * Возвращает 0 при ошибке */
+int render_init(RenderState *s, const Body *bodies, int n, int size, RenderAxis axis,
+                const char *dir, int nthreads);
+
+/* Кадр <dir>/frame_<step>.pgm; возвращает 0 при ошибке записи */
+int render_frame(RenderState *s, const Body *bodies, int n, int step);
+
+void render_free(RenderState *s);
+
+const char *render_axis_name(RenderAxis axis);
+
+#endif /* RENDER_H */
@@ -3,7 +3,7 @@
 # Скрипт для запуска бенчмарков task2 OpenMP (N-body)
 
 echo "Компиляция task2 OpenMP версии..."
-gcc -fopenmp -O3 -o task2/scripts/task2 task2/scripts/task2.c -lm
+gcc -fopenmp -O3 -o task2/scripts/task2 task2/scripts/task2.c task2/scripts/nbody.c task2/scripts/wisdom_holman.c task2/scripts/test_particles.c task2/scripts/sfc_reorder.c task2/scripts/particle_mesh.c task2/scripts/cell_list.c task2/scripts/ewald.c task2/scripts/render.c task2/scripts/fof.c task2/scripts/traj_store.c task2/scripts/regularization.c common/perf_counters.c common/trace.c common/env_info.c common/rapl.c common/scaling.c common/peak.c common/roofline.c common/mem_profile.c -lm
 
 if [ $? -ne 0 ]; then
     echo "Ошибка компиляции! Убедитесь, что gcc и OpenMP доступны."
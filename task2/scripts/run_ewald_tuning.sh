@@ -0,0 +1,47 @@
+#!/bin/bash
+
+# Скрипт подбора параметра разделения Эвальда: время прямой и обратной частей и ошибка сил
+
+echo "Компиляция task2 OpenMP версии..."
+gcc -fopenmp -O3 -o task2/scripts/task2 task2/scripts/task2.c task2/scripts/nbody.c task2/scripts/wisdom_holman.c task2/scripts/test_particles.c task2/scripts/sfc_reorder.c task2/scripts/particle_mesh.c task2/scripts/cell_list.c task2/scripts/ewald.c task2/scripts/render.c task2/scripts/fof.c task2/scripts/traj_store.c task2/scripts/regularization.c common/perf_counters.c common/trace.c common/env_info.c common/rapl.c common/scaling.c common/peak.c common/roofline.c common/mem_profile.c -lm
+
+if [ $? -ne 0 ]; then
+    echo "Ошибка компиляции! Убедитесь, что gcc и OpenMP доступны."
+    exit 1
+fi
+
+echo "Компиляция успешна!"
+echo "======================================"
+echo "Подбор параметра разделения Эвальда..."
+echo "======================================"
+
+# Параметры тестирования
+BOX=1e12                           # ребро периодического куба (м)
+N=4000
+THREADS=4
+INPUT_FILE="task2/data/input/ewald_box_$N.txt"
+
+# Тела, равномерно распределённые по кубу, суммарная масса 1e30 кг
+if [ ! -f "$INPUT_FILE" ]; then
+    awk -v n=$N -v L=$BOX 'BEGIN {
+        srand(42); print n
+        for (i = 0; i < n; i++) {
+            printf "%.6e %.6e %.6e 0 0 0 %.6e\n", L * rand(), L * rand(), L * rand(), 1e30 / n
+        }
+    }' > "$INPUT_FILE"
+fi
+
+for TOL in 1e-3 1e-5 1e-7; do
+    for ALPHA in 8 12 16 24; do
+        echo ""
+        echo "tol = $TOL, alpha * box = $ALPHA..."
+        ./task2/scripts/task2 $THREADS 1 $INPUT_FILE 1 task2_ewald_tuning \
+            --dt 1 --ewald --box $BOX --ewald-alpha $ALPHA --ewald-tol $TOL --no-trajectory
+    done
+done
+
+echo ""
+echo "======================================"
+echo "Подбор завершён!"
+echo "Время частей и ошибка сил: task2/data/task2_ewald_tuning_ewald.csv"
+echo "======================================"
@@ -0,0 +1,44 @@
+#!/bin/bash
+
+# Скрипт сравнения интеграторов task2: ошибка энергии против времени счёта
+
+echo "Компиляция task2 OpenMP версии..."
+gcc -fopenmp -O3 -o task2/scripts/task2 task2/scripts/task2.c task2/scripts/nbody.c task2/scripts/wisdom_holman.c task2/scripts/test_particles.c task2/scripts/sfc_reorder.c task2/scripts/particle_mesh.c task2/scripts/cell_list.c task2/scripts/ewald.c task2/scripts/render.c task2/scripts/fof.c task2/scripts/traj_store.c task2/scripts/regularization.c common/perf_counters.c common/trace.c common/env_info.c common/rapl.c common/scaling.c common/peak.c common/roofline.c common/mem_profile.c -lm
+
+if [ $? -ne 0 ]; then
+    echo "Ошибка компиляции! Убедитесь, что gcc и OpenMP доступны."
+    exit 1
+fi
+
+echo "Компиляция успешна!"
+echo "======================================"
+echo "Сравнение интеграторов Euler и Wisdom-Holman..."
+echo "======================================"
+
+# Параметры тестирования
+TEND=100000.0                      # время симуляции (около 1/10 оборота внутренних тел)
+INPUT_FILE="task2/data/input/three_body.txt"
+THREADS=4
+NUM_RUNS=1
+
+# Метод Эйлера
+for DT in 1000 100 10; do
+    echo ""
+    echo "Euler, dt = $DT..."
+    ./task2/scripts/task2 $THREADS $TEND $INPUT_FILE $NUM_RUNS task2_integrators \
+        --integrator euler --dt $DT --no-trajectory --energy-log
+done
+
+# Уиздом-Холман
+for DT in 10000 1000 100; do
+    echo ""
+    echo "Wisdom-Holman, dt = $DT..."
+    ./task2/scripts/task2 $THREADS $TEND $INPUT_FILE $NUM_RUNS task2_integrators \
+        --integrator wh --dt $DT --no-trajectory --energy-log
+done
+
+echo ""
+echo "======================================"
+echo "Сравнение завершено!"
+echo "Ошибка энергии и время: task2/data/task2_integrators_energy.csv"
+echo "======================================"
@@ -0,0 +1,50 @@
+#!/bin/bash
+
+# Скрипт сравнения метода частица-сетка (PM) с прямым расчётом сил при росте N
+
+echo "Компиляция task2 OpenMP версии..."
+gcc -fopenmp -O3 -o task2/scripts/task2 task2/scripts/task2.c task2/scripts/nbody.c task2/scripts/wisdom_holman.c task2/scripts/test_particles.c task2/scripts/sfc_reorder.c task2/scripts/particle_mesh.c task2/scripts/cell_list.c task2/scripts/ewald.c task2/scripts/render.c task2/scripts/fof.c task2/scripts/traj_store.c task2/scripts/regularization.c common/perf_counters.c common/trace.c common/env_info.c common/rapl.c common/scaling.c common/peak.c common/roofline.c common/mem_profile.c -lm
+
+if [ $? -ne 0 ]; then
+    echo "Ошибка компиляции! Убедитесь, что gcc и OpenMP доступны."
+    exit 1
+fi
+
+echo "Компиляция успешна!"
+echo "======================================"
+echo "Сравнение PM и прямого расчёта сил..."
+echo "======================================"
+
+# Параметры тестирования
+BOX=1e12                           # ребро периодического куба (м)
+GRID=64                            # узлов сетки PM по оси
+THREADS=4
+INPUT_DIR="task2/data/input"
+
+# Однородный шар радиуса BOX/8 в центре куба, суммарная масса 1e30 кг
+for N in 1000 4000 16000 64000 262144; do
+    INPUT_FILE="$INPUT_DIR/pm_sphere_$N.txt"
+    if [ ! -f "$INPUT_FILE" ]; then
+        awk -v n=$N -v L=$BOX 'BEGIN {
+            srand(42); print n; R = L / 8; c = L / 2; i = 0
+            while (i < n) {
+                x = 2 * rand() - 1; y = 2 * rand() - 1; z = 2 * rand() - 1
+                if (x*x + y*y + z*z <= 1) {
+                    printf "%.6e %.6e %.6e 0 0 0 %.6e\n", c + R*x, c + R*y, c + R*z, 1e30 / n
+                    i++
+                }
+            }
+        }' > "$INPUT_FILE"
+    fi
+
+    echo ""
+    echo "N = $N..."
+    ./task2/scripts/task2 $THREADS 1 $INPUT_FILE 1 task2_pm_scaling \
+        --dt 1 --pm $GRID --box $BOX --no-trajectory
+done
+
+echo ""
+echo "======================================"
+echo "Сравнение завершено!"
+echo "Время стадий PM и прямого расчёта: task2/data/task2_pm_scaling_pm.csv"
+echo "======================================"
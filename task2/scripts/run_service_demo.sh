@@ -0,0 +1,64 @@
+#!/bin/bash
+
+# Скрипт проверки сервиса симуляций: пакет заданий через локальный сокет,
+# время ожидания в очереди и производительность каждого задания
+
+SERVICE_SOURCES="task2/scripts/nbody_service.c task2/scripts/libnbody.c task2/scripts/nbody.c task2/scripts/wisdom_holman.c task2/scripts/test_particles.c task2/scripts/particle_mesh.c task2/scripts/cell_list.c task2/scripts/ewald.c common/trace.c"
+
+echo "Компиляция сервиса и клиента..."
+gcc -fopenmp -O3 -pthread -o task2/scripts/nbody_service $SERVICE_SOURCES -lm && \
+    gcc -O3 -o task2/scripts/nbody_client task2/scripts/nbody_client.c
+
+if [ $? -ne 0 ]; then
+    echo "Ошибка компиляции! Убедитесь, что gcc и OpenMP доступны."
+    exit 1
+fi
+
+echo "Компиляция успешна!"
+echo "======================================"
+echo "Пакет заданий через сервис..."
+echo "======================================"
+
+# Параметры тестирования
+SOCKET=/tmp/nbody_service_$$.sock
+BUDGET=4                           # потоков OpenMP на весь сервис
+INPUT_FILE="task2/data/input/three_body.txt"
+CSV_FILE="task2/data/task2_service_jobs.csv"
+
+./task2/scripts/nbody_service $SOCKET $BUDGET &
+SERVICE_PID=$!
+for i in $(seq 50); do
+    [ -S $SOCKET ] && break
+    sleep 0.1
+done
+
+# Задания с разными бюджетами потоков: очередь делит между ними бюджет сервиса
+LOG_DIR=$(mktemp -d)
+JOB=0
+CLIENTS=()
+for THREADS in 4 2 2 1 1 1 1; do
+    for INTEGRATOR in euler wh; do
+        JOB=$((JOB + 1))
+        ./task2/scripts/nbody_client $SOCKET submit $THREADS 100000 $INPUT_FILE \
+            --dt 100 --integrator $INTEGRATOR --progress 500 > $LOG_DIR/job_$JOB.log &
+        CLIENTS+=($!)
+    done
+done
+wait "${CLIENTS[@]}"
+
+./task2/scripts/nbody_client $SOCKET stats
+./task2/scripts/nbody_client $SOCKET shutdown
+wait $SERVICE_PID
+
+# Строки DONE -> CSV
+if [ ! -f $CSV_FILE ]; then
+    echo "id,steps,wait,run,steps_per_sec,interactions_per_sec,energy_error" > $CSV_FILE
+fi
+cat $LOG_DIR/job_*.log | grep '^DONE' | sed -e 's/^DONE //' -e 's/[a-z_]*=//g' -e 's/ /,/g' | sort -t, -k1 -n >> $CSV_FILE
+rm -rf $LOG_DIR
+
+echo ""
+echo "======================================"
+echo "Проверка завершена!"
+echo "Ожидание и производительность заданий: $CSV_FILE"
+echo "======================================"
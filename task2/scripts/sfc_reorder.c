@@ -0,0 +1,228 @@
+/* sfc_reorder.c
+ * Переупорядочивание тел вдоль кривой Мортона или Гильберта
+ */
+
+#include "sfc_reorder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <omp.h>
+
+const char *sfc_curve_name(SfcCurve curve) {
+    return curve == SFC_HILBERT ? "hilbert" : "morton";
+}
+
+/* --- Ключи кривых --- */
+
+/* Раздвигает 21 бит так, чтобы между ними было по два нулевых бита */
+static inline uint64_t spread_bits(uint32_t v) {
+    uint64_t x = v & 0x1fffff;
+    x = (x | (x << 32)) & 0x001f00000000ffffULL;
+    x = (x | (x << 16)) & 0x001f0000ff0000ffULL;
+    x = (x | (x << 8))  & 0x100f00f00f00f00fULL;
+    x = (x | (x << 4))  & 0x10c30c30c30c30c3ULL;
+    x = (x | (x << 2))  & 0x1249249249249249ULL;
+    return x;
+}
+
+static inline uint64_t interleave3(uint32_t a, uint32_t b, uint32_t c) {
+    return (spread_bits(a) << 2) | (spread_bits(b) << 1) | spread_bits(c);
+}
+
+/* Ключ Гильберта: преобразование координат в "транспонированный" индекс
+ * (алгоритм Скиллинга) и чередование бит */
+static inline uint64_t hilbert_key(uint32_t x, uint32_t y, uint32_t z) {
+    uint32_t X[3] = {x, y, z};
+    uint32_t M = 1u << (SFC_BITS - 1);
+
+    for (uint32_t Q = M; Q > 1; Q >>= 1) {
+        uint32_t P = Q - 1;
+        for (int i = 0; i < 3; i++) {
+            if (X[i] & Q) {
+                X[0] ^= P;
+            } else {
+                uint32_t t = (X[0] ^ X[i]) & P;
+                X[0] ^= t;
+                X[i] ^= t;
+            }
+        }
+    }
+
+    /* Код Грея */
+    X[1] ^= X[0];
+    X[2] ^= X[1];
+    uint32_t t = 0;
+    for (uint32_t Q = M; Q > 1; Q >>= 1) {
+        if (X[2] & Q) t ^= Q - 1;
+    }
+    X[0] ^= t; X[1] ^= t; X[2] ^= t;
+
+    return interleave3(X[0], X[1], X[2]);
+}
+
+static void compute_keys(SfcReorder *s, const Body *bodies) {
+    int n = s->n;
+    double xmin = DBL_MAX, ymin = DBL_MAX, zmin = DBL_MAX;
+    double xmax = -DBL_MAX, ymax = -DBL_MAX, zmax = -DBL_MAX;
+
+    #pragma omp parallel for reduction(min:xmin, ymin, zmin) reduction(max:xmax, ymax, zmax)
+    for (int i = 0; i < n; i++) {
+        if (bodies[i].x < xmin) xmin = bodies[i].x;
+        if (bodies[i].y < ymin) ymin = bodies[i].y;
+        if (bodies[i].z < zmin) zmin = bodies[i].z;
+        if (bodies[i].x > xmax) xmax = bodies[i].x;
+        if (bodies[i].y > ymax) ymax = bodies[i].y;
+        if (bodies[i].z > zmax) zmax = bodies[i].z;
+    }
+
+    /* Общий масштаб по всем осям - куб, описанный вокруг системы */
+    double extent = xmax - xmin;
+    if (ymax - ymin > extent) extent = ymax - ymin;
+    if (zmax - zmin > extent) extent = zmax - zmin;
+    double scale = (extent > 0.0) ? (double)((1u << SFC_BITS) - 1) / extent : 0.0;
+
+    SfcCurve curve = s->curve;
+    uint64_t *keys = s->keys;
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        uint32_t cx = (uint32_t)((bodies[i].x - xmin) * scale);
+        uint32_t cy = (uint32_t)((bodies[i].y - ymin) * scale);
+        uint32_t cz = (uint32_t)((bodies[i].z - zmin) * scale);
+        keys[i] = (curve == SFC_HILBERT) ? hilbert_key(cx, cy, cz)
+                                         : interleave3(cx, cy, cz);
+    }
+}
+
+/* --- Параллельная поразрядная сортировка (LSD, устойчивая) --- */
+/* Каждый поток строит гистограмму своего блока, смещения считаются
+ * в порядке (разряд, поток), что сохраняет устойчивость. Проходы,
+ * в которых у всех ключей одна цифра, пропускаются. */
+static void radix_sort(SfcReorder *s) {
+    int n = s->n;
+    uint64_t *keys = s->keys, *keys_tmp = s->keys_tmp;
+    int *idx = s->idx, *idx_tmp = s->idx_tmp;
+    int *hist = s->hist;
+    int skip = 0;
+
+    for (int i = 0; i < n; i++) idx[i] = i;
+
+    #pragma omp parallel num_threads(s->nthreads)
+    {
+        int tid = omp_get_thread_num();
+        int nt = omp_get_num_threads();
+        int lo = (int)((long long)n * tid / nt);
+        int hi = (int)((long long)n * (tid + 1) / nt);
+        int *h = hist + (size_t)tid * SFC_RADIX;
+
+        for (int shift = 0; shift < 3 * SFC_BITS; shift += SFC_RADIX_BITS) {
+            memset(h, 0, SFC_RADIX * sizeof(int));
+            for (int i = lo; i < hi; i++) {
+                h[(keys[i] >> shift) & (SFC_RADIX - 1)]++;
+            }
+            #pragma omp barrier
+
+            #pragma omp single
+            {
+                int digit0 = (int)((keys[0] >> shift) & (SFC_RADIX - 1));
+                int count0 = 0;
+                for (int t = 0; t < nt; t++) count0 += hist[t * SFC_RADIX + digit0];
+                skip = (count0 == n);
+
+                int offset = 0;
+                for (int d = 0; d < SFC_RADIX && !skip; d++) {
+                    for (int t = 0; t < nt; t++) {
+                        int c = hist[t * SFC_RADIX + d];
+                        hist[t * SFC_RADIX + d] = offset;
+                        offset += c;
+                    }
+                }
+            }
+
+            if (!skip) {
+                for (int i = lo; i < hi; i++) {
+                    int pos = h[(keys[i] >> shift) & (SFC_RADIX - 1)]++;
+                    keys_tmp[pos] = keys[i];
+                    idx_tmp[pos] = idx[i];
+                }
+            }
+            #pragma omp barrier
+
+            #pragma omp single
+            {
+                if (!skip) {
+                    uint64_t *tk = keys; keys = keys_tmp; keys_tmp = tk;
+                    int *ti = idx; idx = idx_tmp; idx_tmp = ti;
+                }
+            }
+        }
+    }
+
+    s->keys = keys; s->keys_tmp = keys_tmp;
+    s->idx = idx; s->idx_tmp = idx_tmp;
+}
+
+void sfc_reorder(SfcReorder *s, Body *bodies) {
+    double start = omp_get_wtime();
+    int n = s->n;
+
+    compute_keys(s, bodies);
+    radix_sort(s);
+
+    /* Перестановка тел и накопление перестановки к исходному порядку */
+    const int *idx = s->idx;
+    #pragma omp parallel for schedule(static)
+    for (int k = 0; k < n; k++) {
+        s->scratch[k] = bodies[idx[k]];
+        s->perm_tmp[k] = s->perm[idx[k]];
+    }
+    memcpy(bodies, s->scratch, (size_t)n * sizeof(Body));
+    int *tp = s->perm; s->perm = s->perm_tmp; s->perm_tmp = tp;
+
+    s->reorders++;
+    s->time += omp_get_wtime() - start;
+}
+
+void sfc_restore(const SfcReorder *s, const Body *sorted, Body *out) {
+    const int *perm = s->perm;
+    #pragma omp parallel for schedule(static)
+    for (int k = 0; k < s->n; k++) {
+        out[perm[k]] = sorted[k];
+    }
+}
+
+int sfc_init(SfcReorder *s, int n, SfcCurve curve, int nthreads) {
+    memset(s, 0, sizeof(*s));
+    s->n = n;
+    s->nthreads = nthreads;
+    s->curve = curve;
+
+    s->keys = (uint64_t*)malloc((size_t)n * sizeof(uint64_t));
+    s->keys_tmp = (uint64_t*)malloc((size_t)n * sizeof(uint64_t));
+    s->idx = (int*)malloc((size_t)n * sizeof(int));
+    s->idx_tmp = (int*)malloc((size_t)n * sizeof(int));
+    s->perm = (int*)malloc((size_t)n * sizeof(int));
+    s->perm_tmp = (int*)malloc((size_t)n * sizeof(int));
+    s->scratch = (Body*)malloc((size_t)n * sizeof(Body));
+    s->hist = (int*)malloc((size_t)nthreads * SFC_RADIX * sizeof(int));
+    if (!s->keys || !s->keys_tmp || !s->idx || !s->idx_tmp ||
+        !s->perm || !s->perm_tmp || !s->scratch || !s->hist) {
+        fprintf(stderr, "Error: Failed to allocate reorder buffers (n=%d)\n", n);
+        sfc_free(s);
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++) s->perm[i] = i;
+    return 1;
+}
+
+void sfc_free(SfcReorder *s) {
+    free(s->keys); free(s->keys_tmp);
+    free(s->idx); free(s->idx_tmp);
+    free(s->perm); free(s->perm_tmp);
+    free(s->scratch);
+    free(s->hist);
+    memset(s, 0, sizeof(*s));
+}
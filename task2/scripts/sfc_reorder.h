@@ -0,0 +1,51 @@
+/* sfc_reorder.h
+ * Переупорядочивание тел вдоль кривой, заполняющей пространство (Мортон / Гильберт).
+ * Близкие в пространстве тела становятся соседями в памяти. Ключи сортируются
+ * параллельной поразрядной сортировкой; перестановка хранится, чтобы вывод
+ * оставался в исходном порядке тел.
+ */
+
+#ifndef SFC_REORDER_H
+#define SFC_REORDER_H
+
+#include <stdint.h>
+
+#include "nbody.h"
+
+#define SFC_BITS 21            /* Бит на координату: 3 * 21 = 63 бита ключа */
+#define SFC_RADIX_BITS 8       /* Бит на проход поразрядной сортировки */
+#define SFC_RADIX (1 << SFC_RADIX_BITS)
+
+typedef enum {
+    SFC_MORTON = 0,
+    SFC_HILBERT = 1
+} SfcCurve;
+
+typedef struct {
+    int n;
+    int nthreads;
+    SfcCurve curve;
+    uint64_t *keys, *keys_tmp;  /* Ключи и буфер сортировки */
+    int *idx, *idx_tmp;         /* Текущая позиция тела для каждого места после сортировки */
+    int *perm;                  /* perm[k] - исходный номер тела, стоящего на месте k */
+    int *perm_tmp;
+    Body *scratch;              /* Буфер для перестановки тел */
+    int *hist;                  /* Пер-поточные гистограммы: nthreads * SFC_RADIX */
+    int reorders;               /* Число выполненных переупорядочиваний */
+    double time;                /* Суммарное время переупорядочивания, с */
+} SfcReorder;
+
+/* Выделение буферов; перестановка - тождественная. Возвращает 0 при ошибке */
+int sfc_init(SfcReorder *s, int n, SfcCurve curve, int nthreads);
+
+/* Сортировка тел по ключу кривой; перестановка накапливается */
+void sfc_reorder(SfcReorder *s, Body *bodies);
+
+/* Копия тел в исходном порядке: out[perm[k]] = sorted[k] */
+void sfc_restore(const SfcReorder *s, const Body *sorted, Body *out);
+
+void sfc_free(SfcReorder *s);
+
+const char *sfc_curve_name(SfcCurve curve);
+
+#endif /* SFC_REORDER_H */
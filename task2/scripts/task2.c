@@ -15,14 +15,29 @@
 #include <math.h>
 #include <time.h>
 
-/* Физические константы */
-#define G 6.67430e-11  /* Гравитационная постоянная (м^3 кг^-1 с^-2) */
+#include "nbody.h"
+#include "wisdom_holman.h"
+#include "test_particles.h"
+#include "sfc_reorder.h"
+#include "particle_mesh.h"
+#include "ewald.h"
+#include "render.h"
+#include "fof.h"
+#include "traj_store.h"
+#include "regularization.h"
+#include "../../common/perf_counters.h"
+#include "../../common/env_info.h"
+#include "../../common/mem_profile.h"
+#include "../../common/rapl.h"
+#include "../../common/peak.h"
+#include "../../common/roofline.h"
+#include "../../common/scaling.h"
+#include "../../common/trace.h"
+
+/* Параметры симуляции */
 #define DT 0.01        /* Шаг по времени (секунды) - можно менять для точности */
 #define OUTPUT_STEP 10 /* Записывать каждый N-ый шаг (для уменьшения размера файла) */
 
-/* Мелкая константа для предотвращения деления на ноль при близких вкладах */
-#define SOFTENING 1e-9
-
 /* --- Утилиты работы с файловой системой --- */
 void ensure_dir_exists(const char *path) {
     char tmp[512];
@@ -65,13 +80,6 @@ void get_cpu_info(char *cpu_info, size_t size) {
     snprintf(cpu_info, size, "Unknown CPU");
 }
 
-/* --- Структура для хранения состояния частицы --- */
-typedef struct {
-    double x, y, z;     /* Позиция */
-    double vx, vy, vz;  /* Скорость */
-    double mass;        /* Масса */
-} Body;
-
 /* --- Структура для хранения метрик производительности --- */
 typedef struct {
     int nthreads;
@@ -85,6 +93,11 @@ typedef struct {
     double avg_time;
     int num_runs;
     double dt;
+    double interactions;            /* Взаимодействий пар за запуск (0 - силы не парные) */
+    double flops;                   /* Операций double ядер сил и обновления за запуск */
+    double bytes;                   /* Байтов загрузок и записей тех же ядер за запуск */
+    const ScalingPoint *scaling;    /* Точка масштабирования (--sweep), NULL - обычный запуск */
+    const MemProfile *memory;       /* Память по фазам, NULL - не снималась */
 } PerformanceMetrics;
 
 /* --- Чтение входных данных из файла --- */
@@ -124,155 +137,209 @@ int read_bodies(const char *filename, Body **bodies, int *n) {
     return 1;
 }
 
-/* --- Вычисление сил между всеми телами --- */
-/* Использует третий закон Ньютона: Fpq = -Fqp для оптимизации */
-void compute_forces(Body *bodies, int n, double *fx, double *fy, double *fz,
-                    double *fx_all, double *fy_all, double *fz_all, int nthreads) {
-
-    /* Обнуляем глобальные силы (глобальный буфер результата) */
+/* --- Запись состояния в CSV файл --- */
+void write_snapshot(FILE *f, double t, const Body *bodies, int n) {
+    TRACE_BEGIN("write_snapshot");
+    fprintf(f, "%.6f", t);
     for (int i = 0; i < n; i++) {
-        fx[i] = 0.0;
-        fy[i] = 0.0;
-        fz[i] = 0.0;
+        fprintf(f, ",%.15f,%.15f,%.15f", bodies[i].x, bodies[i].y, bodies[i].z);
     }
+    fprintf(f, "\n");
+    TRACE_END("write_snapshot");
+}
 
-    size_t per_thread = (size_t)n;
-
-    /* Однократная параллельная область: вычисление + редукция внутри */
-    #pragma omp parallel
-    {
-        int tid = omp_get_thread_num();
-        double *fx_loc = fx_all + (size_t)tid * per_thread;
-        double *fy_loc = fy_all + (size_t)tid * per_thread;
-        double *fz_loc = fz_all + (size_t)tid * per_thread;
-
-        /* Сбрасываем локальную область */
-        memset(fx_loc, 0, per_thread * sizeof(double));
-        memset(fy_loc, 0, per_thread * sizeof(double));
-        memset(fz_loc, 0, per_thread * sizeof(double));
-
-        /* Вычисляем вклады пар (i,j) в локальные буферы — третий закон Ньютона соблюдается */
-        #pragma omp for schedule(static)
-        for (int i = 0; i < n - 1; i++) {
-            double xi = bodies[i].x;
-            double yi = bodies[i].y;
-            double zi = bodies[i].z;
-            double mi = bodies[i].mass;
-
-            for (int j = i + 1; j < n; j++) {
-                double dx = bodies[j].x - xi;
-                double dy = bodies[j].y - yi;
-                double dz = bodies[j].z - zi;
-
-                double r_sq = dx*dx + dy*dy + dz*dz + SOFTENING;
-                double inv_r = 1.0 / sqrt(r_sq);
-                double inv_r3 = inv_r * inv_r * inv_r;
-
-                double force_factor = G * mi * bodies[j].mass * inv_r3;
-
-                double Fx = force_factor * dx;
-                double Fy = force_factor * dy;
-                double Fz = force_factor * dz;
-
-                fx_loc[i] += Fx;
-                fy_loc[i] += Fy;
-                fz_loc[i] += Fz;
-
-                fx_loc[j] -= Fx;
-                fy_loc[j] -= Fy;
-                fz_loc[j] -= Fz;
-            }
-        } /* end omp for (compute) */
-
-        /* Барьер — все потоки закончили записывать в свои локальные буферы */
-        #pragma omp barrier
-
-        #pragma omp for schedule(static)
-        for (int i = 0; i < n; i++) {
-            double sfx = 0.0, sfy = 0.0, sfz = 0.0;
-            size_t base = (size_t)i;
-            for (int t = 0; t < nthreads; t++) {
-                size_t idx = (size_t)t * per_thread + base;
-                sfx += fx_all[idx];
-                sfy += fy_all[idx];
-                sfz += fz_all[idx];
-            }
-            fx[i] = sfx;
-            fy[i] = sfy;
-            fz[i] = sfz;
-        }
-    } 
+/* --- Запись метрик производительности в CSV --- */
+void write_performance_metrics(const char *csv_dir, const char *prefix, PerformanceMetrics *metrics,
+                                const char *cpu_info, const MachinePeak *peak, const EnvInfo *env) {
+    char fname[512];
+    snprintf(fname, sizeof(fname), "%s/%s_performance.csv", csv_dir, prefix);
+    
+    /* Заголовок пишется в новый файл; файл со старой схемой сохраняется под другим именем */
+    FILE *f = env_csv_append(fname, "timestamp,cpu_info,nthreads,nbodies,tend,dt,total_steps,output_steps,"
+                         "computation_time,min_time,max_time,avg_time,num_runs,"
+                         "interactions,ginteractions_per_s,gflops,peak_gflops,peak_fraction,"
+                         SCALING_CSV_HEADER "," MEM_CSV_HEADER "," ENV_CSV_HEADER);
+    if (!f) {
+        fprintf(stderr, "Cannot open %s for writing\n", fname);
+        return;
+    }
+    
+    time_t now = time(NULL);
+    char timestamp[64];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+    
+    fprintf(f, "%s,\"%s\",%d,%d,%.6f,%.6f,%d,%d,%.6f,%.6f,%.6f,%.6f,%d,",
+            timestamp, cpu_info,
+            metrics->nthreads, metrics->nbodies, metrics->tend, metrics->dt,
+            metrics->total_steps, metrics->output_steps,
+            metrics->computation_time, metrics->min_time, metrics->max_time,
+            metrics->avg_time, metrics->num_runs);
+    if (metrics->interactions > 0.0 && metrics->avg_time > 0.0) {
+        double gflops = metrics->flops / metrics->avg_time * 1e-9;
+        fprintf(f, "%.0f,%.6f,%.6f,", metrics->interactions, metrics->interactions / metrics->avg_time * 1e-9, gflops);
+        if (peak->gflops > 0.0) fprintf(f, "%.3f,%.6f,", peak->gflops, peak_fraction(peak, gflops));
+        else fprintf(f, ",,");
+    } else {
+        fprintf(f, ",,,,,");
+    }
+    scaling_csv_write(f, metrics->scaling);
+    fputc(',', f);
+    mem_csv_write(f, metrics->memory);
+    fputc(',', f);
+    env_csv_write(f, env);
+    fprintf(f, "\n");
+    
+    fclose(f);
+    printf("Performance metrics written to %s\n", fname);
 }
 
+/* --- Параметры запуска (опции вида --name [value]) --- */
+typedef enum {
+    INTEGRATOR_EULER = 0,   /* Метод Эйлера 1-го порядка */
+    INTEGRATOR_WH = 1       /* Симплектический интегратор Уиздома-Холмана */
+} Integrator;
 
+typedef struct {
+    Integrator integrator;
+    double dt;              /* Шаг по времени */
+    int write_trajectory;   /* Записывать result.csv */
+    int energy_log;         /* Добавлять строку в <prefix>_energy.csv */
+    double passive_mass;    /* Порог массы пассивных тел (0 - режим выключен) */
+    int reorder_every;      /* Переупорядочивание по кривой каждые K шагов (0 - выключено) */
+    SfcCurve sfc_curve;     /* Кривая Мортона или Гильберта */
+    int pm_grid;            /* Узлов сетки PM по оси (0 - прямой расчёт сил) */
+    double pm_box;          /* Ребро периодического куба PM и Эвальда (0 - по начальным положениям) */
+    int ewald;              /* Периодическая гравитация суммированием Эвальда */
+    double ewald_alpha;     /* Параметр разделения alpha * box (0 - выбор по N) */
+    double ewald_tol;       /* Допуск погрешности частей Эвальда */
+    int render_every;       /* Кадр проекции плотности каждые K шагов (0 - выключено) */
+    int render_size;        /* Размер кадра, пиксели */
+    RenderAxis render_axis; /* Плоскость проекции */
+    int fof_every;          /* Каталог групп друзей-друзей каждые K шагов (0 - выключено) */
+    double fof_link;        /* Длина связи в долях среднего межчастичного расстояния */
+    int fof_min;            /* Минимальное число тел группы в каталоге */
+    int deterministic;      /* Силы не зависят от числа потоков (compute_forces_ordered) */
+    int columnar;           /* Столбцовое хранилище траекторий trajectory.nbt */
+    double reg_radius;      /* Радиус регуляризации тесных пар, м (0 - выключено) */
+    int rapl;               /* Энергия процессора и памяти по счётчикам RAPL */
+    int sweep_threads[SCALING_MAX_POINTS];  /* Числа потоков для --sweep */
+    int sweep_count;        /* 0 - один запуск с nthreads потоками */
+} SimOptions;
 
-/* --- Обновление позиций и скоростей методом Эйлера --- */
-void update_bodies(Body *bodies, int n, double *fx, double *fy, double *fz, double dt) {
-    #pragma omp parallel for schedule(static)
-    for (int i = 0; i < n; i++) {
-        /* Обновляем позиции: x^n = x^(n-1) + v^(n-1) * dt */
-        bodies[i].x += bodies[i].vx * dt;
-        bodies[i].y += bodies[i].vy * dt;
-        bodies[i].z += bodies[i].vz * dt;
+const char *integrator_name(Integrator integrator) {
+    return integrator == INTEGRATOR_WH ? "wh" : "euler";
+}
 
-        /* Обновляем скорости: v^n = v^(n-1) + F^(n-1)/m * dt */
-        bodies[i].vx += (fx[i] / bodies[i].mass) * dt;
-        bodies[i].vy += (fy[i] / bodies[i].mass) * dt;
-        bodies[i].vz += (fz[i] / bodies[i].mass) * dt;
-    }
+/* Силы считаются прямым перебором пар (compute_forces или compute_forces_ordered) */
+int direct_forces(const SimOptions *opts) {
+    return opts->integrator == INTEGRATOR_EULER && opts->passive_mass <= 0.0 &&
+           opts->pm_grid == 0 && !opts->ewald;
 }
 
-/* --- Запись состояния в CSV файл --- */
-void write_snapshot(FILE *f, double t, Body *bodies, int n) {
-    fprintf(f, "%.6f", t);
-    for (int i = 0; i < n; i++) {
-        fprintf(f, ",%.15f,%.15f,%.15f", bodies[i].x, bodies[i].y, bodies[i].z);
-    }
-    fprintf(f, "\n");
+/* --- Работа одного запуска: взаимодействия пар и операции double ---
+ * Только для прямого расчёта сил; у PM, Эвальда, WH и пробных частиц - нули */
+void count_work(const SimOptions *opts, PerformanceMetrics *metrics) {
+    metrics->interactions = 0.0;
+    metrics->flops = 0.0;
+    metrics->bytes = 0.0;
+    if (!direct_forces(opts)) return;
+    double n = metrics->nbodies;
+    double pairs = n * (n - 1) / 2.0;
+    double pair_flops = opts->deterministic ? ORDERED_PAIR_FLOPS * n * n : PAIR_FLOPS * pairs;
+    /* Байты - O(n) за шаг на поток: внутренние циклы пар работают в L1 */
+    double threads = metrics->nthreads;
+    double force_bytes = opts->deterministic
+                         ? (BODY_STREAM_BYTES * threads + FORCE_BYTES) * n
+                         : ((BODY_STREAM_BYTES + FORCE_BUFFER_BYTES) * threads + FORCE_BYTES) * n;
+    metrics->interactions = pairs * metrics->total_steps;
+    metrics->flops = (pair_flops + UPDATE_FLOPS * n) * metrics->total_steps;
+    metrics->bytes = (force_bytes + UPDATE_BYTES * n) * metrics->total_steps;
 }
 
-/* --- Запись метрик производительности в CSV --- */
-void write_performance_metrics(const char *csv_dir, const char *prefix,
-                                PerformanceMetrics *metrics, const char *cpu_info) {
+/* --- Запись ошибки энергии в CSV (сравнение интеграторов) --- */
+void write_energy_log(const char *csv_dir, const char *prefix, const SimOptions *opts,
+                      PerformanceMetrics *metrics, double energy_start, double energy_end) {
     char fname[512];
-    snprintf(fname, sizeof(fname), "%s/%s_performance.csv", csv_dir, prefix);
-    
+    snprintf(fname, sizeof(fname), "%s/%s_energy.csv", csv_dir, prefix);
+
     int file_exists = 0;
     FILE *test = fopen(fname, "r");
     if (test) {
         file_exists = 1;
         fclose(test);
     }
-    
+
     FILE *f = fopen(fname, "a");
     if (!f) {
         fprintf(stderr, "Cannot open %s for writing\n", fname);
         return;
     }
-    
+
     if (!file_exists) {
-        fprintf(f, "timestamp,cpu_info,nthreads,nbodies,tend,dt,total_steps,output_steps,");
-        fprintf(f, "computation_time,min_time,max_time,avg_time,num_runs\n");
+        fprintf(f, "timestamp,integrator,nthreads,nbodies,tend,dt,total_steps,");
+        fprintf(f, "avg_time,energy_start,energy_end,rel_energy_error\n");
     }
-    
+
     time_t now = time(NULL);
     char timestamp[64];
     strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
-    
-    fprintf(f, "%s,\"%s\",%d,%d,%.6f,%.6f,%d,%d,%.6f,%.6f,%.6f,%.6f,%d\n",
-            timestamp, cpu_info,
+
+    fprintf(f, "%s,%s,%d,%d,%.6f,%.6f,%d,%.6f,%.15e,%.15e,%.6e\n",
+            timestamp, integrator_name(opts->integrator),
             metrics->nthreads, metrics->nbodies, metrics->tend, metrics->dt,
-            metrics->total_steps, metrics->output_steps,
-            metrics->computation_time, metrics->min_time, metrics->max_time,
-            metrics->avg_time, metrics->num_runs);
-    
+            metrics->total_steps, metrics->avg_time, energy_start, energy_end,
+            fabs((energy_end - energy_start) / energy_start));
+
     fclose(f);
-    printf("Performance metrics written to %s\n", fname);
+    printf("Energy error written to %s\n", fname);
+}
+
+/* --- Энергия запусков по RAPL ---
+ * Единица работы - взаимодействие пары при прямом расчёте сил,
+ * иначе (PM, Эвальд, WH, пробные частицы) - шаг одного тела */
+void write_rapl_report(const char *csv_dir, const char *prefix, const SimOptions *opts,
+                       const RaplCounters *rapl, const PerformanceMetrics *metrics, const EnvInfo *env) {
+    int direct = direct_forces(opts);
+    double body_steps = (double)metrics->nbodies * metrics->total_steps * metrics->num_runs;
+    double work = direct ? body_steps * (metrics->nbodies - 1) / 2.0 : body_steps;
+    const char *unit = direct ? "pair interaction" : "body-step";
+    rapl_print(rapl, work, unit);
+    if (!rapl->available) return;
+
+    char fname[512];
+    snprintf(fname, sizeof(fname), "%s/%s_rapl.csv", csv_dir, prefix);
+    FILE *test = fopen(fname, "r");
+    int file_exists = (test != NULL);
+    if (test) fclose(test);
+
+    FILE *f = fopen(fname, "a");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s for writing\n", fname);
+        return;
+    }
+    if (!file_exists) {
+        fprintf(f, "nthreads,nbodies,total_steps,num_runs,unit,work,seconds,package_j,dram_j,package_w,"
+                   "joules_per_unit,env_hash\n");
+    }
+    double package = rapl_joules(rapl, RAPL_PACKAGE);
+    double dram = rapl_joules(rapl, RAPL_DRAM);
+    double total = package + (dram > 0.0 ? dram : 0.0);
+    fprintf(f, "%d,%d,%d,%d,%s,%.0f,%.6f,%.3f,%.3f,%.3f,%.6e,%s\n",
+            metrics->nthreads, metrics->nbodies, metrics->total_steps, metrics->num_runs,
+            direct ? "pair" : "body_step", work, rapl->seconds, package, dram,
+            rapl->seconds > 0.0 ? package / rapl->seconds : 0.0, total / work, env->hash);
+    fclose(f);
+    printf("Energy written to %s\n", fname);
 }
 
 /* --- Основная функция симуляции --- */
+/* render - кадры плотности каждые opts->render_every шагов (NULL - без рендеринга),
+ * fof - каталоги групп каждые opts->fof_every шагов (NULL - без поиска групп),
+ * store - столбцовое хранилище кадров с шагом OUTPUT_STEP (NULL - без хранилища),
+ * reg - регуляризация тесных пар в методе Эйлера (NULL - без регуляризации) */
 double simulate_nbody(Body *bodies, int n, double tend, double dt, 
-                      const char *output_file, int should_write) {
+                      const char *output_file, int should_write, const SimOptions *opts,
+                      RenderState *render, FofState *fof, TrajStore *store, RegState *reg) {
     int total_steps = (int)(tend / dt);
     
     /* Массивы для хранения сил */
@@ -323,29 +390,169 @@ double simulate_nbody(Body *bodies, int n, double tend, double dt,
         return -1.0;
     }
 
+    /* Состояние интегратора Уиздома-Холмана (гелиоцентрические координаты) */
+    WHState wh;
+    int use_wh = (opts->integrator == INTEGRATOR_WH);
+    if (use_wh && !wh_init(&wh, bodies, n, nthreads_runtime)) {
+        free(fx_all); free(fy_all); free(fz_all);
+        free(fx); free(fy); free(fz);
+        if (f) fclose(f);
+        return -1.0;
+    }
+
+    /* Разделение на активные и пассивные тела */
+    TestParticleState tp;
+    int use_tp = (opts->passive_mass > 0.0);
+    if (use_tp && !tp_init(&tp, bodies, n, opts->passive_mass, nthreads_runtime)) {
+        free(fx_all); free(fy_all); free(fz_all);
+        free(fx); free(fy); free(fz);
+        if (f) fclose(f);
+        return -1.0;
+    }
+
+    /* Переупорядочивание тел вдоль кривой; snapshot - копия в исходном порядке для вывода */
+    SfcReorder sfc;
+    Body *snapshot = NULL;
+    int use_sfc = (opts->reorder_every > 0 && !use_wh && !use_tp);
+    if (use_sfc) {
+        snapshot = (Body*)malloc(n * sizeof(Body));
+        if (!snapshot || !sfc_init(&sfc, n, opts->sfc_curve, nthreads_runtime)) {
+            if (!snapshot) fprintf(stderr, "Error: Failed to allocate snapshot buffer\n");
+            free(snapshot);
+            free(fx_all); free(fy_all); free(fz_all);
+            free(fx); free(fy); free(fz);
+            if (f) fclose(f);
+            return -1.0;
+        }
+    }
+
+    /* Метод частица-сетка вместо прямого расчёта сил */
+    PMState pm;
+    int use_pm = (opts->pm_grid > 0 && !use_wh && !use_tp);
+    if (use_pm && !pm_init(&pm, bodies, n, opts->pm_grid, opts->pm_box, nthreads_runtime)) {
+        if (use_sfc) {
+            sfc_free(&sfc);
+            free(snapshot);
+        }
+        free(fx_all); free(fy_all); free(fz_all);
+        free(fx); free(fy); free(fz);
+        if (f) fclose(f);
+        return -1.0;
+    }
+
+    /* Периодические границы: суммирование Эвальда */
+    EwaldState ewald;
+    int use_ewald = (opts->ewald && !use_wh && !use_tp);
+    if (use_ewald && !ewald_init(&ewald, bodies, n, opts->pm_box, opts->ewald_alpha,
+                                 opts->ewald_tol, nthreads_runtime)) {
+        if (use_sfc) {
+            sfc_free(&sfc);
+            free(snapshot);
+        }
+        free(fx_all); free(fy_all); free(fz_all);
+        free(fx); free(fy); free(fz);
+        if (f) fclose(f);
+        return -1.0;
+    }
+
+    if (store && !ts_append(store, 0.0, bodies)) store = NULL;
 
     /* Запускаем таймер */
     double start_time = omp_get_wtime();
+
+    if (render && !render_frame(render, bodies, n, 0)) render = NULL;
+    if (fof && !fof_catalog(fof, bodies, n, 0)) fof = NULL;
     
     /* Основной цикл симуляции */
+    int failed = 0;
     for (int step = 1; step <= total_steps; step++) {
         double t = step * dt;
+        int output_due = (step % OUTPUT_STEP == 0 || step == total_steps);
+        int output_now = should_write && output_due;
+        int store_now = store && output_due;
+        int render_now = render && (step % opts->render_every == 0);
+        int fof_now = fof && (step % opts->fof_every == 0);
         
-        /* Вычисляем силы */
-        compute_forces(bodies, n, fx, fy, fz, fx_all, fy_all, fz_all, nthreads_runtime);;
-        
-        /* Обновляем позиции и скорости */
-        update_bodies(bodies, n, fx, fy, fz, dt);
+        if (use_wh) {
+            /* Кеплеровский дрейф + взаимодействия; в инерциальные координаты - только для вывода */
+            wh_step(&wh, dt);
+            if (output_now || store_now || render_now || fof_now) wh_to_bodies(&wh, bodies);
+        } else if (use_tp) {
+            /* Только взаимодействия активные - все */
+            tp_step(&tp, dt);
+            if (output_now || store_now || render_now || fof_now) tp_to_bodies(&tp, bodies);
+        } else {
+            if (use_sfc && (step - 1) % opts->reorder_every == 0) {
+                sfc_reorder(&sfc, bodies);
+            }
+
+            /* Вычисляем силы */
+            if (use_pm) {
+                pm_forces(&pm, bodies, n, fx, fy, fz);
+            } else if (use_ewald) {
+                if (!ewald_forces(&ewald, bodies, n, fx, fy, fz)) {
+                    failed = 1;
+                    break;
+                }
+            } else if (opts->deterministic) {
+                compute_forces_ordered(bodies, n, fx, fy, fz);
+            } else {
+                compute_forces(bodies, n, fx, fy, fz, fx_all, fy_all, fz_all, nthreads_runtime);
+            }
+
+            /* Тесные пары: шаг в переменных KS по силам до обновления тел */
+            if (reg) reg_advance(reg, bodies, fx, fy, fz, dt);
+            
+            /* Обновляем позиции и скорости */
+            update_bodies(bodies, n, fx, fy, fz, dt);
+            if (reg) reg_apply(reg, bodies);
+        }
         
         /* Записываем состояние с заданным интервалом */
-        if (should_write && (step % OUTPUT_STEP == 0 || step == total_steps)) {
-            write_snapshot(f, t, bodies, n);
+        if (output_now || store_now) {
+            const Body *frame = bodies;
+            if (use_sfc) {
+                sfc_restore(&sfc, bodies, snapshot);
+                frame = snapshot;
+            }
+            if (output_now) write_snapshot(f, t, frame, n);
+            if (store_now && !ts_append(store, t, frame)) store = NULL;
+        }
+
+        /* Кадр плотности прямо из памяти; порядок тел (в т.ч. после сортировки) не важен */
+        if (render_now && !render_frame(render, bodies, n, step)) {
+            render = NULL;
+        }
+        if (fof_now && !fof_catalog(fof, bodies, n, step)) {
+            fof = NULL;
         }
     }
     
     /* Останавливаем таймер */
     double end_time = omp_get_wtime();
     double elapsed = end_time - start_time;
+
+    if (use_wh) {
+        wh_to_bodies(&wh, bodies);
+        wh_free(&wh);
+    }
+    if (use_tp) {
+        tp_to_bodies(&tp, bodies);
+        tp_free(&tp);
+    }
+    if (use_sfc) {
+        /* Возвращаем тела в исходный порядок */
+        sfc_restore(&sfc, bodies, snapshot);
+        memcpy(bodies, snapshot, n * sizeof(Body));
+        sfc_free(&sfc);
+        free(snapshot);
+    }
+    if (use_pm) {
+        pm_free(&pm);
+    }
+    if (use_ewald) {
+        ewald_free(&ewald);
+    }
        
     free(fx_all);
     free(fy_all);
@@ -354,41 +561,854 @@ double simulate_nbody(Body *bodies, int n, double tend, double dt,
     if (f) fclose(f);
     free(fx); free(fy); free(fz);
     
-    return elapsed;
+    return failed ? -1.0 : elapsed;
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s <nthreads> <tend> <input_file> [num_runs] [prefix] [options]\n", prog);
+    fprintf(stderr, "  nthreads:   number of OpenMP threads\n");
+    fprintf(stderr, "  tend:       end time of simulation (seconds)\n");
+    fprintf(stderr, "  input_file: file with masses, positions and velocities\n");
+    fprintf(stderr, "  num_runs:   number of runs for averaging (default: 1)\n");
+    fprintf(stderr, "  prefix:     output file prefix (default: task2)\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --integrator <name>     euler | wh (Wisdom-Holman, default: euler)\n");
+    fprintf(stderr, "  --dt <seconds>          time step (default: %g)\n", DT);
+    fprintf(stderr, "  --no-trajectory         do not write result.csv\n");
+    fprintf(stderr, "  --energy-log            append energy error to <prefix>_energy.csv\n");
+    fprintf(stderr, "  --passive-mass <kg>     bodies lighter than this are massless test particles\n");
+    fprintf(stderr, "  --reorder <K>           sort bodies along a space-filling curve every K steps\n");
+    fprintf(stderr, "  --sfc <curve>           morton | hilbert (default: morton)\n");
+    fprintf(stderr, "  --pm <Ng>               particle-mesh forces on a periodic Ng^3 grid (power of two)\n");
+    fprintf(stderr, "  --box <meters>          periodic box [0, L)^3 for PM and Ewald (default: cube around initial bodies)\n");
+    fprintf(stderr, "  --ewald                 periodic gravity by Ewald summation\n");
+    fprintf(stderr, "  --ewald-alpha <a>       splitting parameter alpha * box (default: balanced for N)\n");
+    fprintf(stderr, "  --ewald-tol <eps>       Ewald truncation tolerance (default: 1e-5)\n");
+    fprintf(stderr, "  --render <K>            write a log-scaled density projection every K steps\n");
+    fprintf(stderr, "  --render-size <pixels>  frame width and height (default: 512)\n");
+    fprintf(stderr, "  --render-axis <plane>   xy | xz | yz (default: xy)\n");
+    fprintf(stderr, "  --fof <K>               write a friends-of-friends group catalog every K steps\n");
+    fprintf(stderr, "  --fof-link <b>          linking length in mean interparticle spacings (default: 0.2)\n");
+    fprintf(stderr, "  --fof-min <members>     smallest group written to the catalog (default: 10)\n");
+    fprintf(stderr, "  --deterministic         force sums independent of the thread count\n");
+    fprintf(stderr, "  --columnar              also write the chunked per-body store trajectory.nbt\n");
+    fprintf(stderr, "  --regularize <meters>   integrate mutually nearest pairs closer than this in KS variables\n");
+    fprintf(stderr, "  --rapl                  measure package and DRAM energy (RAPL), write task2/data/<prefix>_rapl.csv\n");
+    fprintf(stderr, "  --sweep <list>          time the simulation for each thread count (e.g. 1,2,4,8) in one process,\n");
+    fprintf(stderr, "                          report speedup, efficiency and Karp-Flatt serial fraction; nthreads is ignored\n");
+}
+
+/* Значение опции: следующий аргумент командной строки */
+const char *option_value(int argc, char *argv[], int *a) {
+    if (*a + 1 >= argc) {
+        fprintf(stderr, "Error: option %s requires a value\n", argv[*a]);
+        return NULL;
+    }
+    return argv[++(*a)];
+}
+
+/* Разбор одной опции; возвращает 0 при ошибке */
+int parse_option(int argc, char *argv[], int *a, SimOptions *opts) {
+    const char *name = argv[*a];
+    const char *value;
+
+    if (strcmp(name, "--integrator") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        if (strcmp(value, "euler") == 0) {
+            opts->integrator = INTEGRATOR_EULER;
+        } else if (strcmp(value, "wh") == 0) {
+            opts->integrator = INTEGRATOR_WH;
+        } else {
+            fprintf(stderr, "Error: unknown integrator %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--dt") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->dt = atof(value);
+        if (opts->dt <= 0.0) {
+            fprintf(stderr, "Error: dt must be positive, got %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--no-trajectory") == 0) {
+        opts->write_trajectory = 0;
+    } else if (strcmp(name, "--energy-log") == 0) {
+        opts->energy_log = 1;
+    } else if (strcmp(name, "--passive-mass") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->passive_mass = atof(value);
+        if (opts->passive_mass <= 0.0) {
+            fprintf(stderr, "Error: passive mass threshold must be positive, got %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--reorder") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->reorder_every = atoi(value);
+        if (opts->reorder_every <= 0) {
+            fprintf(stderr, "Error: reorder interval must be positive, got %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--sfc") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        if (strcmp(value, "morton") == 0) {
+            opts->sfc_curve = SFC_MORTON;
+        } else if (strcmp(value, "hilbert") == 0) {
+            opts->sfc_curve = SFC_HILBERT;
+        } else {
+            fprintf(stderr, "Error: unknown curve %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--pm") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->pm_grid = atoi(value);
+        if (opts->pm_grid < 2 || (opts->pm_grid & (opts->pm_grid - 1)) != 0) {
+            fprintf(stderr, "Error: PM grid size must be a power of two, got %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--box") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->pm_box = atof(value);
+        if (opts->pm_box <= 0.0) {
+            fprintf(stderr, "Error: box size must be positive, got %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--ewald") == 0) {
+        opts->ewald = 1;
+    } else if (strcmp(name, "--ewald-alpha") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->ewald_alpha = atof(value);
+        if (opts->ewald_alpha <= 0.0) {
+            fprintf(stderr, "Error: Ewald alpha must be positive, got %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--ewald-tol") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->ewald_tol = atof(value);
+        if (opts->ewald_tol <= 0.0 || opts->ewald_tol >= 1.0) {
+            fprintf(stderr, "Error: Ewald tolerance must be in (0, 1), got %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--render") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->render_every = atoi(value);
+        if (opts->render_every <= 0) {
+            fprintf(stderr, "Error: render interval must be positive, got %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--render-size") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->render_size = atoi(value);
+        if (opts->render_size <= 0) {
+            fprintf(stderr, "Error: render size must be positive, got %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--render-axis") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        if (strcmp(value, "xy") == 0) {
+            opts->render_axis = RENDER_XY;
+        } else if (strcmp(value, "xz") == 0) {
+            opts->render_axis = RENDER_XZ;
+        } else if (strcmp(value, "yz") == 0) {
+            opts->render_axis = RENDER_YZ;
+        } else {
+            fprintf(stderr, "Error: unknown projection plane %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--columnar") == 0) {
+        opts->columnar = 1;
+    } else if (strcmp(name, "--deterministic") == 0) {
+        opts->deterministic = 1;
+    } else if (strcmp(name, "--rapl") == 0) {
+        opts->rapl = 1;
+    } else if (strcmp(name, "--sweep") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->sweep_count = scaling_parse_threads(value, opts->sweep_threads, SCALING_MAX_POINTS);
+        if (opts->sweep_count == 0) {
+            fprintf(stderr, "Error: thread list must be positive integers separated by commas, got %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--regularize") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->reg_radius = atof(value);
+        if (opts->reg_radius <= 0.0) {
+            fprintf(stderr, "Error: regularization radius must be positive, got %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--fof") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->fof_every = atoi(value);
+        if (opts->fof_every <= 0) {
+            fprintf(stderr, "Error: group finder interval must be positive, got %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--fof-link") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->fof_link = atof(value);
+        if (opts->fof_link <= 0.0) {
+            fprintf(stderr, "Error: linking length must be positive, got %s\n", value);
+            return 0;
+        }
+    } else if (strcmp(name, "--fof-min") == 0) {
+        if (!(value = option_value(argc, argv, a))) return 0;
+        opts->fof_min = atoi(value);
+        if (opts->fof_min <= 0) {
+            fprintf(stderr, "Error: minimal group size must be positive, got %s\n", value);
+            return 0;
+        }
+    } else {
+        fprintf(stderr, "Error: unknown option %s\n", name);
+        return 0;
+    }
+    return 1;
+}
+
+/* --- Оценка режима пробных частиц относительно полного расчёта N^2 --- */
+/* Повторяет симуляцию без разделения тел и сравнивает время и конечные позиции */
+void report_passive_error(const Body *initial, const Body *final_state, int n,
+                          double tend, const SimOptions *opts, double split_time) {
+    Body *reference = (Body*)malloc(n * sizeof(Body));
+    if (!reference) {
+        fprintf(stderr, "Error: Failed to allocate reference bodies\n");
+        return;
+    }
+    memcpy(reference, initial, n * sizeof(Body));
+
+    SimOptions full = *opts;
+    full.passive_mass = 0.0;
+    double full_time = simulate_nbody(reference, n, tend, opts->dt, NULL, 0, &full, NULL, NULL, NULL, NULL);
+    if (full_time < 0.0) {
+        free(reference);
+        return;
+    }
+
+    /* Центр масс эталонной системы - для относительной ошибки позиций */
+    double M = 0.0, cx = 0.0, cy = 0.0, cz = 0.0;
+    for (int i = 0; i < n; i++) {
+        M += reference[i].mass;
+        cx += reference[i].mass * reference[i].x;
+        cy += reference[i].mass * reference[i].y;
+        cz += reference[i].mass * reference[i].z;
+    }
+    cx /= M; cy /= M; cz /= M;
+
+    double max_abs = 0.0, max_rel = 0.0, sum_rel = 0.0;
+    for (int i = 0; i < n; i++) {
+        double dx = final_state[i].x - reference[i].x;
+        double dy = final_state[i].y - reference[i].y;
+        double dz = final_state[i].z - reference[i].z;
+        double err = sqrt(dx*dx + dy*dy + dz*dz);
+        double rx = reference[i].x - cx, ry = reference[i].y - cy, rz = reference[i].z - cz;
+        double r = sqrt(rx*rx + ry*ry + rz*rz);
+        double rel = (r > 0.0) ? err / r : 0.0;
+        if (err > max_abs) max_abs = err;
+        if (rel > max_rel) max_rel = rel;
+        sum_rel += rel;
+    }
+
+    printf("\n=== Test-Particle Mode vs Full N^2 ===\n");
+    printf("Full N^2 time:        %.6f seconds\n", full_time);
+    printf("Split time:           %.6f seconds\n", split_time);
+    printf("Speedup:              %.2fx\n", full_time / split_time);
+    printf("Max position error:   %.6e m\n", max_abs);
+    printf("Max relative error:   %.6e\n", max_rel);
+    printf("Mean relative error:  %.6e\n", sum_rel / n);
+    printf("======================================\n");
+
+    free(reference);
+}
+
+/* --- Промахи кэша с переупорядочиванием и без --- */
+/* Повторяет симуляцию без вывода под аппаратными счётчиками в обоих режимах */
+void report_reorder_locality(const Body *initial, int n, double tend, const SimOptions *opts) {
+    Body *work = (Body*)malloc(n * sizeof(Body));
+    if (!work) {
+        fprintf(stderr, "Error: Failed to allocate bodies for locality report\n");
+        return;
+    }
+
+    PerfCounters pc;
+    perf_counters_open(&pc);
+
+    SimOptions plain = *opts;
+    plain.reorder_every = 0;
+    const SimOptions *modes[2] = {&plain, opts};
+    double times[2];
+    long long misses[2], refs[2], l1_misses[2];
+
+    for (int m = 0; m < 2; m++) {
+        memcpy(work, initial, n * sizeof(Body));
+        perf_counters_start(&pc);
+        times[m] = simulate_nbody(work, n, tend, opts->dt, NULL, 0, modes[m], NULL, NULL, NULL, NULL);
+        perf_counters_stop(&pc);
+        if (times[m] < 0.0) {
+            perf_counters_close(&pc);
+            free(work);
+            return;
+        }
+        misses[m] = perf_counters_read(&pc, PERF_EVENT_CACHE_MISSES);
+        refs[m] = perf_counters_read(&pc, PERF_EVENT_CACHE_REFERENCES);
+        l1_misses[m] = perf_counters_read(&pc, PERF_EVENT_L1D_READ_MISSES);
+    }
+
+    printf("\n=== Space-Filling-Curve Reordering (%s, every %d steps) ===\n",
+           sfc_curve_name(opts->sfc_curve), opts->reorder_every);
+    printf("Original order time:  %.6f seconds\n", times[0]);
+    printf("Reordered time:       %.6f seconds\n", times[1]);
+    printf("Speedup:              %.2fx\n", times[0] / times[1]);
+    if (!pc.available) {
+        printf("Cache misses:         perf counters not available\n");
+    } else {
+        if (misses[0] >= 0 && misses[1] >= 0) {
+            printf("LLC misses:           %lld -> %lld (%.1f%% reduction)\n", misses[0], misses[1],
+                   misses[0] > 0 ? 100.0 * (misses[0] - misses[1]) / misses[0] : 0.0);
+        }
+        if (refs[0] >= 0 && refs[1] >= 0) {
+            printf("LLC references:       %lld -> %lld\n", refs[0], refs[1]);
+        }
+        if (l1_misses[0] >= 0 && l1_misses[1] >= 0) {
+            printf("L1D read misses:      %lld -> %lld (%.1f%% reduction)\n", l1_misses[0], l1_misses[1],
+                   l1_misses[0] > 0 ? 100.0 * (l1_misses[0] - l1_misses[1]) / l1_misses[0] : 0.0);
+        }
+    }
+    printf("==========================================================\n");
+
+    perf_counters_close(&pc);
+    free(work);
+}
+
+/* --- Стадии PM и сравнение с прямым расчётом сил --- */
+/* Несколько вычислений сил для начального состояния обоими методами; строка в <prefix>_pm.csv */
+#define PM_REPORT_EVALUATIONS 3
+#define PM_DIRECT_MAX_BODIES 200000     /* Прямой расчёт N^2 для больших N слишком долог */
+
+void report_pm_comparison(const char *csv_dir, const char *prefix, const Body *initial, int n,
+                          const SimOptions *opts, int nthreads) {
+    double *f_pm = (double*)malloc(3 * (size_t)n * sizeof(double));
+    double *f_direct = (double*)malloc(3 * (size_t)n * sizeof(double));
+    double *f_all = (double*)malloc(3 * (size_t)nthreads * n * sizeof(double));
+    Body *work = (Body*)malloc(n * sizeof(Body));
+    PMState pm;
+    if (!f_pm || !f_direct || !f_all || !work) {
+        fprintf(stderr, "Error: Failed to allocate PM comparison buffers\n");
+        free(f_pm); free(f_direct); free(f_all); free(work);
+        return;
+    }
+    memcpy(work, initial, n * sizeof(Body));
+    if (!pm_init(&pm, work, n, opts->pm_grid, opts->pm_box, nthreads)) {
+        free(f_pm); free(f_direct); free(f_all); free(work);
+        return;
+    }
+
+    for (int e = 0; e < PM_REPORT_EVALUATIONS; e++) {
+        pm_forces(&pm, work, n, f_pm, f_pm + n, f_pm + 2 * (size_t)n);
+    }
+    PMTimings t = pm.timings;
+    double k = 1.0 / t.evaluations;
+    double pm_time = (t.assign + t.fft_forward + t.solve + t.fft_inverse + t.gradient + t.interpolate) * k;
+
+    double direct_time = -1.0, rms_error = -1.0;
+    if (n <= PM_DIRECT_MAX_BODIES) {
+        double start = omp_get_wtime();
+        compute_forces(work, n, f_direct, f_direct + n, f_direct + 2 * (size_t)n,
+                       f_all, f_all + (size_t)nthreads * n, f_all + 2 * (size_t)nthreads * n, nthreads);
+        direct_time = omp_get_wtime() - start;
+
+        /* Среднеквадратичная ошибка силы относительно среднего модуля прямой силы */
+        double err2 = 0.0, ref2 = 0.0;
+        for (int i = 0; i < n; i++) {
+            for (int d = 0; d < 3; d++) {
+                double diff = f_pm[(size_t)d * n + i] - f_direct[(size_t)d * n + i];
+                err2 += diff * diff;
+                ref2 += f_direct[(size_t)d * n + i] * f_direct[(size_t)d * n + i];
+            }
+        }
+        rms_error = (ref2 > 0.0) ? sqrt(err2 / ref2) : 0.0;
+    }
+
+    printf("\n=== Particle-Mesh Forces (Ng = %d, box = %.6e m) ===\n", pm.ng, pm.box);
+    printf("Mass assignment (CIC): %.6f s\n", t.assign * k);
+    printf("Forward FFT:           %.6f s\n", t.fft_forward * k);
+    printf("Poisson solve:         %.6f s\n", t.solve * k);
+    printf("Inverse FFT:           %.6f s\n", t.fft_inverse * k);
+    printf("Gradient:              %.6f s\n", t.gradient * k);
+    printf("Force interpolation:   %.6f s\n", t.interpolate * k);
+    printf("PM total:              %.6f s per force evaluation\n", pm_time);
+    if (direct_time >= 0.0) {
+        printf("Direct compute_forces: %.6f s per force evaluation\n", direct_time);
+        printf("PM speedup:            %.2fx\n", direct_time / pm_time);
+        printf("RMS force difference:  %.6e (relative, periodic PM vs isolated direct)\n", rms_error);
+    } else {
+        printf("Direct compute_forces: skipped (n > %d)\n", PM_DIRECT_MAX_BODIES);
+    }
+    printf("=====================================================\n");
+
+    char fname[512];
+    snprintf(fname, sizeof(fname), "%s/%s_pm.csv", csv_dir, prefix);
+    FILE *test = fopen(fname, "r");
+    int file_exists = (test != NULL);
+    if (test) fclose(test);
+
+    FILE *f = fopen(fname, "a");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s for writing\n", fname);
+    } else {
+        if (!file_exists) {
+            fprintf(f, "nthreads,nbodies,ng,box,assign,fft_forward,solve,fft_inverse,gradient,");
+            fprintf(f, "interpolate,pm_total,direct_time,rms_force_error\n");
+        }
+        fprintf(f, "%d,%d,%d,%.6e,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6e\n",
+                nthreads, n, pm.ng, pm.box, t.assign * k, t.fft_forward * k, t.solve * k,
+                t.fft_inverse * k, t.gradient * k, t.interpolate * k, pm_time,
+                direct_time, rms_error);
+        fclose(f);
+        printf("PM stage timings written to %s\n", fname);
+    }
+
+    pm_free(&pm);
+    free(f_pm); free(f_direct); free(f_all); free(work);
+}
+
+/* --- Стоимость и точность суммирования Эвальда --- */
+/* Силы начального состояния с заданными параметрами и с эталонным допуском; строка в <prefix>_ewald.csv */
+#define EWALD_REPORT_EVALUATIONS 3
+#define EWALD_REFERENCE_TOL 1e-12
+#define EWALD_REFERENCE_MAX_BODIES 20000    /* Эталон с rc = box / 2 стоит O(N^2) */
+
+void report_ewald(const char *csv_dir, const char *prefix, const Body *initial, int n,
+                  const SimOptions *opts, int nthreads) {
+    double *f = (double*)malloc(3 * (size_t)n * sizeof(double));
+    double *f_ref = (double*)malloc(3 * (size_t)n * sizeof(double));
+    EwaldState ew;
+    if (!f || !f_ref) {
+        fprintf(stderr, "Error: Failed to allocate Ewald comparison buffers\n");
+        free(f); free(f_ref);
+        return;
+    }
+    if (!ewald_init(&ew, initial, n, opts->pm_box, opts->ewald_alpha, opts->ewald_tol, nthreads)) {
+        free(f); free(f_ref);
+        return;
+    }
+
+    for (int e = 0; e < EWALD_REPORT_EVALUATIONS; e++) {
+        if (!ewald_forces(&ew, initial, n, f, f + n, f + 2 * (size_t)n)) {
+            ewald_free(&ew);
+            free(f); free(f_ref);
+            return;
+        }
+    }
+    double k = 1.0 / ew.timings.evaluations;
+
+    double rms_error = -1.0;
+    if (n <= EWALD_REFERENCE_MAX_BODIES) {
+        EwaldState ref;
+        if (ewald_init(&ref, initial, n, opts->pm_box, 0.0, EWALD_REFERENCE_TOL, nthreads)) {
+            if (ewald_forces(&ref, initial, n, f_ref, f_ref + n, f_ref + 2 * (size_t)n)) {
+                double err2 = 0.0, ref2 = 0.0;
+                for (size_t i = 0; i < 3 * (size_t)n; i++) {
+                    err2 += (f[i] - f_ref[i]) * (f[i] - f_ref[i]);
+                    ref2 += f_ref[i] * f_ref[i];
+                }
+                rms_error = (ref2 > 0.0) ? sqrt(err2 / ref2) : 0.0;
+            }
+            ewald_free(&ref);
+        }
+    }
+
+    printf("\n=== Ewald Summation (box = %.6e m) ===\n", ew.box);
+    printf("alpha * box:           %.4f\n", ew.alpha * ew.box);
+    printf("Real-space cutoff:     %.4f box (%d^3 cells)\n", ew.rc / ew.box, ew.cells.nc);
+    printf("Wave vectors:          %d (kmax = %d)\n", ew.nk, ew.kmax);
+    printf("Real space:            %.6f s per force evaluation\n", ew.timings.real * k);
+    printf("Reciprocal space:      %.6f s per force evaluation\n", ew.timings.reciprocal * k);
+    if (rms_error >= 0.0) {
+        printf("RMS force error:       %.6e (relative to tol = %.0e)\n", rms_error, EWALD_REFERENCE_TOL);
+    } else if (n > EWALD_REFERENCE_MAX_BODIES) {
+        printf("RMS force error:       skipped (n > %d)\n", EWALD_REFERENCE_MAX_BODIES);
+    } else {
+        printf("RMS force error:       skipped (reference failed)\n");
+    }
+    printf("======================================\n");
+
+    char fname[512];
+    snprintf(fname, sizeof(fname), "%s/%s_ewald.csv", csv_dir, prefix);
+    FILE *test = fopen(fname, "r");
+    int file_exists = (test != NULL);
+    if (test) fclose(test);
+
+    FILE *out = fopen(fname, "a");
+    if (!out) {
+        fprintf(stderr, "Cannot open %s for writing\n", fname);
+    } else {
+        if (!file_exists) {
+            fprintf(out, "nthreads,nbodies,box,alpha_box,tol,rc_box,cells,kmax,nk,");
+            fprintf(out, "real_time,reciprocal_time,rms_force_error\n");
+        }
+        fprintf(out, "%d,%d,%.6e,%.4f,%.1e,%.4f,%d,%d,%d,%.6f,%.6f,%.6e\n",
+                nthreads, n, ew.box, ew.alpha * ew.box, opts->ewald_tol, ew.rc / ew.box,
+                ew.cells.nc, ew.kmax, ew.nk, ew.timings.real * k, ew.timings.reciprocal * k,
+                rms_error);
+        fclose(out);
+        printf("Ewald timings written to %s\n", fname);
+    }
+
+    ewald_free(&ew);
+    free(f); free(f_ref);
+}
+
+/* --- Детерминированное суммирование сил --- */
+/* Время обоих ядер на начальном состоянии и различие сил при 1 и nthreads потоках;
+ * строка в <prefix>_reduction.csv */
+#define REDUCTION_REPORT_EVALUATIONS 3
+
+/* Наибольшее отличие компоненты силы, отнесённое к среднеквадратичной силе */
+static double max_force_difference(const double *a, const double *b, int n) {
+    double max_diff = 0.0, ref2 = 0.0;
+    for (size_t k = 0; k < 3 * (size_t)n; k++) {
+        double diff = fabs(a[k] - b[k]);
+        if (diff > max_diff) max_diff = diff;
+        ref2 += b[k] * b[k];
+    }
+    return (ref2 > 0.0) ? max_diff / sqrt(ref2 / (3.0 * n)) : max_diff;
+}
+
+/* Пер-поточные буферы f_all рассчитаны на nthreads потоков */
+static double time_pairwise(const Body *bodies, int n, double *f, double *f_all, int nthreads) {
+    size_t stride = (size_t)nthreads * n;
+    double start = omp_get_wtime();
+    compute_forces((Body*)bodies, n, f, f + n, f + 2 * (size_t)n,
+                   f_all, f_all + stride, f_all + 2 * stride, nthreads);
+    return omp_get_wtime() - start;
+}
+
+static double time_ordered(const Body *bodies, int n, double *f) {
+    double start = omp_get_wtime();
+    compute_forces_ordered(bodies, n, f, f + n, f + 2 * (size_t)n);
+    return omp_get_wtime() - start;
+}
+
+void report_deterministic(const char *csv_dir, const char *prefix, const Body *initial, int n,
+                          int nthreads) {
+    size_t nf = 3 * (size_t)n;
+    double *f_pair = (double*)malloc(nf * sizeof(double));
+    double *f_pair1 = (double*)malloc(nf * sizeof(double));
+    double *f_ord = (double*)malloc(nf * sizeof(double));
+    double *f_ord1 = (double*)malloc(nf * sizeof(double));
+    double *f_all = (double*)malloc(nf * nthreads * sizeof(double));
+    if (!f_pair || !f_pair1 || !f_ord || !f_ord1 || !f_all) {
+        fprintf(stderr, "Error: Failed to allocate reduction comparison buffers\n");
+        free(f_pair); free(f_pair1); free(f_ord); free(f_ord1); free(f_all);
+        return;
+    }
+
+    double pairwise_time = 0.0, ordered_time = 0.0;
+    for (int e = 0; e < REDUCTION_REPORT_EVALUATIONS; e++) {
+        pairwise_time += time_pairwise(initial, n, f_pair, f_all, nthreads);
+        ordered_time += time_ordered(initial, n, f_ord);
+    }
+    pairwise_time /= REDUCTION_REPORT_EVALUATIONS;
+    ordered_time /= REDUCTION_REPORT_EVALUATIONS;
+
+    /* Те же ядра в одном потоке */
+    omp_set_num_threads(1);
+    time_pairwise(initial, n, f_pair1, f_all, 1);
+    time_ordered(initial, n, f_ord1);
+    omp_set_num_threads(nthreads);
+
+    double pairwise_threads_diff = max_force_difference(f_pair, f_pair1, n);
+    int ordered_equal = (memcmp(f_ord, f_ord1, nf * sizeof(double)) == 0);
+    double ordered_vs_pairwise = max_force_difference(f_ord, f_pair1, n);
+    double overhead = (pairwise_time > 0.0) ? ordered_time / pairwise_time : 0.0;
+
+    printf("\n=== Deterministic Force Reduction (%d threads vs 1) ===\n", nthreads);
+    printf("Pairwise compute_forces:        %.6f s per force evaluation\n", pairwise_time);
+    printf("Ordered compute_forces_ordered: %.6f s per force evaluation\n", ordered_time);
+    printf("Overhead:                       %.2fx\n", overhead);
+    printf("Pairwise, %d vs 1 threads:      max difference %.3e (relative to RMS force)\n",
+           nthreads, pairwise_threads_diff);
+    printf("Ordered, %d vs 1 threads:       %s\n", nthreads, ordered_equal ? "bitwise identical" : "DIFFERENT");
+    printf("Ordered vs pairwise:            max difference %.3e (relative to RMS force)\n",
+           ordered_vs_pairwise);
+    printf("==========================================================\n");
+
+    char fname[512];
+    snprintf(fname, sizeof(fname), "%s/%s_reduction.csv", csv_dir, prefix);
+    FILE *test = fopen(fname, "r");
+    int file_exists = (test != NULL);
+    if (test) fclose(test);
+
+    FILE *f = fopen(fname, "a");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s for writing\n", fname);
+    } else {
+        if (!file_exists) {
+            fprintf(f, "nthreads,nbodies,pairwise_time,ordered_time,overhead,");
+            fprintf(f, "pairwise_thread_diff,ordered_bitwise_equal,ordered_vs_pairwise_diff\n");
+        }
+        fprintf(f, "%d,%d,%.6f,%.6f,%.3f,%.3e,%d,%.3e\n",
+                nthreads, n, pairwise_time, ordered_time, overhead,
+                pairwise_threads_diff, ordered_equal, ordered_vs_pairwise);
+        fclose(f);
+        printf("Reduction comparison written to %s\n", fname);
+    }
+
+    free(f_pair); free(f_pair1); free(f_ord); free(f_ord1); free(f_all);
+}
+
+/* --- Регуляризация тесных пар --- */
+/* Повторяет симуляцию без регуляризации с тем же шагом и сравнивает ошибку энергии;
+ * строка в <prefix>_regularization.csv */
+void report_regularization(const char *csv_dir, const char *prefix, const Body *initial, int n,
+                           double tend, const SimOptions *opts, const RegState *reg, int num_runs,
+                           double reg_time, double energy_start, double energy_end) {
+    Body *plain = (Body*)malloc(n * sizeof(Body));
+    if (!plain) {
+        fprintf(stderr, "Error: Failed to allocate comparison bodies\n");
+        return;
+    }
+    memcpy(plain, initial, n * sizeof(Body));
+
+    SimOptions plain_opts = *opts;
+    plain_opts.reg_radius = 0.0;
+    double plain_time = simulate_nbody(plain, n, tend, opts->dt, NULL, 0, &plain_opts,
+                                       NULL, NULL, NULL, NULL);
+    if (plain_time < 0.0) {
+        free(plain);
+        return;
+    }
+    double plain_error = fabs((compute_energy(plain, n) - energy_start) / energy_start);
+    double reg_error = fabs((energy_end - energy_start) / energy_start);
+    free(plain);
+
+    int total_steps = (int)(tend / opts->dt);
+    double pair_steps = (double)reg->pair_steps / num_runs;
+    double substeps_per_pair = reg->pair_steps > 0 ? (double)reg->substeps / reg->pair_steps : 0.0;
+    double min_sep = reg->pair_steps > 0 ? reg->min_separation : 0.0;
+    double pair_time = reg->time / num_runs;
+
+    printf("\n=== Close-Encounter Regularization (r < %.3e m) ===\n", opts->reg_radius);
+    printf("Regularized pair-steps:  %.0f per run (%.3f pairs per step, max %d)\n",
+           pair_steps, total_steps > 0 ? pair_steps / total_steps : 0.0, reg->max_pairs);
+    printf("KS substeps:             %.1f per pair-step\n", substeps_per_pair);
+    printf("Pair searches:           %lld of %lld steps (skipped while no pair could form)\n",
+           reg->searches, reg->searches + reg->skipped);
+    printf("Closest regularized pair: %.6e m\n", min_sep);
+    printf("Pair search + KS time:   %.6f s (%.2f%% of the run)\n",
+           pair_time, reg_time > 0.0 ? 100.0 * pair_time / reg_time : 0.0);
+    printf("Energy error, KS pairs:  %.6e (relative)\n", reg_error);
+    printf("Energy error, plain:     %.6e (relative, %.6f s)\n", plain_error, plain_time);
+    printf("====================================================\n");
+
+    char fname[512];
+    snprintf(fname, sizeof(fname), "%s/%s_regularization.csv", csv_dir, prefix);
+    FILE *test = fopen(fname, "r");
+    int file_exists = (test != NULL);
+    if (test) fclose(test);
+
+    FILE *f = fopen(fname, "a");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s for writing\n", fname);
+        return;
+    }
+    if (!file_exists) {
+        fprintf(f, "nthreads,nbodies,dt,radius,pair_steps,max_pairs,substeps_per_pair,min_separation,");
+        fprintf(f, "pair_time,time_regularized,time_plain,energy_error_regularized,energy_error_plain\n");
+    }
+    fprintf(f, "%d,%d,%.6f,%.6e,%.0f,%d,%.2f,%.6e,%.6f,%.6f,%.6f,%.6e,%.6e\n",
+            omp_get_max_threads(), n, opts->dt, opts->reg_radius, pair_steps, reg->max_pairs,
+            substeps_per_pair, min_sep, pair_time, reg_time, plain_time, reg_error, plain_error);
+    fclose(f);
+    printf("Regularization comparison written to %s\n", fname);
+}
+
+/* --- Режим масштабирования по числу потоков ---
+ * Вход читается один раз; для каждого числа потоков - прогревочный запуск
+ * (создание команды потоков, страницы буферов сил) и num_runs замеров с одного
+ * начального состояния. Траектории и отчёты режимов не пишутся; каждое число
+ * потоков - строка в <prefix>_performance.csv; фаза вычисления в профиле
+ * памяти снимается отдельно для каждого числа потоков */
+int run_sweep(const SimOptions *opts, const Body *initial, int n, double tend, int num_runs,
+              const char *csv_dir, const char *prefix, const char *cpu_info,
+              const MachinePeak *peak, const EnvInfo *env, MemProfile *memory) {
+    Body *bodies = (Body*)malloc(n * sizeof(Body));
+    if (!bodies) {
+        fprintf(stderr, "Error: Failed to allocate working copy of bodies\n");
+        return 1;
+    }
+    mem_phase_end(memory, MEM_LOAD);
+
+    int total_steps = (int)(tend / opts->dt);
+    ScalingPoint points[SCALING_MAX_POINTS];
+    PerformanceMetrics metrics[SCALING_MAX_POINTS];
+    MemProfile memories[SCALING_MAX_POINTS];
+    for (int s = 0; s < opts->sweep_count; s++) {
+        int p = opts->sweep_threads[s];
+        omp_set_num_threads(p);
+        memories[s] = *memory;
+        mem_phase_begin(&memories[s], MEM_COMPUTE);
+
+        memcpy(bodies, initial, n * sizeof(Body));
+        double warmup = simulate_nbody(bodies, n, tend, opts->dt, NULL, 0, opts, NULL, NULL, NULL, NULL);
+        if (warmup < 0.0) {
+            fprintf(stderr, "Simulation failed\n");
+            free(bodies);
+            return 1;
+        }
+        printf("Threads %d, warmup: Time = %.6f s\n", p, warmup);
+
+        PerformanceMetrics *m = &metrics[s];
+        m->nthreads = p;
+        m->nbodies = n;
+        m->tend = tend;
+        m->dt = opts->dt;
+        m->total_steps = total_steps;
+        m->output_steps = (total_steps / OUTPUT_STEP) + 1;
+        m->num_runs = num_runs;
+        count_work(opts, m);
+        m->min_time = 1e9;
+        m->max_time = 0.0;
+        m->avg_time = 0.0;
+        for (int run = 0; run < num_runs; run++) {
+            memcpy(bodies, initial, n * sizeof(Body));
+            double elapsed = simulate_nbody(bodies, n, tend, opts->dt, NULL, 0, opts, NULL, NULL, NULL, NULL);
+            if (elapsed < 0.0) {
+                fprintf(stderr, "Simulation failed\n");
+                free(bodies);
+                return 1;
+            }
+            if (elapsed < m->min_time) m->min_time = elapsed;
+            if (elapsed > m->max_time) m->max_time = elapsed;
+            m->avg_time += elapsed;
+            printf("Threads %d, run %d/%d: Time = %.6f s\n", p, run + 1, num_runs, elapsed);
+        }
+        m->avg_time /= num_runs;
+        m->computation_time = m->avg_time;
+        mem_phase_end(&memories[s], MEM_COMPUTE);
+        m->memory = &memories[s];
+
+        points[s].threads = p;
+        points[s].min_time = m->min_time;
+        points[s].avg_time = m->avg_time;
+        m->scaling = &points[s];
+    }
+    free(bodies);
+
+    scaling_compute(points, opts->sweep_count);
+    scaling_print(points, opts->sweep_count, env->affinity_cpus);
+    mem_profile_print(&memories[opts->sweep_count - 1]);
+    for (int s = 0; s < opts->sweep_count; s++) {
+        write_performance_metrics(csv_dir, prefix, &metrics[s], cpu_info, peak, env);
+    }
+    return 0;
 }
 
 int main(int argc, char *argv[]) {
-    /* Разбор аргументов командной строки */
-    if (argc < 4) {
-        fprintf(stderr, "Usage: %s <nthreads> <tend> <input_file> [num_runs] [prefix]\n", argv[0]);
-        fprintf(stderr, "  nthreads:   number of OpenMP threads\n");
-        fprintf(stderr, "  tend:       end time of simulation (seconds)\n");
-        fprintf(stderr, "  input_file: file with masses, positions and velocities\n");
-        fprintf(stderr, "  num_runs:   number of runs for averaging (default: 1)\n");
-        fprintf(stderr, "  prefix:     output file prefix (default: task2)\n");
+    /* Временная шкала фаз (только при сборке с -DENABLE_TRACE) - до любых событий */
+    TRACE_INIT("./task2/data/task2_trace.json");
+
+    /* Разбор аргументов командной строки: позиционные аргументы и опции */
+    SimOptions opts;
+    opts.integrator = INTEGRATOR_EULER;
+    opts.dt = DT;
+    opts.write_trajectory = 1;
+    opts.energy_log = 0;
+    opts.passive_mass = 0.0;
+    opts.reorder_every = 0;
+    opts.sfc_curve = SFC_MORTON;
+    opts.pm_grid = 0;
+    opts.pm_box = 0.0;
+    opts.ewald = 0;
+    opts.ewald_alpha = 0.0;
+    opts.ewald_tol = 1e-5;
+    opts.render_every = 0;
+    opts.render_size = 512;
+    opts.render_axis = RENDER_XY;
+    opts.fof_every = 0;
+    opts.fof_link = 0.2;
+    opts.fof_min = 10;
+    opts.deterministic = 0;
+    opts.columnar = 0;
+    opts.reg_radius = 0.0;
+    opts.rapl = 0;
+    opts.sweep_count = 0;
+
+    const char *positional[5];
+    int npositional = 0;
+    for (int a = 1; a < argc; a++) {
+        if (strncmp(argv[a], "--", 2) == 0) {
+            if (!parse_option(argc, argv, &a, &opts)) return 1;
+        } else if (npositional < 5) {
+            positional[npositional++] = argv[a];
+        } else {
+            fprintf(stderr, "Error: unexpected argument %s\n", argv[a]);
+            return 1;
+        }
+    }
+
+    if (npositional < 3) {
+        print_usage(argv[0]);
         return 1;
     }
     
-    int nthreads = atoi(argv[1]);
-    double tend = atof(argv[2]);
-    const char *input_file = argv[3];
-    int num_runs = (argc >= 5) ? atoi(argv[4]) : 1;
-    const char *prefix = (argc >= 6) ? argv[5] : "task2";
+    int nthreads = atoi(positional[0]);
+    double tend = atof(positional[1]);
+    const char *input_file = positional[2];
+    int num_runs = (npositional >= 4) ? atoi(positional[3]) : 1;
+    const char *prefix = (npositional >= 5) ? positional[4] : "task2";
     
     if (nthreads <= 0) {
-        fprintf(stderr, "Error: nthreads must be positive, got %s\n", argv[1]);
+        fprintf(stderr, "Error: nthreads must be positive, got %s\n", positional[0]);
         return 1;
     }
     
     if (tend <= 0.0) {
-        fprintf(stderr, "Error: tend must be positive, got %s\n", argv[2]);
+        fprintf(stderr, "Error: tend must be positive, got %s\n", positional[1]);
+        return 1;
+    }
+
+    if (opts.passive_mass > 0.0 && opts.integrator != INTEGRATOR_EULER) {
+        fprintf(stderr, "Error: --passive-mass is supported only with the euler integrator\n");
+        return 1;
+    }
+
+    if (opts.reorder_every > 0 && (opts.integrator != INTEGRATOR_EULER || opts.passive_mass > 0.0)) {
+        fprintf(stderr, "Error: --reorder is supported only with the euler integrator without --passive-mass\n");
+        return 1;
+    }
+
+    if (opts.pm_grid > 0 && (opts.integrator != INTEGRATOR_EULER || opts.passive_mass > 0.0)) {
+        fprintf(stderr, "Error: --pm is supported only with the euler integrator without --passive-mass\n");
+        return 1;
+    }
+
+    if (opts.ewald && (opts.integrator != INTEGRATOR_EULER || opts.passive_mass > 0.0 || opts.pm_grid > 0)) {
+        fprintf(stderr, "Error: --ewald is supported only with the euler integrator without --passive-mass and --pm\n");
         return 1;
     }
     
+    if (opts.deterministic && (opts.integrator != INTEGRATOR_EULER || opts.passive_mass > 0.0 ||
+                               opts.pm_grid > 0 || opts.ewald)) {
+        fprintf(stderr, "Error: --deterministic is supported only with direct euler forces "
+                        "(without --passive-mass, --pm and --ewald)\n");
+        return 1;
+    }
+    
+    if (opts.reg_radius > 0.0 && (opts.integrator != INTEGRATOR_EULER || opts.passive_mass > 0.0 ||
+                                  opts.pm_grid > 0 || opts.ewald)) {
+        fprintf(stderr, "Error: --regularize is supported only with direct euler forces "
+                        "(without --passive-mass, --pm and --ewald)\n");
+        return 1;
+    }
+
     if (num_runs <= 0) {
         fprintf(stderr, "Error: num_runs must be positive, got %d\n", num_runs);
         return 1;
     }
+
+    if (opts.sweep_count > 0 && (opts.render_every > 0 || opts.fof_every > 0 || opts.columnar ||
+                                 opts.reg_radius > 0.0 || opts.energy_log || opts.rapl)) {
+        fprintf(stderr, "Error: --sweep is supported only without --render, --fof, --columnar, "
+                        "--regularize, --energy-log and --rapl\n");
+        return 1;
+    }
     
     /* Устанавливаем число потоков OpenMP */
     omp_set_num_threads(nthreads);
@@ -396,11 +1416,20 @@ int main(int argc, char *argv[]) {
     /* Получаем информацию о CPU */
     char cpu_info[256];
     get_cpu_info(cpu_info, sizeof(cpu_info));
+    EnvInfo env;
+    env_capture(&env);
+    MachinePeak peak;
+    peak_estimate(&peak, &env);
     
     /* Создаём директорию для вывода */
     const char *csv_dir = "./task2/data";
     ensure_dir_exists(csv_dir);
     
+    /* Память по фазам: загрузка - чтение входа и выделение состояний режимов */
+    MemProfile memory;
+    mem_profile_init(&memory);
+    mem_phase_begin(&memory, MEM_LOAD);
+
     /* Читаем входные данные */
     Body *bodies_original = NULL;
     int n = 0;
@@ -409,30 +1438,80 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
-    int total_steps = (int)(tend / DT);
+    int total_steps = (int)(tend / opts.dt);
     int output_steps = (total_steps / OUTPUT_STEP) + 1;
     
     printf("=== OpenMP N-Body Simulation Benchmark ===\n");
     printf("CPU: %s\n", cpu_info);
-    printf("Threads: %d\n", nthreads);
+    env_print(&env);
+    peak_print(&peak);
+    if (opts.sweep_count > 0) {
+        printf("Threads: sweep");
+        for (int s = 0; s < opts.sweep_count; s++) printf("%s%d", s > 0 ? "," : " ", opts.sweep_threads[s]);
+        printf(" (warmup run before each)\n");
+    } else {
+        printf("Threads: %d\n", nthreads);
+    }
     printf("Number of bodies: %d\n", n);
+    if (opts.passive_mass > 0.0) {
+        int nactive = 0;
+        for (int i = 0; i < n; i++) {
+            if (bodies_original[i].mass >= opts.passive_mass) nactive++;
+        }
+        printf("Active bodies: %d (mass >= %.3e kg), passive: %d\n",
+               nactive, opts.passive_mass, n - nactive);
+    }
     printf("Simulation time: %.6f seconds\n", tend);
-    printf("Time step (dt): %.6f seconds\n", DT);
+    printf("Integrator: %s\n", opts.integrator == INTEGRATOR_WH ? "Wisdom-Holman" : "Euler");
+    if (opts.reorder_every > 0) {
+        printf("Reordering: %s curve every %d steps\n", sfc_curve_name(opts.sfc_curve), opts.reorder_every);
+    }
+    if (opts.pm_grid > 0) {
+        printf("Forces: particle-mesh, %d^3 periodic grid\n", opts.pm_grid);
+    }
+    if (opts.ewald) {
+        printf("Forces: Ewald summation, periodic box\n");
+    }
+    if (opts.deterministic) {
+        printf("Forces: deterministic row-ordered summation\n");
+    }
+    if (opts.reg_radius > 0.0) {
+        printf("Regularization: KS for mutually nearest pairs closer than %.3e m\n", opts.reg_radius);
+    }
+    if (opts.render_every > 0) {
+        printf("Rendering: %dx%d %s density projection every %d steps\n",
+               opts.render_size, opts.render_size, render_axis_name(opts.render_axis), opts.render_every);
+    }
+    if (opts.fof_every > 0) {
+        printf("Group finder: friends-of-friends every %d steps, b = %.3f, >= %d members\n",
+               opts.fof_every, opts.fof_link, opts.fof_min);
+    }
+    printf("Time step (dt): %.6f seconds\n", opts.dt);
     printf("Total steps: %d\n", total_steps);
     printf("Output steps: %d\n", output_steps);
     printf("Number of runs: %d\n", num_runs);
     printf("Measurement method: %s\n", num_runs > 1 ? "Average over multiple runs" : "Single run");
     printf("==========================================\n\n");
+
+    /* Серия замеров по числу потоков заменяет одиночный замер */
+    if (opts.sweep_count > 0) {
+        int status = run_sweep(&opts, bodies_original, n, tend, num_runs, csv_dir, prefix, cpu_info, &peak, &env, &memory);
+        free(bodies_original);
+        return status;
+    }
     
     /* Метрики производительности */
     PerformanceMetrics metrics;
     metrics.nthreads = nthreads;
     metrics.nbodies = n;
     metrics.tend = tend;
-    metrics.dt = DT;
+    metrics.dt = opts.dt;
     metrics.total_steps = total_steps;
     metrics.output_steps = output_steps;
     metrics.num_runs = num_runs;
+    count_work(&opts, &metrics);
+    metrics.scaling = NULL;
+    metrics.memory = &memory;
     metrics.min_time = 1e9;
     metrics.max_time = 0.0;
     metrics.avg_time = 0.0;
@@ -447,6 +1526,67 @@ int main(int argc, char *argv[]) {
     
     char output_file[512];
     snprintf(output_file, sizeof(output_file), "%s/result.csv", csv_dir);
+
+    /* Начальная энергия для контроля точности интегратора */
+    double energy_start = compute_energy(bodies_original, n);
+
+    /* Кадры плотности - в последнем запуске, как и траектории */
+    RenderState render;
+    const char *frames_dir = "./task2/data/frames";
+    if (opts.render_every > 0) {
+        ensure_dir_exists(frames_dir);
+        if (!render_init(&render, bodies_original, n, opts.render_size, opts.render_axis,
+                         frames_dir, nthreads)) {
+            free(bodies);
+            free(bodies_original);
+            return 1;
+        }
+    }
+
+    /* Каталоги групп - тоже в последнем запуске */
+    FofState fof;
+    const char *groups_dir = "./task2/data/groups";
+    if (opts.fof_every > 0) {
+        ensure_dir_exists(groups_dir);
+        if (!fof_init(&fof, bodies_original, n, opts.fof_link, opts.fof_min, groups_dir, nthreads)) {
+            if (opts.render_every > 0) render_free(&render);
+            free(bodies);
+            free(bodies_original);
+            return 1;
+        }
+    }
+
+    /* Столбцовое хранилище - кадры последнего запуска */
+    TrajStore store;
+    char store_file[512];
+    snprintf(store_file, sizeof(store_file), "%s/trajectory.nbt", csv_dir);
+    if (opts.columnar && !ts_open(&store, store_file, n, 0)) {
+        if (opts.render_every > 0) render_free(&render);
+        if (opts.fof_every > 0) fof_free(&fof);
+        free(bodies);
+        free(bodies_original);
+        return 1;
+    }
+
+    /* Регуляризация меняет интегрирование - действует во всех запусках, счётчики общие */
+    RegState reg;
+    if (opts.reg_radius > 0.0 && !reg_init(&reg, n, opts.reg_radius, nthreads)) {
+        if (opts.render_every > 0) render_free(&render);
+        if (opts.fof_every > 0) fof_free(&fof);
+        if (opts.columnar) ts_close(&store);
+        free(bodies);
+        free(bodies_original);
+        return 1;
+    }
+    double last_elapsed = 0.0;
+
+    /* Энергия по счётчикам RAPL: вокруг каждого вызова simulate_nbody */
+    RaplCounters rapl;
+    if (opts.rapl) rapl_open(&rapl);
+    mem_phase_end(&memory, MEM_LOAD);
+
+    /* Вычисление включает запись траектории в последнем запуске */
+    mem_phase_begin(&memory, MEM_COMPUTE);
     
     /* Выполняем несколько запусков для усреднения */
     for (int run = 0; run < num_runs; run++) {
@@ -457,11 +1597,23 @@ int main(int argc, char *argv[]) {
         memcpy(bodies, bodies_original, n * sizeof(Body));
         
         /* Запускаем симуляцию (записываем результаты только в последнем запуске) */
-        int should_write = (run == num_runs - 1);
-        double elapsed = simulate_nbody(bodies, n, tend, DT, output_file, should_write);
+        int should_write = opts.write_trajectory && (run == num_runs - 1);
+        RenderState *run_render = (opts.render_every > 0 && run == num_runs - 1) ? &render : NULL;
+        FofState *run_fof = (opts.fof_every > 0 && run == num_runs - 1) ? &fof : NULL;
+        TrajStore *run_store = (opts.columnar && run == num_runs - 1) ? &store : NULL;
+        RegState *run_reg = (opts.reg_radius > 0.0) ? &reg : NULL;
+        if (opts.rapl) rapl_start(&rapl);
+        double elapsed = simulate_nbody(bodies, n, tend, opts.dt, output_file, should_write, &opts,
+                                        run_render, run_fof, run_store, run_reg);
+        if (opts.rapl) rapl_stop(&rapl);
+        last_elapsed = elapsed;
         
         if (elapsed < 0.0) {
             fprintf(stderr, "Simulation failed\n");
+            if (opts.render_every > 0) render_free(&render);
+            if (opts.fof_every > 0) fof_free(&fof);
+            if (opts.columnar) ts_close(&store);
+            if (opts.reg_radius > 0.0) reg_free(&reg);
             free(bodies);
             free(bodies_original);
             return 1;
@@ -478,6 +1630,8 @@ int main(int argc, char *argv[]) {
     /* Вычисляем среднее время */
     metrics.avg_time /= num_runs;
     metrics.computation_time = metrics.avg_time;
+    mem_phase_end(&memory, MEM_COMPUTE);
+    mem_phase_begin(&memory, MEM_OUTPUT);
     
     printf("\n=== Performance Summary ===\n");
     if (num_runs > 1) {
@@ -489,12 +1643,100 @@ int main(int argc, char *argv[]) {
         printf("Elapsed time: %.6f seconds\n", metrics.computation_time);
     }
     printf("Steps/second: %.2f\n", total_steps / metrics.avg_time);
+    if (metrics.interactions > 0.0) {
+        double gflops = metrics.flops / metrics.avg_time * 1e-9;
+        printf("Throughput:   %.3f G interactions/s, %.2f GFLOP/s", metrics.interactions / metrics.avg_time * 1e-9, gflops);
+        if (peak.gflops > 0.0) printf(" (%.2f%% of peak)", 100.0 * peak_fraction(&peak, gflops));
+        printf("\n");
+    } else {
+        printf("Throughput:   %.3e body-steps/s (no pair interactions count for this force method)\n",
+               (double)n * total_steps / metrics.avg_time);
+    }
+
+    /* Ошибка энергии по состоянию после последнего запуска */
+    double energy_end = compute_energy(bodies, n);
+    printf("Energy error: %.6e (relative)\n", fabs((energy_end - energy_start) / energy_start));
     printf("===========================\n\n");
     
-    printf("Results written to %s\n", output_file);
+    if (opts.write_trajectory) {
+        printf("Results written to %s\n", output_file);
+    }
+    if (opts.columnar && ts_close(&store)) {
+        printf("Columnar trajectory written to %s (%lld frames, %d per chunk, %.2f MB)\n",
+               store_file, (long long)store.header.nframes, store.header.chunk_frames,
+               store.bytes / (1024.0 * 1024.0));
+    }
+    if (opts.render_every > 0) {
+        printf("Density frames: %d written to %s (%.2f MB)\n",
+               render.frames, frames_dir, render.bytes / (1024.0 * 1024.0));
+        printf("Rendering time: %.6f s (%.2f%% of the last run)\n",
+               render.time, last_elapsed > 0.0 ? 100.0 * render.time / last_elapsed : 0.0);
+        render_free(&render);
+    }
+    if (opts.fof_every > 0) {
+        printf("Group catalogs: %d written to %s, linking length %.3e m\n",
+               fof.catalogs, groups_dir, fof.link);
+        printf("Last catalog: %d groups, largest %d members\n", fof.last_groups, fof.last_largest);
+        printf("Group finder time: %.6f s (%.2f%% of the last run)\n",
+               fof.time, last_elapsed > 0.0 ? 100.0 * fof.time / last_elapsed : 0.0);
+        fof_free(&fof);
+    }
+    mem_phase_end(&memory, MEM_OUTPUT);
+    mem_profile_print(&memory);
     
     /* Записываем метрики производительности */
-    write_performance_metrics(csv_dir, prefix, &metrics, cpu_info);
+    write_performance_metrics(csv_dir, prefix, &metrics, cpu_info, &peak, &env);
+    if (opts.energy_log) {
+        write_energy_log(csv_dir, prefix, &opts, &metrics, energy_start, energy_end);
+    }
+    if (opts.rapl) {
+        write_rapl_report(csv_dir, prefix, &opts, &rapl, &metrics, &env);
+    }
+
+    /* Ядро прямого расчёта сил на roofline машины: строка i проходит все тела j,
+     * рабочий набор потока - массив тел и свой буфер сил */
+    if (metrics.interactions > 0.0) {
+        Roofline roofline;
+        roofline_load(&roofline, ROOFLINE_CSV_PATH, nthreads);
+        char roofline_csv[512];
+        snprintf(roofline_csv, sizeof(roofline_csv), "%s/%s_roofline.csv", csv_dir, prefix);
+        double working_set = (double)n * (sizeof(Body) + (opts.deterministic ? 0 : 3 * sizeof(double)));
+        roofline_report(&roofline, opts.deterministic ? "compute_forces_ordered" : "compute_forces_pairs",
+                        nthreads, metrics.flops, metrics.bytes, metrics.avg_time, working_set, env.hash,
+                        roofline_csv);
+    }
+
+    /* Для режима пробных частиц - ускорение и ошибка относительно полного расчёта */
+    if (opts.passive_mass > 0.0) {
+        report_passive_error(bodies_original, bodies, n, tend, &opts, metrics.avg_time);
+    }
+
+    /* Для переупорядочивания - промахи кэша относительно исходного порядка */
+    if (opts.reorder_every > 0) {
+        report_reorder_locality(bodies_original, n, tend, &opts);
+    }
+
+    /* Для PM - время стадий и сравнение с прямым расчётом */
+    if (opts.pm_grid > 0) {
+        report_pm_comparison(csv_dir, prefix, bodies_original, n, &opts, nthreads);
+    }
+
+    /* Для Эвальда - стоимость частей и ошибка относительно эталонного допуска */
+    if (opts.ewald) {
+        report_ewald(csv_dir, prefix, bodies_original, n, &opts, nthreads);
+    }
+
+    /* Для детерминированного режима - цена фиксированного порядка и проверка побитового совпадения */
+    if (opts.deterministic) {
+        report_deterministic(csv_dir, prefix, bodies_original, n, nthreads);
+    }
+
+    /* Для регуляризации - статистика пар и ошибка энергии без неё */
+    if (opts.reg_radius > 0.0) {
+        report_regularization(csv_dir, prefix, bodies_original, n, tend, &opts, &reg,
+                              num_runs, metrics.avg_time, energy_start, energy_end);
+        reg_free(&reg);
+    }
     
     /* Очистка */
     free(bodies);
@@ -0,0 +1,163 @@
+/* test_particles.c
+ * Режим пробных частиц: взаимодействия только активные - все
+ */
+
+#include "test_particles.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+
+/* --- Ускорения пассивных тел в поле активных --- */
+static void passive_accelerations(TestParticleState *s) {
+    int na = s->nactive;
+    const double *amx = s->amx, *amy = s->amy, *amz = s->amz, *am = s->am;
+
+    #pragma omp parallel for schedule(static)
+    for (int p = 0; p < s->npassive; p++) {
+        double xp = s->px[p], yp = s->py[p], zp = s->pz[p];
+        double ax = 0.0, ay = 0.0, az = 0.0;
+
+        #pragma omp simd reduction(+:ax, ay, az)
+        for (int a = 0; a < na; a++) {
+            double dx = amx[a] - xp;
+            double dy = amy[a] - yp;
+            double dz = amz[a] - zp;
+            double r_sq = dx*dx + dy*dy + dz*dz + SOFTENING;
+            double inv_r = 1.0 / sqrt(r_sq);
+            double k = G * am[a] * inv_r * inv_r * inv_r;
+            ax += k * dx;
+            ay += k * dy;
+            az += k * dz;
+        }
+
+        s->pax[p] = ax;
+        s->pay[p] = ay;
+        s->paz[p] = az;
+    }
+}
+
+void tp_step(TestParticleState *s, double dt) {
+    /* Силы между активными телами (третий закон Ньютона, пер-поточные буферы) */
+    compute_forces(s->active, s->nactive, s->fx, s->fy, s->fz,
+                   s->fx_all, s->fy_all, s->fz_all, s->nthreads);
+
+    /* Позиции активных тел в SoA для векторизованного ядра */
+    for (int a = 0; a < s->nactive; a++) {
+        s->amx[a] = s->active[a].x;
+        s->amy[a] = s->active[a].y;
+        s->amz[a] = s->active[a].z;
+    }
+    passive_accelerations(s);
+
+    /* Обновление состояний: активные - как обычно, пассивные - в своём блоке */
+    update_bodies(s->active, s->nactive, s->fx, s->fy, s->fz, dt);
+
+    #pragma omp parallel for simd schedule(static)
+    for (int p = 0; p < s->npassive; p++) {
+        s->px[p] += s->pvx[p] * dt;
+        s->py[p] += s->pvy[p] * dt;
+        s->pz[p] += s->pvz[p] * dt;
+        s->pvx[p] += s->pax[p] * dt;
+        s->pvy[p] += s->pay[p] * dt;
+        s->pvz[p] += s->paz[p] * dt;
+    }
+}
+
+void tp_to_bodies(const TestParticleState *s, Body *bodies) {
+    for (int a = 0; a < s->nactive; a++) {
+        bodies[s->active_index[a]] = s->active[a];
+    }
+    for (int p = 0; p < s->npassive; p++) {
+        Body *b = &bodies[s->passive_index[p]];
+        b->x = s->px[p];
+        b->y = s->py[p];
+        b->z = s->pz[p];
+        b->vx = s->pvx[p];
+        b->vy = s->pvy[p];
+        b->vz = s->pvz[p];
+    }
+}
+
+int tp_init(TestParticleState *s, const Body *bodies, int n, double mass_threshold, int nthreads) {
+    memset(s, 0, sizeof(*s));
+    s->n = n;
+    s->nthreads = nthreads;
+
+    for (int i = 0; i < n; i++) {
+        if (bodies[i].mass >= mass_threshold) s->nactive++;
+    }
+    s->npassive = n - s->nactive;
+
+    /* +1: malloc(0) может вернуть NULL, пустые блоки допустимы */
+    size_t na = (size_t)s->nactive + 1;
+    size_t np = (size_t)s->npassive + 1;
+    size_t total_elems = (size_t)nthreads * na;
+
+    s->active_index = (int*)malloc(na * sizeof(int));
+    s->passive_index = (int*)malloc(np * sizeof(int));
+    s->active = (Body*)malloc(na * sizeof(Body));
+    s->fx = (double*)malloc(na * sizeof(double));
+    s->fy = (double*)malloc(na * sizeof(double));
+    s->fz = (double*)malloc(na * sizeof(double));
+    s->fx_all = (double*)malloc(total_elems * sizeof(double));
+    s->fy_all = (double*)malloc(total_elems * sizeof(double));
+    s->fz_all = (double*)malloc(total_elems * sizeof(double));
+    s->amx = (double*)malloc(na * sizeof(double));
+    s->amy = (double*)malloc(na * sizeof(double));
+    s->amz = (double*)malloc(na * sizeof(double));
+    s->am  = (double*)malloc(na * sizeof(double));
+    s->px  = (double*)malloc(np * sizeof(double));
+    s->py  = (double*)malloc(np * sizeof(double));
+    s->pz  = (double*)malloc(np * sizeof(double));
+    s->pvx = (double*)malloc(np * sizeof(double));
+    s->pvy = (double*)malloc(np * sizeof(double));
+    s->pvz = (double*)malloc(np * sizeof(double));
+    s->pax = (double*)malloc(np * sizeof(double));
+    s->pay = (double*)malloc(np * sizeof(double));
+    s->paz = (double*)malloc(np * sizeof(double));
+    if (!s->active_index || !s->passive_index || !s->active ||
+        !s->fx || !s->fy || !s->fz || !s->fx_all || !s->fy_all || !s->fz_all ||
+        !s->amx || !s->amy || !s->amz || !s->am ||
+        !s->px || !s->py || !s->pz || !s->pvx || !s->pvy || !s->pvz ||
+        !s->pax || !s->pay || !s->paz) {
+        fprintf(stderr, "Error: Failed to allocate test-particle state (n=%d)\n", n);
+        tp_free(s);
+        return 0;
+    }
+
+    int a = 0, p = 0;
+    for (int i = 0; i < n; i++) {
+        if (bodies[i].mass >= mass_threshold) {
+            s->active_index[a] = i;
+            s->active[a] = bodies[i];
+            s->am[a] = bodies[i].mass;
+            a++;
+        } else {
+            s->passive_index[p] = i;
+            s->px[p] = bodies[i].x;
+            s->py[p] = bodies[i].y;
+            s->pz[p] = bodies[i].z;
+            s->pvx[p] = bodies[i].vx;
+            s->pvy[p] = bodies[i].vy;
+            s->pvz[p] = bodies[i].vz;
+            p++;
+        }
+    }
+
+    return 1;
+}
+
+void tp_free(TestParticleState *s) {
+    free(s->active_index); free(s->passive_index);
+    free(s->active);
+    free(s->fx); free(s->fy); free(s->fz);
+    free(s->fx_all); free(s->fy_all); free(s->fz_all);
+    free(s->amx); free(s->amy); free(s->amz); free(s->am);
+    free(s->px); free(s->py); free(s->pz);
+    free(s->pvx); free(s->pvy); free(s->pvz);
+    free(s->pax); free(s->pay); free(s->paz);
+    memset(s, 0, sizeof(*s));
+}
@@ -0,0 +1,44 @@
+/* test_particles.h
+ * Режим пробных частиц: тела легче порога считаются пассивными - они движутся
+ * в поле активных тел, но сами ни на кого не действуют. Вместо N^2 пар
+ * вычисляется O(N_active * N) взаимодействий.
+ */
+
+#ifndef TEST_PARTICLES_H
+#define TEST_PARTICLES_H
+
+#include "nbody.h"
+
+/* Состояние разделённой системы */
+typedef struct {
+    int n;
+    int nactive;
+    int npassive;
+    int *active_index;      /* Индексы активных тел в исходном массиве */
+    int *passive_index;     /* Индексы пассивных тел в исходном массиве */
+
+    /* Активные тела: AoS для compute_forces и копия позиций в SoA для ядра пассивных */
+    Body *active;
+    double *fx, *fy, *fz;
+    double *fx_all, *fy_all, *fz_all;
+    double *amx, *amy, *amz, *am;
+    int nthreads;
+
+    /* Пассивные тела в отдельном SoA-блоке */
+    double *px, *py, *pz;
+    double *pvx, *pvy, *pvz;
+    double *pax, *pay, *paz;    /* Ускорения */
+} TestParticleState;
+
+/* Разделение тел по порогу массы; возвращает 0 при ошибке */
+int tp_init(TestParticleState *s, const Body *bodies, int n, double mass_threshold, int nthreads);
+
+/* Один шаг метода Эйлера (та же схема, что compute_forces + update_bodies) */
+void tp_step(TestParticleState *s, double dt);
+
+/* Сборка состояния в исходном порядке тел */
+void tp_to_bodies(const TestParticleState *s, Body *bodies);
+
+void tp_free(TestParticleState *s);
+
+#endif /* TEST_PARTICLES_H */
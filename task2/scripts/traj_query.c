@@ -0,0 +1,221 @@
+/* traj_query.c
+ * Выборка из столбцового хранилища траекторий (trajectory.nbt): ряды
+ * выбранных тел в окне времени. Файл отображается в память (mmap), читаются
+ * только блоки окна и только ряды выбранных тел.
+ *
+ * Компиляция: gcc -O3 -o task2/scripts/traj_query task2/scripts/traj_query.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "traj_store.h"
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s <trajectory.nbt> [options]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --bodies <list>   1-based bodies, e.g. 1,5,10-20 (default: all)\n");
+    fprintf(stderr, "  --from <t>        first time of the window (default: start)\n");
+    fprintf(stderr, "  --to <t>          last time of the window (default: end)\n");
+    fprintf(stderr, "  --info            print the header and the frame index summary only\n");
+    fprintf(stderr, "Output: CSV t,body,x,y,z to stdout, grouped by body\n");
+}
+
+/* Разбор списка тел "1,5,10-20" в номера с нуля; возвращает число тел или -1 */
+int parse_bodies(const char *list, int n, int *out) {
+    int count = 0;
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long lo = strtol(p, &end, 10);
+        long hi = lo;
+        if (end == p) return -1;
+        if (*end == '-') {
+            p = end + 1;
+            hi = strtol(p, &end, 10);
+            if (end == p) return -1;
+        }
+        if (lo < 1 || hi > n || lo > hi) {
+            fprintf(stderr, "Error: body range %ld-%ld outside 1-%d\n", lo, hi, n);
+            return -1;
+        }
+        for (long b = lo; b <= hi && count < n; b++) out[count++] = (int)(b - 1);
+        if (*end == ',') end++;
+        else if (*end != '\0') return -1;
+        p = end;
+    }
+    return count;
+}
+
+/* Первый кадр с временем >= t (времена кадров возрастают) */
+int64_t lower_frame(const double *times, int64_t nframes, double t) {
+    int64_t lo = 0, hi = nframes;
+    while (lo < hi) {
+        int64_t mid = lo + (hi - lo) / 2;
+        if (times[mid] < t) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const char *path = argv[1];
+    const char *bodies_arg = NULL;
+    double t_from = -1e300, t_to = 1e300;
+    int info = 0;
+    for (int a = 2; a < argc; a++) {
+        if (strcmp(argv[a], "--bodies") == 0 && a + 1 < argc) {
+            bodies_arg = argv[++a];
+        } else if (strcmp(argv[a], "--from") == 0 && a + 1 < argc) {
+            t_from = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--to") == 0 && a + 1 < argc) {
+            t_to = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--info") == 0) {
+            info = 1;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Cannot open %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(TrajHeader)) {
+        fprintf(stderr, "Error: %s is not a trajectory store\n", path);
+        close(fd);
+        return 1;
+    }
+    const char *base = (const char*)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "Error: Cannot map %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    const TrajHeader *h = (const TrajHeader*)base;
+    if (memcmp(h->magic, TRAJ_MAGIC, sizeof(TRAJ_MAGIC)) != 0 || h->version != TRAJ_VERSION) {
+        fprintf(stderr, "Error: %s is not a version %d trajectory store\n", path, TRAJ_VERSION);
+        munmap((void*)base, (size_t)st.st_size);
+        return 1;
+    }
+    int n = h->nbodies;
+    int frames = h->chunk_frames;
+    int64_t nframes = h->nframes;
+    if (n <= 0 || frames <= 0 || nframes < 0) {
+        fprintf(stderr, "Error: %s has a corrupt header (nbodies=%d, chunk_frames=%d, nframes=%lld)\n",
+                path, n, frames, (long long)nframes);
+        munmap((void*)base, (size_t)st.st_size);
+        return 1;
+    }
+    int64_t nchunks = (nframes + frames - 1) / frames;
+    if (traj_chunk_offset(h, nchunks) > (int64_t)st.st_size) {
+        fprintf(stderr, "Error: %s is truncated\n", path);
+        munmap((void*)base, (size_t)st.st_size);
+        return 1;
+    }
+
+    /* Индекс времён; у незакрытого файла собирается из начал блоков */
+    double *gathered = NULL;
+    const double *times;
+    if (h->index_offset > 0 && h->index_offset + nframes * (int64_t)sizeof(double) <= (int64_t)st.st_size) {
+        times = (const double*)(base + h->index_offset);
+    } else {
+        gathered = (double*)malloc((size_t)(nframes > 0 ? nframes : 1) * sizeof(double));
+        if (!gathered) {
+            fprintf(stderr, "Error: Failed to allocate frame index\n");
+            munmap((void*)base, (size_t)st.st_size);
+            return 1;
+        }
+        for (int64_t f = 0; f < nframes; f++) {
+            const double *chunk = (const double*)(base + traj_chunk_offset(h, f / frames));
+            gathered[f] = chunk[f % frames];
+        }
+        times = gathered;
+    }
+
+    if (info) {
+        printf("File: %s (%lld bytes)\n", path, (long long)st.st_size);
+        printf("Bodies: %d\n", n);
+        printf("Frames: %lld in %lld chunks of %d\n", (long long)nframes, (long long)nchunks, frames);
+        if (nframes > 0) printf("Time range: %.6f .. %.6f\n", times[0], times[nframes - 1]);
+        printf("Frame index: %s\n", h->index_offset > 0 ? "present" : "missing (file not closed)");
+        free(gathered);
+        munmap((void*)base, (size_t)st.st_size);
+        return 0;
+    }
+
+    int *bodies = (int*)malloc((size_t)(n > 0 ? n : 1) * sizeof(int));
+    if (!bodies) {
+        fprintf(stderr, "Error: Failed to allocate body list\n");
+        free(gathered);
+        munmap((void*)base, (size_t)st.st_size);
+        return 1;
+    }
+    int nsel;
+    if (bodies_arg) {
+        nsel = parse_bodies(bodies_arg, n, bodies);
+        if (nsel < 0) {
+            fprintf(stderr, "Error: invalid body list %s\n", bodies_arg);
+            free(bodies);
+            free(gathered);
+            munmap((void*)base, (size_t)st.st_size);
+            return 1;
+        }
+    } else {
+        nsel = n;
+        for (int i = 0; i < n; i++) bodies[i] = i;
+    }
+
+    /* Окно кадров [f0, f1) и блоки, которые его покрывают */
+    int64_t f0 = lower_frame(times, nframes, t_from);
+    int64_t f1 = f0;
+    while (f1 < nframes && times[f1] <= t_to) f1++;
+
+    printf("t,body,x,y,z\n");
+    int64_t bytes_read = 0;
+    for (int s = 0; s < nsel; s++) {
+        int b = bodies[s];
+        for (int64_t c = f0 / frames; f1 > f0 && c <= (f1 - 1) / frames; c++) {
+            const double *chunk = (const double*)(base + traj_chunk_offset(h, c));
+            const double *x = traj_series(chunk, h, b, 0);
+            const double *y = traj_series(chunk, h, b, 1);
+            const double *z = traj_series(chunk, h, b, 2);
+            int64_t k0 = (c * frames < f0) ? f0 - c * frames : 0;
+            int64_t k1 = ((c + 1) * frames > f1) ? f1 - c * frames : frames;
+            for (int64_t k = k0; k < k1; k++) {
+                printf("%.6f,%d,%.15f,%.15f,%.15f\n", times[c * frames + k], b + 1, x[k], y[k], z[k]);
+            }
+            bytes_read += 3 * (k1 - k0) * (int64_t)sizeof(double);
+        }
+    }
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) + 1e-9 * (end.tv_nsec - start.tv_nsec);
+    fprintf(stderr, "Selected %d bodies x %lld frames; read %.2f MB of %.2f MB in %.6f s\n",
+            nsel, (long long)(f1 - f0), bytes_read / (1024.0 * 1024.0),
+            st.st_size / (1024.0 * 1024.0), elapsed);
+
+    free(bodies);
+    free(gathered);
+    munmap((void*)base, (size_t)st.st_size);
+    return 0;
+}
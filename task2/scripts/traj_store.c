@@ -0,0 +1,140 @@
+/* traj_store.c
+ * Запись столбцового хранилища траекторий блоками
+ */
+
+#include "traj_store.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* Заголовок в начале файла: перезаписывается после каждого блока, чтобы
+ * прерванная симуляция оставляла читаемый файл */
+static int write_header(TrajStore *s) {
+    long end = ftell(s->f);
+    if (fseek(s->f, 0, SEEK_SET) != 0 ||
+        fwrite(&s->header, sizeof(TrajHeader), 1, s->f) != 1 ||
+        fseek(s->f, end, SEEK_SET) != 0) {
+        fprintf(stderr, "Error: Failed to write trajectory store header: %s\n", strerror(errno));
+        return 0;
+    }
+    return 1;
+}
+
+static int flush_chunk(TrajStore *s) {
+    if (s->in_chunk == 0) return 1;
+    int64_t chunk_bytes = traj_chunk_bytes(&s->header);
+    int frames = s->header.chunk_frames;
+
+    /* Неполный блок дополняется нулями: смещения блоков остаются вычислимыми */
+    if (s->in_chunk < frames) {
+        int64_t series = 1 + 3 * (int64_t)s->header.nbodies;
+        for (int64_t k = 0; k < series; k++) {
+            memset(s->chunk + k * frames + s->in_chunk, 0,
+                   (size_t)(frames - s->in_chunk) * sizeof(double));
+        }
+    }
+    if (fwrite(s->chunk, 1, (size_t)chunk_bytes, s->f) != (size_t)chunk_bytes) {
+        fprintf(stderr, "Error: Failed to write trajectory chunk: %s\n", strerror(errno));
+        return 0;
+    }
+    s->bytes += chunk_bytes;
+    s->header.nframes += s->in_chunk;
+    s->in_chunk = 0;
+    return write_header(s);
+}
+
+int ts_append(TrajStore *s, double t, const Body *bodies) {
+    int frames = s->header.chunk_frames;
+    int k = s->in_chunk;
+
+    /* Транспонирование кадра в ряды тел */
+    s->chunk[k] = t;
+    for (int i = 0; i < s->header.nbodies; i++) {
+        double *series = s->chunk + (int64_t)frames * (1 + 3 * (int64_t)i);
+        series[k] = bodies[i].x;
+        series[frames + k] = bodies[i].y;
+        series[2 * frames + k] = bodies[i].z;
+    }
+
+    int64_t frame = s->header.nframes + k;
+    if (frame >= s->times_capacity) {
+        int64_t capacity = s->times_capacity ? 2 * s->times_capacity : 1024;
+        double *times = (double*)realloc(s->times, (size_t)capacity * sizeof(double));
+        if (!times) {
+            fprintf(stderr, "Error: Failed to grow trajectory frame index\n");
+            return 0;
+        }
+        s->times = times;
+        s->times_capacity = capacity;
+    }
+    s->times[frame] = t;
+
+    s->in_chunk++;
+    if (s->in_chunk == frames) return flush_chunk(s);
+    return 1;
+}
+
+int ts_open(TrajStore *s, const char *path, int n, int chunk_frames) {
+    memset(s, 0, sizeof(*s));
+    if (chunk_frames <= 0) chunk_frames = TRAJ_CHUNK_FRAMES;
+    /* Буфер блока ограничен: при больших N в блоке меньше кадров */
+    int64_t frame_bytes = (1 + 3 * (int64_t)n) * (int64_t)sizeof(double);
+    if ((int64_t)chunk_frames * frame_bytes > TRAJ_CHUNK_MAX_BYTES) {
+        chunk_frames = (int)(TRAJ_CHUNK_MAX_BYTES / frame_bytes);
+        if (chunk_frames < 1) chunk_frames = 1;
+    }
+
+    memcpy(s->header.magic, TRAJ_MAGIC, sizeof(s->header.magic));
+    s->header.version = TRAJ_VERSION;
+    s->header.nbodies = n;
+    s->header.chunk_frames = chunk_frames;
+
+    s->chunk = (double*)malloc((size_t)traj_chunk_bytes(&s->header));
+    if (!s->chunk) {
+        fprintf(stderr, "Error: Failed to allocate trajectory chunk (%d frames)\n", chunk_frames);
+        return 0;
+    }
+    s->f = fopen(path, "wb");
+    if (!s->f) {
+        fprintf(stderr, "Error: Cannot open %s for writing: %s\n", path, strerror(errno));
+        free(s->chunk);
+        s->chunk = NULL;
+        return 0;
+    }
+    if (fwrite(&s->header, sizeof(TrajHeader), 1, s->f) != 1) {
+        fprintf(stderr, "Error: Failed to write trajectory store header: %s\n", strerror(errno));
+        fclose(s->f);
+        free(s->chunk);
+        memset(s, 0, sizeof(*s));
+        return 0;
+    }
+    s->bytes = sizeof(TrajHeader);
+    return 1;
+}
+
+int ts_close(TrajStore *s) {
+    if (!s->f) return 0;
+    int ok = flush_chunk(s);
+    if (ok) {
+        s->header.index_offset = ftell(s->f);
+        size_t nframes = (size_t)s->header.nframes;
+        if (fwrite(s->times, sizeof(double), nframes, s->f) != nframes) {
+            fprintf(stderr, "Error: Failed to write trajectory frame index: %s\n", strerror(errno));
+            ok = 0;
+        } else {
+            s->bytes += (int64_t)(nframes * sizeof(double));
+            ok = write_header(s);
+        }
+    }
+    fclose(s->f);
+    free(s->chunk);
+    free(s->times);
+    int64_t bytes = s->bytes;
+    TrajHeader header = s->header;
+    memset(s, 0, sizeof(*s));
+    /* Итоги остаются доступны для отчёта */
+    s->header = header;
+    s->bytes = bytes;
+    return ok;
+}
@@ -0,0 +1,68 @@
+/* traj_store.h
+ * Столбцовое хранилище траекторий: кадры группируются в блоки по chunk_frames,
+ * внутри блока ряды каждого тела (x[], y[], z[]) лежат подряд. Смещение любого
+ * блока вычисляется по его номеру, индекс времён кадров записывается в конце файла.
+ *
+ * Файл:  TrajHeader | блок 0 | блок 1 | ... | индекс: double t[nframes]
+ * Блок:  double t[C] | тело 0: x[C] y[C] z[C] | тело 1: ... (C = chunk_frames,
+ *        последний блок дополняется до C кадров)
+ */
+
+#ifndef TRAJ_STORE_H
+#define TRAJ_STORE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "nbody.h"
+
+#define TRAJ_MAGIC "NBTRAJ1"
+#define TRAJ_VERSION 1
+#define TRAJ_CHUNK_FRAMES 64                /* Кадров в блоке по умолчанию */
+#define TRAJ_CHUNK_MAX_BYTES (64 << 20)     /* Ограничение буфера блока при больших N */
+
+typedef struct {
+    char magic[8];
+    int32_t version;
+    int32_t nbodies;
+    int32_t chunk_frames;
+    int32_t reserved;
+    int64_t nframes;        /* Кадров в завершённых блоках (обновляется при каждом сбросе) */
+    int64_t index_offset;   /* Смещение индекса времён (0 - файл не закрыт) */
+} TrajHeader;
+
+/* Размер блока в байтах */
+static inline int64_t traj_chunk_bytes(const TrajHeader *h) {
+    return (int64_t)h->chunk_frames * (1 + 3 * (int64_t)h->nbodies) * (int64_t)sizeof(double);
+}
+
+/* Смещение блока c от начала файла */
+static inline int64_t traj_chunk_offset(const TrajHeader *h, int64_t c) {
+    return (int64_t)sizeof(TrajHeader) + c * traj_chunk_bytes(h);
+}
+
+/* Ряд координаты axis (0 - x, 1 - y, 2 - z) тела body внутри блока */
+static inline const double *traj_series(const double *chunk, const TrajHeader *h, int body, int axis) {
+    return chunk + h->chunk_frames * (1 + 3 * (int64_t)body + axis);
+}
+
+typedef struct {
+    FILE *f;
+    TrajHeader header;
+    double *chunk;          /* Буфер текущего блока */
+    int in_chunk;           /* Кадров в буфере */
+    double *times;          /* Времена всех кадров для индекса */
+    int64_t times_capacity;
+    int64_t bytes;          /* Записано байт */
+} TrajStore;
+
+/* Создание файла; chunk_frames <= 0 - по умолчанию. Возвращает 0 при ошибке */
+int ts_open(TrajStore *s, const char *path, int n, int chunk_frames);
+
+/* Добавление кадра; полный блок сбрасывается на диск. Возвращает 0 при ошибке */
+int ts_append(TrajStore *s, double t, const Body *bodies);
+
+/* Сброс неполного блока, запись индекса и заголовка. Возвращает 0 при ошибке */
+int ts_close(TrajStore *s);
+
+#endif /* TRAJ_STORE_H */
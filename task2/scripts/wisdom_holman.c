@@ -0,0 +1,318 @@
+/* wisdom_holman.c
+ * Симплектический интегратор Уиздома-Холмана (демократические гелиоцентрические координаты)
+ */
+
+#include "wisdom_holman.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+
+/* Размер блока тел, для которого уравнение Кеплера решается одновременно */
+#define WH_LANES 8
+/* Предельное число итераций Ньютона для уравнения Кеплера */
+#define WH_KEPLER_MAXIT 32
+/* Предельное число понижений аргумента функций Штумпфа (|z| до ~1e13) */
+#define WH_MAX_REDUCTIONS 24
+/* Относительная точность универсальной аномалии */
+#define WH_KEPLER_TOL 1e-15
+
+/* --- Функции Штумпфа c0..c3 --- */
+/* Аргумент понижается делением на 4 до |z| <= 0.1, где ряды сходятся быстро,
+ * затем восстанавливается формулами удвоения. Число шагов фиксировано,
+ * лишние шаги маскируются - в цикле нет ветвлений по данным и он векторизуется. */
+static inline void stumpff(double z, double *c0, double *c1, double *c2, double *c3) {
+    int n = 0;
+    for (int k = 0; k < WH_MAX_REDUCTIONS; k++) {
+        int reduce = fabs(z) > 0.1;
+        z = reduce ? 0.25 * z : z;
+        n += reduce;
+    }
+
+    double s3 = (1.0/6.0) * (1.0 - z/20.0 * (1.0 - z/42.0 * (1.0 - z/72.0 *
+                (1.0 - z/110.0 * (1.0 - z/156.0 * (1.0 - z/210.0))))));
+    double s2 = 0.5 * (1.0 - z/12.0 * (1.0 - z/30.0 * (1.0 - z/56.0 *
+                (1.0 - z/90.0 * (1.0 - z/132.0 * (1.0 - z/182.0))))));
+    double s1 = 1.0 - z * s3;
+    double s0 = 1.0 - z * s2;
+
+    for (int k = 0; k < WH_MAX_REDUCTIONS; k++) {
+        int apply = k < n;
+        double n3 = 0.25 * (s2 + s0 * s3);
+        double n2 = 0.5 * s1 * s1;
+        double n1 = s0 * s1;
+        double n0 = 2.0 * s0 * s0 - 1.0;
+        s3 = apply ? n3 : s3;
+        s2 = apply ? n2 : s2;
+        s1 = apply ? n1 : s1;
+        s0 = apply ? n0 : s0;
+    }
+
+    *c0 = s0; *c1 = s1; *c2 = s2; *c3 = s3;
+}
+
+/* --- Кеплеровский дрейф блока тел (универсальные переменные) --- */
+/* Уравнение Кеплера: dt = r0*X + eta0*G2(X) + zeta0*G3(X), где Gk = X^k ck(beta X^2).
+ * Решается методом Ньютона одновременно для всех тел блока. */
+static void kepler_block(double *qx, double *qy, double *qz,
+                         double *vx, double *vy, double *vz,
+                         int cnt, double mu, double dt) {
+    double r0[WH_LANES], eta0[WH_LANES], zeta0[WH_LANES], beta[WH_LANES], X[WH_LANES];
+
+    #pragma omp simd
+    for (int l = 0; l < cnt; l++) {
+        double r = sqrt(qx[l]*qx[l] + qy[l]*qy[l] + qz[l]*qz[l]);
+        double v_sq = vx[l]*vx[l] + vy[l]*vy[l] + vz[l]*vz[l];
+        r0[l] = r;
+        eta0[l] = qx[l]*vx[l] + qy[l]*vy[l] + qz[l]*vz[l];
+        beta[l] = 2.0 * mu / r - v_sq;
+        zeta0[l] = mu - beta[l] * r;
+        X[l] = dt / r;
+    }
+
+    for (int it = 0; it < WH_KEPLER_MAXIT; it++) {
+        double max_err = 0.0;
+
+        #pragma omp simd reduction(max:max_err)
+        for (int l = 0; l < cnt; l++) {
+            double c0, c1, c2, c3;
+            double x = X[l];
+            stumpff(beta[l] * x * x, &c0, &c1, &c2, &c3);
+            double G1 = x * c1, G2 = x * x * c2, G3 = x * x * x * c3;
+            double f = r0[l] * x + eta0[l] * G2 + zeta0[l] * G3 - dt;
+            double r = r0[l] + eta0[l] * G1 + zeta0[l] * G2;
+            double dx = f / r;
+            X[l] = x - dx;
+            double err = fabs(dx) / (fabs(X[l]) + 1e-300);
+            max_err = err > max_err ? err : max_err;
+        }
+
+        if (max_err < WH_KEPLER_TOL) break;
+    }
+
+    /* Функции Лагранжа f, g и их производные */
+    #pragma omp simd
+    for (int l = 0; l < cnt; l++) {
+        double c0, c1, c2, c3;
+        double x = X[l];
+        stumpff(beta[l] * x * x, &c0, &c1, &c2, &c3);
+        double G1 = x * c1, G2 = x * x * c2, G3 = x * x * x * c3;
+        double r = r0[l] + eta0[l] * G1 + zeta0[l] * G2;
+
+        double f  = 1.0 - mu * G2 / r0[l];
+        double g  = dt - mu * G3;
+        double fd = -mu * G1 / (r0[l] * r);
+        double gd = 1.0 - mu * G2 / r;
+
+        double px = qx[l], py = qy[l], pz = qz[l];
+        qx[l] = f * px + g * vx[l];
+        qy[l] = f * py + g * vy[l];
+        qz[l] = f * pz + g * vz[l];
+        double nvx = fd * px + gd * vx[l];
+        double nvy = fd * py + gd * vy[l];
+        double nvz = fd * pz + gd * vz[l];
+        vx[l] = nvx; vy[l] = nvy; vz[l] = nvz;
+    }
+}
+
+static void wh_kepler(WHState *s, double dt) {
+    int nblocks = (s->norb + WH_LANES - 1) / WH_LANES;
+
+    #pragma omp parallel for schedule(static)
+    for (int b = 0; b < nblocks; b++) {
+        int start = b * WH_LANES;
+        int cnt = (s->norb - start < WH_LANES) ? s->norb - start : WH_LANES;
+        kepler_block(s->qx + start, s->qy + start, s->qz + start,
+                     s->vx + start, s->vy + start, s->vz + start,
+                     cnt, s->mu, dt);
+    }
+
+    s->forces_valid = 0;
+}
+
+/* --- Взаимодействие нецентральных тел (kick) --- */
+static void wh_kick(WHState *s, double dt) {
+    if (!s->forces_valid) {
+        for (int i = 0; i < s->norb; i++) {
+            s->work[i].x = s->qx[i];
+            s->work[i].y = s->qy[i];
+            s->work[i].z = s->qz[i];
+        }
+        /* Центральное тело исключено: его притяжение учтено в кеплеровском дрейфе */
+        compute_forces(s->work, s->norb, s->fx, s->fy, s->fz,
+                       s->fx_all, s->fy_all, s->fz_all, s->nthreads);
+        s->forces_valid = 1;
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < s->norb; i++) {
+        s->vx[i] += dt * s->fx[i] / s->m[i];
+        s->vy[i] += dt * s->fy[i] / s->m[i];
+        s->vz[i] += dt * s->fz[i] / s->m[i];
+    }
+}
+
+/* --- Сдвиг на импульс центрального тела (jump) --- */
+static void wh_jump(WHState *s, double dt) {
+    double px = 0.0, py = 0.0, pz = 0.0;
+
+    #pragma omp parallel for schedule(static) reduction(+:px, py, pz)
+    for (int i = 0; i < s->norb; i++) {
+        px += s->m[i] * s->vx[i];
+        py += s->m[i] * s->vy[i];
+        pz += s->m[i] * s->vz[i];
+    }
+
+    double k = dt / s->m_central;
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < s->norb; i++) {
+        s->qx[i] += k * px;
+        s->qy[i] += k * py;
+        s->qz[i] += k * pz;
+    }
+    /* Взаимные расстояния не меняются - силы остаются актуальными */
+}
+
+int wh_init(WHState *s, const Body *bodies, int n, int nthreads) {
+    memset(s, 0, sizeof(*s));
+    if (n < 2) {
+        fprintf(stderr, "Error: Wisdom-Holman integrator needs at least 2 bodies\n");
+        return 0;
+    }
+
+    s->n = n;
+    s->norb = n - 1;
+    s->nthreads = nthreads;
+
+    /* Центральное тело - самое массивное */
+    s->central = 0;
+    for (int i = 1; i < n; i++) {
+        if (bodies[i].mass > bodies[s->central].mass) s->central = i;
+    }
+    s->m_central = bodies[s->central].mass;
+    s->mu = G * s->m_central;
+
+    /* Центр масс системы движется равномерно */
+    double M = 0.0;
+    for (int i = 0; i < n; i++) {
+        M += bodies[i].mass;
+        s->cm[0] += bodies[i].mass * bodies[i].x;
+        s->cm[1] += bodies[i].mass * bodies[i].y;
+        s->cm[2] += bodies[i].mass * bodies[i].z;
+        s->vcm[0] += bodies[i].mass * bodies[i].vx;
+        s->vcm[1] += bodies[i].mass * bodies[i].vy;
+        s->vcm[2] += bodies[i].mass * bodies[i].vz;
+    }
+    for (int k = 0; k < 3; k++) {
+        s->cm[k] /= M;
+        s->vcm[k] /= M;
+    }
+    s->m_total = M;
+
+    size_t norb = (size_t)s->norb;
+    size_t total_elems = (size_t)nthreads * norb;
+    s->index = (int*)malloc(norb * sizeof(int));
+    s->qx = (double*)malloc(norb * sizeof(double));
+    s->qy = (double*)malloc(norb * sizeof(double));
+    s->qz = (double*)malloc(norb * sizeof(double));
+    s->vx = (double*)malloc(norb * sizeof(double));
+    s->vy = (double*)malloc(norb * sizeof(double));
+    s->vz = (double*)malloc(norb * sizeof(double));
+    s->m  = (double*)malloc(norb * sizeof(double));
+    s->work = (Body*)malloc(norb * sizeof(Body));
+    s->fx = (double*)malloc(norb * sizeof(double));
+    s->fy = (double*)malloc(norb * sizeof(double));
+    s->fz = (double*)malloc(norb * sizeof(double));
+    s->fx_all = (double*)malloc(total_elems * sizeof(double));
+    s->fy_all = (double*)malloc(total_elems * sizeof(double));
+    s->fz_all = (double*)malloc(total_elems * sizeof(double));
+    if (!s->index || !s->qx || !s->qy || !s->qz || !s->vx || !s->vy || !s->vz || !s->m ||
+        !s->work || !s->fx || !s->fy || !s->fz || !s->fx_all || !s->fy_all || !s->fz_all) {
+        fprintf(stderr, "Error: Failed to allocate Wisdom-Holman state (n=%d)\n", n);
+        wh_free(s);
+        return 0;
+    }
+
+    const Body *c = &bodies[s->central];
+    int k = 0;
+    for (int i = 0; i < n; i++) {
+        if (i == s->central) continue;
+        s->index[k] = i;
+        s->qx[k] = bodies[i].x - c->x;
+        s->qy[k] = bodies[i].y - c->y;
+        s->qz[k] = bodies[i].z - c->z;
+        s->vx[k] = bodies[i].vx - s->vcm[0];
+        s->vy[k] = bodies[i].vy - s->vcm[1];
+        s->vz[k] = bodies[i].vz - s->vcm[2];
+        s->m[k] = bodies[i].mass;
+        s->work[k] = bodies[i];
+        k++;
+    }
+
+    return 1;
+}
+
+void wh_step(WHState *s, double dt) {
+    double half = 0.5 * dt;
+    wh_kick(s, half);
+    wh_jump(s, half);
+    wh_kepler(s, dt);
+    wh_jump(s, half);
+    wh_kick(s, half);   /* Силы остаются актуальными для первого kick следующего шага */
+    s->t += dt;
+}
+
+void wh_to_bodies(const WHState *s, Body *bodies) {
+    double mqx = 0.0, mqy = 0.0, mqz = 0.0;
+    double mvx = 0.0, mvy = 0.0, mvz = 0.0;
+
+    #pragma omp parallel for schedule(static) reduction(+:mqx, mqy, mqz, mvx, mvy, mvz)
+    for (int i = 0; i < s->norb; i++) {
+        mqx += s->m[i] * s->qx[i];
+        mqy += s->m[i] * s->qy[i];
+        mqz += s->m[i] * s->qz[i];
+        mvx += s->m[i] * s->vx[i];
+        mvy += s->m[i] * s->vy[i];
+        mvz += s->m[i] * s->vz[i];
+    }
+
+    /* Положение центрального тела из условия неподвижности центра масс
+     * (в системе, движущейся со скоростью vcm) */
+    double cx = s->cm[0] + s->vcm[0] * s->t - mqx / s->m_total;
+    double cy = s->cm[1] + s->vcm[1] * s->t - mqy / s->m_total;
+    double cz = s->cm[2] + s->vcm[2] * s->t - mqz / s->m_total;
+
+    Body *c = &bodies[s->central];
+    c->x = cx;
+    c->y = cy;
+    c->z = cz;
+    c->vx = s->vcm[0] - mvx / s->m_central;
+    c->vy = s->vcm[1] - mvy / s->m_central;
+    c->vz = s->vcm[2] - mvz / s->m_central;
+    c->mass = s->m_central;
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < s->norb; i++) {
+        Body *b = &bodies[s->index[i]];
+        b->x = s->qx[i] + cx;
+        b->y = s->qy[i] + cy;
+        b->z = s->qz[i] + cz;
+        b->vx = s->vx[i] + s->vcm[0];
+        b->vy = s->vy[i] + s->vcm[1];
+        b->vz = s->vz[i] + s->vcm[2];
+        b->mass = s->m[i];
+    }
+}
+
+void wh_free(WHState *s) {
+    free(s->index);
+    free(s->qx); free(s->qy); free(s->qz);
+    free(s->vx); free(s->vy); free(s->vz);
+    free(s->m);
+    free(s->work);
+    free(s->fx); free(s->fy); free(s->fz);
+    free(s->fx_all); free(s->fy_all); free(s->fz_all);
+    memset(s, 0, sizeof(*s));
+}
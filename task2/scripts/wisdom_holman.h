@@ -0,0 +1,52 @@
+/* wisdom_holman.h
+ * Симплектический интегратор Уиздома-Холмана в демократических
+ * гелиоцентрических координатах для систем с доминирующей центральной массой.
+ *
+ * Шаг: kick(dt/2) - jump(dt/2) - kepler(dt) - jump(dt/2) - kick(dt/2), где
+ *   kepler - точное движение каждого тела по кеплеровской орбите вокруг центра,
+ *   kick   - взаимодействие остальных тел между собой (через compute_forces),
+ *   jump   - сдвиг позиций на импульс центрального тела.
+ */
+
+#ifndef WISDOM_HOLMAN_H
+#define WISDOM_HOLMAN_H
+
+#include "nbody.h"
+
+/* Состояние интегратора */
+typedef struct {
+    int n;                  /* Всего тел */
+    int central;            /* Индекс центрального (самого массивного) тела */
+    int norb;               /* Число остальных тел */
+    int *index;             /* Индексы остальных тел в исходном массиве */
+    double m_central;
+    double m_total;
+    double mu;              /* G * m_central */
+    double cm[3], vcm[3];   /* Положение и скорость центра масс в момент t = 0 */
+    double t;               /* Текущее время */
+
+    /* Остальные тела в SoA-раскладке */
+    double *qx, *qy, *qz;   /* Гелиоцентрические позиции */
+    double *vx, *vy, *vz;   /* Барицентрические скорости */
+    double *m;
+
+    /* Буферы для вычисления взаимодействий через compute_forces */
+    Body *work;
+    double *fx, *fy, *fz;
+    double *fx_all, *fy_all, *fz_all;
+    int nthreads;
+    int forces_valid;       /* Силы в fx.. соответствуют текущим позициям */
+} WHState;
+
+/* Переход в координаты интегратора; возвращает 0 при ошибке */
+int wh_init(WHState *s, const Body *bodies, int n, int nthreads);
+
+/* Один шаг интегратора длиной dt */
+void wh_step(WHState *s, double dt);
+
+/* Обратный переход в инерциальные координаты (порядок тел исходный) */
+void wh_to_bodies(const WHState *s, Body *bodies);
+
+void wh_free(WHState *s);
+
+#endif /* WISDOM_HOLMAN_H */
@@ -7,7 +7,7 @@ echo "Компиляция программ..."
 echo "======================================"
 
 # Компиляция пользовательской реализации
-gcc -pthread -O3 -o task3/scripts/task3_my_rwlock task3/scripts/task3_my_rwlock.c task3/scripts/my_rwlock.c -lm
+gcc -pthread -O3 -o task3/scripts/task3_my_rwlock task3/scripts/task3_my_rwlock.c task3/scripts/my_rwlock.c common/rapl.c common/mem_profile.c common/env_info.c -lm
 
 if [ $? -ne 0 ]; then
     echo "Ошибка компиляции my_rwlock!"
@@ -15,7 +15,7 @@ if [ $? -ne 0 ]; then
 fi
 
 # Компиляция библиотечной реализации
-gcc -pthread -O3 -o task3/scripts/task3_pthread_rwlock task3/scripts/task3_pthread_rwlock.c -lm
+gcc -pthread -O3 -o task3/scripts/task3_pthread_rwlock task3/scripts/task3_pthread_rwlock.c common/rapl.c common/mem_profile.c common/env_info.c -lm
 
 if [ $? -ne 0 ]; then
     echo "Ошибка компиляции pthread_rwlock!"
@@ -5,9 +5,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include <time.h>
 #include "my_rwlock.h"
+#include "../../common/rapl.h"
+#include "../../common/mem_profile.h"
+#include "../../common/env_info.h"
 
 /* Константы */
 const int MAX_KEY = 100000000;
@@ -177,9 +181,37 @@ void* Thread_work(void* rank) {
     return NULL;
 }
 
+/* Строка замера в task3/data/task3_performance.csv: работа, время, память по фазам, окружение */
+void Write_metrics(int inserts_in_main, double elapsed, const MemProfile *memory, const EnvInfo *env) {
+    const char *csv_dir = "./task3/data";
+    char fname[512];
+    env_ensure_dir(csv_dir);
+    snprintf(fname, sizeof(fname), "%s/task3_performance.csv", csv_dir);
+    FILE *f = env_csv_append(fname, "timestamp,implementation,nthreads,initial_keys,total_ops,search_percent,"
+                             "insert_percent,elapsed_time,member_ops,insert_ops,delete_ops,ops_per_sec,"
+                             MEM_CSV_HEADER "," ENV_CSV_HEADER);
+    if (!f) {
+        fprintf(stderr, "Cannot open %s for writing\n", fname);
+        return;
+    }
+    time_t now = time(NULL);
+    char timestamp[64];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+    fprintf(f, "%s,my_rwlock,%d,%d,%d,%.4f,%.4f,%.6f,%d,%d,%d,%.1f,",
+            timestamp, thread_count, inserts_in_main, total_ops, search_percent, insert_percent,
+            elapsed, member_count, insert_count, delete_count, elapsed > 0.0 ? total_ops / elapsed : 0.0);
+    mem_csv_write(f, memory);
+    fputc(',', f);
+    env_csv_write(f, env);
+    fputc('\n', f);
+    fclose(f);
+    printf("Metrics written to %s\n", fname);
+}
+
 /* Вывод справки */
 void Usage(char* prog_name) {
-    fprintf(stderr, "Usage: %s <thread_count>\n", prog_name);
+    fprintf(stderr, "Usage: %s <thread_count> [--rapl]\n", prog_name);
+    fprintf(stderr, "  --rapl  measure package and DRAM energy of the timed region (RAPL)\n");
     exit(0);
 }
 
@@ -206,8 +238,19 @@ int main(int argc, char* argv[]) {
     struct timespec start, finish;
     double elapsed;
     
-    if (argc != 2) Usage(argv[0]);
+    if (argc != 2 && !(argc == 3 && strcmp(argv[2], "--rapl") == 0)) Usage(argv[0]);
     thread_count = strtol(argv[1], NULL, 10);
+    int use_rapl = (argc == 3);
+    RaplCounters rapl;
+    if (use_rapl) rapl_open(&rapl);
+
+    EnvInfo env;
+    env_capture(&env);
+
+    /* Память по фазам: загрузка - ввод и начальные ключи списка */
+    MemProfile memory;
+    mem_profile_init(&memory);
+    mem_phase_begin(&memory, MEM_LOAD);
     
     Get_input(&inserts_in_main);
     
@@ -225,7 +268,11 @@ int main(int argc, char* argv[]) {
     pthread_mutex_init(&count_mutex, NULL);
     my_rwlock_init(&rwlock);
     
+    mem_phase_end(&memory, MEM_LOAD);
+    
     /* Замер времени */
+    mem_phase_begin(&memory, MEM_COMPUTE);
+    if (use_rapl) rapl_start(&rapl);
     clock_gettime(CLOCK_MONOTONIC, &start);
     
     for (i = 0; i < thread_count; i++)
@@ -235,9 +282,12 @@ int main(int argc, char* argv[]) {
         pthread_join(thread_handles[i], NULL);
     
     clock_gettime(CLOCK_MONOTONIC, &finish);
+    if (use_rapl) rapl_stop(&rapl);
+    mem_phase_end(&memory, MEM_COMPUTE);
     elapsed = (finish.tv_sec - start.tv_sec);
     elapsed += (finish.tv_nsec - start.tv_nsec) / 1000000000.0;
     
+    mem_phase_begin(&memory, MEM_OUTPUT);
     printf("\n=== Results (My RWLock) ===\n");
     printf("Elapsed time = %.6f seconds\n", elapsed);
     printf("Total ops = %d\n", total_ops);
@@ -245,6 +295,10 @@ int main(int argc, char* argv[]) {
     printf("Insert ops = %d\n", insert_count);
     printf("Delete ops = %d\n", delete_count);
     printf("===========================\n");
+    if (use_rapl) rapl_print(&rapl, total_ops, "op");
+    mem_phase_end(&memory, MEM_OUTPUT);
+    mem_profile_print(&memory);
+    Write_metrics(inserts_in_main, elapsed, &memory, &env);
     
     Free_list();
     my_rwlock_destroy(&rwlock);